@@ -7,9 +7,12 @@
 #include "websocket_protocol.h"
 #if CONFIG_CONNECTION_TYPE_NERTC
 #include "nertc_protocol.h"
+#include "downlink_packet.h"
 #endif
 #include "assets/lang_config.h"
 #include "mcp_server.h"
+#include "cjson_arena.h"
+#include "deferred_work.h"
 #include "assets.h"
 #include "settings.h"
 #ifdef HAVE_LVGL
@@ -82,13 +85,17 @@ Application::Application() {
     esp_timer_create_args_t llm_image_sent_timer_args = {
         .callback = [](void* arg) {
             Application* app = (Application*)arg;
-            app->Schedule([app]() {
+            // 定时器回调中不加锁投递；通道满时退回普通投递，单次定时器不能丢
+            auto timeout = [app]() {
                 if (app->device_state_ == kDeviceStateListening) {
                     ESP_LOGI(TAG, "No response after 'llm image sent', switching to idle state");
                     app->SetDeviceState(kDeviceStateIdle);
                     app->audio_service_.PlaySound(Lang::Sounds::OGG_FAILED);
                 }
-            });
+            };
+            if (!app->ScheduleFromISR(timeout)) {
+                app->Schedule(timeout);
+            }
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -160,10 +167,12 @@ void Application::CheckAssetsVersion() {
     display->SetEmotion("microchip_ai");
 }
 
-void Application::CheckNewVersion(Ota& ota) {
+// first_result 为启动时已在后台完成的首次检查结果，之后的重试照常在这里请求
+void Application::CheckNewVersion(Ota& ota, esp_err_t first_result) {
     const int MAX_RETRY = 10;
     int retry_count = 0;
     int retry_delay = 10; // 初始重试延迟为10秒
+    bool first_check = true;
 
     auto& board = Board::GetInstance();
     while (true) {
@@ -171,7 +180,8 @@ void Application::CheckNewVersion(Ota& ota) {
         auto display = board.GetDisplay();
         display->SetStatus(Lang::Strings::CHECKING_NEW_VERSION);
 
-        esp_err_t err = ota.CheckVersion();
+        esp_err_t err = first_check ? first_result : ota.CheckVersion();
+        first_check = false;
         if (err != ESP_OK) {
             retry_count++;
             if (retry_count >= MAX_RETRY) {
@@ -328,9 +338,10 @@ void Application::ToggleChatState() {
             SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
         });
     } else if (device_state_ == kDeviceStateSpeaking) {
+        // 只发送打断请求、不切换状态，可越过已排队的普通任务
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
-        });
+        }, kSchedulePriorityHigh);
     } else if (device_state_ == kDeviceStateListening) {
         Schedule([this]() {
             protocol_->CloseAudioChannel();
@@ -404,64 +415,119 @@ void Application::StopListening() {
 }
 
 void Application::Start() {
-    auto& board = Board::GetInstance();
-    auto display = board.GetDisplay();
-
-    auto& assets = Assets::GetInstance();
-    if (assets.partition_valid() && assets.checksum_valid()) {
-        assets.Apply();
-    }
-    
-    SetDeviceState(kDeviceStateStarting);
+    boot_timeline_.Start();
+    BootOrchestrator boot(boot_timeline_);
+    Ota ota;
+    esp_err_t ota_check_result = ESP_FAIL;
 
-    #ifdef HAVE_LVGL
-    auto lcd_display = dynamic_cast<LcdDisplay*>(display);
-    if (lcd_display != nullptr && !lcd_display->GetTextMode()) {
-        display->SetEmotion("error");
-    }
-    #endif
+    // 依赖关系按原串行顺序逐条核对：board → assets apply → starting → audio → network → assets version / ota → activation → protocol，
+    // 只有互不访问对方状态的步骤才并行。板级初始化（显示、codec 等）与资源分区校验互不依赖
+    int board_step = boot.AddStep("board", []() {
+        Board::GetInstance();
+    });
+    int assets_verify_step = boot.AddStep("assets_verify", []() {
+        Assets::GetInstance();
+    });
 
-    // Print board name/version info
-    display->SetChatMessage("system", SystemInfo::GetUserAgent().c_str());
+    // Apply 会设置主题、字体并调用 SetModelsList，必须在显示和音频开始使用这些资源之前完成
+    int assets_apply_step = boot.AddStep("assets_apply", []() {
+        auto& assets = Assets::GetInstance();
+        if (assets.partition_valid() && assets.checksum_valid()) {
+            assets.Apply();
+        }
+    }, {board_step, assets_verify_step});
 
-    /* Setup the audio service */
-    auto codec = board.GetAudioCodec();
-    audio_service_.Initialize(codec);
-    audio_service_.Start();
+    int starting_step = boot.AddStep("starting_state", [this]() {
+        auto display = Board::GetInstance().GetDisplay();
+        SetDeviceState(kDeviceStateStarting);
 
-    AudioServiceCallbacks callbacks;
-    callbacks.on_send_queue_available = [this]() {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
-    };
-    callbacks.on_wake_word_detected = [this](const std::string& wake_word) {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
-    };
-    callbacks.on_vad_change = [this](bool speaking) {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
-    };
-    audio_service_.SetCallbacks(callbacks);
+#ifdef HAVE_LVGL
+        auto lcd_display = dynamic_cast<LcdDisplay*>(display);
+        if (lcd_display != nullptr && !lcd_display->GetTextMode()) {
+            display->SetEmotion("error");
+        }
+#endif
 
-    // Start the main event loop task with priority 3
-    xTaskCreate([](void* arg) {
-        ((Application*)arg)->MainEventLoop();
-        vTaskDelete(NULL);
-    }, "main_event_loop", 2048 * 4, this, 3, &main_event_loop_task_handle_);
+        // Print board name/version info
+        display->SetChatMessage("system", SystemInfo::GetUserAgent().c_str());
+    }, {assets_apply_step});
+
+    int audio_step = boot.AddStep("audio", [this]() {
+        /* Setup the audio service */
+        auto codec = Board::GetInstance().GetAudioCodec();
+        audio_service_.Initialize(codec);
+        audio_service_.Start();
+
+        AudioServiceCallbacks callbacks;
+        callbacks.on_send_queue_available = [this]() {
+            xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
+        };
+        callbacks.on_wake_word_detected = [this](const std::string& wake_word) {
+            xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
+        };
+        callbacks.on_vad_change = [this](bool speaking) {
+            xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
+        };
+        audio_service_.SetCallbacks(callbacks);
+
+        // Start the main event loop task with priority 3
+        xTaskCreate([](void* arg) {
+            ((Application*)arg)->MainEventLoop();
+            vTaskDelete(NULL);
+        }, "main_event_loop", 2048 * 4, this, 3, &main_event_loop_task_handle_);
+
+        /* Start the clock timer to update the status bar */
+        esp_timer_start_periodic(clock_timer_handle_, 1000000);
+    }, {starting_step});
 
-    /* Start the clock timer to update the status bar */
-    esp_timer_start_periodic(clock_timer_handle_, 1000000);
+    // Add MCP common tools before initializing the protocol
+    // 只读取板级外设和资源包状态（set_theme 需要 Apply 之后的主题），可与音频、网络并行
+    int mcp_step = boot.AddStep("mcp_tools", []() {
+        auto& mcp_server = McpServer::GetInstance();
+        mcp_server.AddCommonTools();
+        mcp_server.AddUserOnlyTools();
+        mcp_server.PrintToolsMemory();
+    }, {assets_apply_step});
 
     /* Wait for the network to be ready */
-    board.StartNetwork();
-
-    // Update the status bar immediately to show the network state
-    display->UpdateStatusBar(true);
+    // 进入配网模式时会 PlaySound，需要音频服务已初始化
+    int network_step = boot.AddStep("network", []() {
+        auto& board = Board::GetInstance();
+        board.StartNetwork();
+        // Update the status bar immediately to show the network state
+        board.GetDisplay()->UpdateStatusBar(true);
+    }, {audio_step});
 
     // Check for new assets version
-    CheckAssetsVersion();
+    int assets_version_step = boot.AddStep("assets_version", [this]() {
+        CheckAssetsVersion();
+    }, {network_step});
+
+    // 版本检查的 HTTP 请求在后台与资源检查并行：CheckVersion 只写 mqtt/websocket 配置，不操作界面和音频；
+    // 激活/升级等界面流程等两者都完成后再进行
+    int ota_check_step = boot.AddStep("ota_check", [&ota, &ota_check_result]() {
+        ota_check_result = ota.CheckVersion();
+    }, {network_step});
 
     // Check for new firmware version or get the MQTT broker address
-    Ota ota;
-    CheckNewVersion(ota);
+    int activation_step = boot.AddStep("activation", [this, &ota, &ota_check_result]() {
+        CheckNewVersion(ota, ota_check_result);
+    }, {ota_check_step, assets_version_step});
+
+    boot.AddStep("protocol", [this, &ota]() {
+        StartProtocol(ota);
+    }, {activation_step, audio_step, mcp_step});
+
+    boot.Run();
+    boot_timeline_.Mark("ready");
+    boot_timeline_.Print(TAG, "Boot");
+}
+
+void Application::StartProtocol(Ota& ota) {
+    auto& board = Board::GetInstance();
+    auto display = board.GetDisplay();
+    auto codec = board.GetAudioCodec();
+
     int interrupteMode = ota.GetOtaAgentInterruptMode();
     agent_interrupt_mode_ = interrupteMode;
     aec_mode_ = interrupteMode == 0 ? kAecOff : kAecOnDeviceSide;
@@ -484,11 +550,6 @@ void Application::Start() {
     // Initialize the protocol
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
 
-    // Add MCP common tools before initializing the protocol
-    auto& mcp_server = McpServer::GetInstance();
-    mcp_server.AddCommonTools();
-    mcp_server.AddUserOnlyTools();
-
 #if CONFIG_CONNECTION_TYPE_NERTC
     protocol_ = std::make_unique<NeRtcProtocol>();
 #else
@@ -518,17 +579,16 @@ void Application::Start() {
             current_pedding_speaking_.load() ||
             (tail_deadline > 0 && now <= tail_deadline)) {
 
-            std::unique_ptr<AudioStreamPacket> reference_packet = nullptr;
 #if CONFIG_CONNECTION_TYPE_NERTC && CONFIG_USE_NERTC_SERVER_AEC
-            reference_packet = std::make_unique<AudioStreamPacket>();
-            reference_packet->payload = packet->payload;
-            reference_packet->timestamp = packet->timestamp;
-            reference_packet->sample_rate = protocol_->server_sample_rate();
-#endif
+            // 参考帧同步推送，直接借用下行包，之后再移交给解码队列
+            HandOffDownlinkPacket(std::move(packet), [this](const AudioStreamPacket& reference) {
+                protocol_->SendAecReferenceAudio(reference);
+            }, [this](std::unique_ptr<AudioStreamPacket> decode_packet) {
+                audio_service_.PushPacketToDecodeQueue(std::move(decode_packet));
+            });
+#else
             audio_service_.PushPacketToDecodeQueue(std::move(packet));
-            if (reference_packet) {
-                protocol_->SendAecReferenceAudio(std::move(reference_packet));
-            }
+#endif
         }
     });
     protocol_->OnAudioChannelOpened([this, codec, &board]() {
@@ -541,210 +601,309 @@ void Application::Start() {
     protocol_->OnAudioChannelClosed([this, &board]() {
         board.SetPowerSaveMode(true);
         Schedule([this]() {
+#if CONFIG_USE_ADAPTIVE_OPUS_FRAME_DURATION
+            audio_service_.ResetUplinkFrameDuration();
+#endif
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
         });
     });
     protocol_->OnIncomingJson([this](const cJSON* root) {
-        // Parse JSON data
-        auto type = cJSON_GetObjectItem(root, "type");
-        if (strcmp(type->valuestring, "tts") == 0) {
-            auto state = cJSON_GetObjectItem(root, "state");
-            if (strcmp(state->valuestring, "start") == 0) {
-                // Check if there's an active timer waiting for response after "llm image sent"
-                bool has_active_timer = false;
-            if (llm_image_sent_timer_handle_ != nullptr) {
-                int64_t timer_time = esp_timer_get_time();
-                if (esp_timer_is_active(llm_image_sent_timer_handle_)) {
-                    has_active_timer = true;
-                    esp_timer_stop(llm_image_sent_timer_handle_);
-                    ESP_LOGI(TAG, "Received TTS start after 'llm image sent', switching to speaking state");
-                }
-            }
+        IncomingMessage message;
+        message.received_time_us = esp_timer_get_time();
+        message.json_parses = 1;
+        if (!Protocol::ParseIncomingMessage(root, message)) {
+            ESP_LOGW(TAG, "Invalid message: missing type");
+            return;
+        }
+        HandleIncomingMessage(message);
+    });
+    protocol_->OnIncomingMessage([this](const IncomingMessage& message) {
+        HandleIncomingMessage(message);
+    });
+    bool protocol_started = protocol_->Start();
 
-            // 开始新的 TTS，清空旧的尾巴窗口
-            tts_tail_deadline_us_.store(0);
+    SystemInfo::PrintHeapStats();
+    SetDeviceState(kDeviceStateIdle);
 
-            current_pedding_speaking_.store(true);
-                if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening){
-                    audio_service_.ResetDecoder(); //这里涉及到任务投递执行，所有resetdecoder需要提前做。不然前面一两帧音频都丢失
-                }
-                Schedule([this, has_active_timer]() {
-                    aborted_ = false;
-                    // If timer was active (waiting for response after "llm image sent") and we're in listening state, switch to speaking
-                    if (has_active_timer && device_state_ == kDeviceStateListening) {
-                        SetDeviceState(kDeviceStateSpeaking);
-                    } else if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
-                        SetDeviceState(kDeviceStateSpeaking);
-                    }
-                });
-            } else if (strcmp(state->valuestring, "stop") == 0) {
-                // 设置 TTS 尾巴接收窗口400ms
-                int64_t now = esp_timer_get_time();
-                tts_tail_deadline_us_.store(now + 400 * 1000);
+    has_server_time_ = ota.HasServerTime();
+    if (protocol_started) {
+        ESP_LOGI(TAG, "Protocol started successfully aec_mode = %d", aec_mode_);
+        std::string message = std::string(Lang::Strings::VERSION) + ota.GetCurrentVersion();
+        display->ShowNotification(message.c_str());
+        display->SetChatMessage("system", "");
+        // Play the success sound to indicate the device is ready
+        audio_service_.PlaySound(Lang::Sounds::OGG_SUCCESS);
+    }
+}
 
-                Schedule([this]() {
-                    if (device_state_ == kDeviceStateSpeaking) {
-                        if (listening_mode_ == kListeningModeManualStop) {
-                            SetDeviceState(kDeviceStateIdle);
-                        } else {
-                            // SetDeviceState(kDeviceStateListening);
-                            bool wait = false;
-                            if (!aborted_) {
-                                wait = true;
-                                audio_service_.WaitForPlayCompletion(200);
-                            }
-                            if (device_state_ == kDeviceStateSpeaking && (!wait || (wait && !aborted_))) {
-                                SetDeviceState(kDeviceStateListening);
-                            }
+void Application::HandleIncomingMessage(const IncomingMessage& message) {
+    using Handler = void (Application::*)(const IncomingMessage&);
+    // 顺序与 IncomingMessageType 保持一致
+    static const Handler handlers[kIncomingMessageTypeCount] = {
+        nullptr,                        // kIncomingMessageUnknown
+        &Application::OnTtsMessage,     // kIncomingMessageTts
+        &Application::OnSttMessage,     // kIncomingMessageStt
+        &Application::OnLlmMessage,     // kIncomingMessageLlm
+        &Application::OnMcpMessage,     // kIncomingMessageMcp
+        &Application::OnSystemMessage,  // kIncomingMessageSystem
+        &Application::OnAlertMessage,   // kIncomingMessageAlert
+#if CONFIG_RECEIVE_CUSTOM_MESSAGE
+        &Application::OnCustomMessage,  // kIncomingMessageCustom
+#else
+        nullptr,                        // kIncomingMessageCustom
+#endif
+    };
 
-                        }
-                    }
-                });
-            } else if (strcmp(state->valuestring, "sentence_start") == 0) {
-                auto text = cJSON_GetObjectItem(root, "text");
-                if (cJSON_IsString(text)) {
-                    ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    
-                    // 检查是否有等待响应的定时器
-                    bool has_active_timer = false;
-                    if (llm_image_sent_timer_handle_ != nullptr) {
-                        if (esp_timer_is_active(llm_image_sent_timer_handle_)) {
-                            has_active_timer = true;
-                            esp_timer_stop(llm_image_sent_timer_handle_);
-                            ESP_LOGI(TAG, "Received sentence_start after 'llm image sent', will switch to speaking when TTS starts");
-                        }
-                    }
-                    
-                    Schedule([this, message = std::string(text->valuestring), has_active_timer]() {
-                        auto display = Board::GetInstance().GetDisplay();
-                        if (display != nullptr) {
-                            display->SetChatMessage("assistant", message.c_str());
-                        }
-                    });
-                }
+    auto handler = handlers[message.type];
+    if (handler == nullptr) {
+        ESP_LOGW(TAG, "Unknown message type: %s", message.type_name);
+        return;
+    }
+    (this->*handler)(message);
+
+    // 统计：消息数、解析次数、从收到到处理完成的耗时
+    uint32_t latency_us = esp_timer_get_time() - message.received_time_us;
+    std::lock_guard<std::mutex> lock(message_statistics_mutex_);
+    auto& stats = message_statistics_;
+    stats.json_parse_count += message.json_parses;
+    stats.count[message.type]++;
+    stats.total_latency_us[message.type] += latency_us;
+    if (latency_us > stats.max_latency_us[message.type]) {
+        stats.max_latency_us[message.type] = latency_us;
+    }
+}
+
+void Application::OnTtsMessage(const IncomingMessage& message) {
+    if (message.state == nullptr) {
+        return;
+    }
+    if (strcmp(message.state, "start") == 0) {
+        // Check if there's an active timer waiting for response after "llm image sent"
+        bool has_active_timer = false;
+        if (llm_image_sent_timer_handle_ != nullptr) {
+            if (esp_timer_is_active(llm_image_sent_timer_handle_)) {
+                has_active_timer = true;
+                esp_timer_stop(llm_image_sent_timer_handle_);
+                ESP_LOGI(TAG, "Received TTS start after 'llm image sent', switching to speaking state");
+            }
+        }
+
+        // 开始新的 TTS，清空旧的尾巴窗口
+        tts_tail_deadline_us_.store(0);
+
+        current_pedding_speaking_.store(true);
+        if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening){
+            audio_service_.ResetDecoder(); //这里涉及到任务投递执行，所有resetdecoder需要提前做。不然前面一两帧音频都丢失
+        }
+        int64_t received_us = esp_timer_get_time();
+        Schedule([this, has_active_timer, received_us]() {
+            // 收到本条 tts start 之后已经打断过时保留打断标记
+            if (last_abort_us_ < received_us) {
+                aborted_ = false;
             }
-        } else if (strcmp(type->valuestring, "stt") == 0) {
-            auto text = cJSON_GetObjectItem(root, "text");
-            if (cJSON_IsString(text)) {
-                std::string message = text->valuestring;
-                ESP_LOGI(TAG, ">> %s", message.c_str());
-                
-                // Check if this is "llm image sent" message and device is in listening state
-                if (message == "llm image sent" && device_state_ == kDeviceStateListening) {
-                    ESP_LOGI(TAG, "Received 'llm image sent' in listening state, starting 15s timer");
-                    if (llm_image_sent_timer_handle_ != nullptr) {
-                        // Stop any existing timer first
-                        esp_timer_stop(llm_image_sent_timer_handle_);
-                        // Start 15 second timer
-                        esp_timer_start_once(llm_image_sent_timer_handle_, 15 * 1000 * 1000);
+            // If timer was active (waiting for response after "llm image sent") and we're in listening state, switch to speaking
+            if (has_active_timer && device_state_ == kDeviceStateListening) {
+                SetDeviceState(kDeviceStateSpeaking);
+            } else if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
+                SetDeviceState(kDeviceStateSpeaking);
+            }
+        });
+    } else if (strcmp(message.state, "stop") == 0) {
+        // 设置 TTS 尾巴接收窗口400ms
+        int64_t now = esp_timer_get_time();
+        tts_tail_deadline_us_.store(now + 400 * 1000);
+
+        Schedule([this]() {
+            if (device_state_ == kDeviceStateSpeaking) {
+                if (listening_mode_ == kListeningModeManualStop) {
+                    SetDeviceState(kDeviceStateIdle);
+                } else {
+                    // SetDeviceState(kDeviceStateListening);
+                    bool wait = false;
+                    if (!aborted_) {
+                        wait = true;
+                        audio_service_.WaitForPlayCompletion(200);
                     }
-                }
-                
-                Schedule([this, message]() {
-                    auto display = Board::GetInstance().GetDisplay();
-                    if (display != nullptr) {
-                        display->SetChatMessage("user", message.c_str());
+                    if (device_state_ == kDeviceStateSpeaking && (!wait || (wait && !aborted_))) {
+                        SetDeviceState(kDeviceStateListening);
                     }
-                });
+
+                }
             }
-        } else if (strcmp(type->valuestring, "llm") == 0) {
-            // Check if there's an active timer waiting for response after "llm image sent"
-            bool has_active_timer = false;
+        });
+    } else if (strcmp(message.state, "sentence_start") == 0) {
+        if (message.text != nullptr) {
+            ESP_LOGI(TAG, "<< %s", message.text);
+
+            // 检查是否有等待响应的定时器
             if (llm_image_sent_timer_handle_ != nullptr) {
                 if (esp_timer_is_active(llm_image_sent_timer_handle_)) {
-                    has_active_timer = true;
                     esp_timer_stop(llm_image_sent_timer_handle_);
-                    ESP_LOGI(TAG, "Received LLM message after 'llm image sent', switching to speaking state");
+                    ESP_LOGI(TAG, "Received sentence_start after 'llm image sent', will switch to speaking when TTS starts");
                 }
             }
-            auto emotion = cJSON_GetObjectItem(root, "emotion");
-            if (cJSON_IsString(emotion)) {
-                Schedule([this, emotion_str = std::string(emotion->valuestring), has_active_timer]() {
-                    auto display = Board::GetInstance().GetDisplay();
-                    if (display != nullptr) {
-                        display->SetEmotion(emotion_str.c_str());
-                    }
-                    // If timer was active and we're still in listening state, switch to speaking
-                    if (has_active_timer && device_state_ == kDeviceStateListening) {
-                        SetDeviceState(kDeviceStateSpeaking);
-                    }
-                });
-            }
-        } else if (strcmp(type->valuestring, "mcp") == 0) {
-            auto payload = cJSON_GetObjectItem(root, "payload");
-            if (cJSON_IsObject(payload)) {
-                McpServer::GetInstance().ParseMessage(payload);
-            }
-        } else if (strcmp(type->valuestring, "system") == 0) {
-            auto command = cJSON_GetObjectItem(root, "command");
-            if (cJSON_IsString(command)) {
-                ESP_LOGI(TAG, "System command: %s", command->valuestring);
-                if (strcmp(command->valuestring, "reboot") == 0) {
-                    // Do a reboot if user requests a OTA update
-                    Schedule([this]() {
-                        Reboot();
-                    });
-                } else if (strcmp(command->valuestring, "sleep") == 0) {
-                    Schedule([this]() {
-                        ai_sleep_ = true;
-                    });
-                } else {
-                    ESP_LOGW(TAG, "Unknown system command: %s", command->valuestring);
+
+            Schedule([this, text = std::string(message.text)]() {
+                auto display = Board::GetInstance().GetDisplay();
+                if (display != nullptr) {
+                    display->SetChatMessage("assistant", text.c_str());
                 }
+            });
+        }
+    }
+}
+
+void Application::OnSttMessage(const IncomingMessage& message) {
+    if (message.text == nullptr) {
+        return;
+    }
+    std::string text = message.text;
+    ESP_LOGI(TAG, ">> %s", text.c_str());
+
+    // Check if this is "llm image sent" message and device is in listening state
+    if (text == "llm image sent" && device_state_ == kDeviceStateListening) {
+        ESP_LOGI(TAG, "Received 'llm image sent' in listening state, starting 15s timer");
+        if (llm_image_sent_timer_handle_ != nullptr) {
+            // Stop any existing timer first
+            esp_timer_stop(llm_image_sent_timer_handle_);
+            // Start 15 second timer
+            esp_timer_start_once(llm_image_sent_timer_handle_, 15 * 1000 * 1000);
+        }
+    }
+
+    Schedule([this, text]() {
+        auto display = Board::GetInstance().GetDisplay();
+        if (display != nullptr) {
+            display->SetChatMessage("user", text.c_str());
+        }
+    });
+}
+
+void Application::OnLlmMessage(const IncomingMessage& message) {
+    // Check if there's an active timer waiting for response after "llm image sent"
+    bool has_active_timer = false;
+    if (llm_image_sent_timer_handle_ != nullptr) {
+        if (esp_timer_is_active(llm_image_sent_timer_handle_)) {
+            has_active_timer = true;
+            esp_timer_stop(llm_image_sent_timer_handle_);
+            ESP_LOGI(TAG, "Received LLM message after 'llm image sent', switching to speaking state");
+        }
+    }
+    if (message.emotion != nullptr) {
+        Schedule([this, emotion_str = std::string(message.emotion), has_active_timer]() {
+            auto display = Board::GetInstance().GetDisplay();
+            if (display != nullptr) {
+                display->SetEmotion(emotion_str.c_str());
             }
-        } else if (strcmp(type->valuestring, "alert") == 0) {
-            auto status = cJSON_GetObjectItem(root, "status");
-            auto message = cJSON_GetObjectItem(root, "message");
-            auto emotion = cJSON_GetObjectItem(root, "emotion");
-            if (cJSON_IsString(status) && cJSON_IsString(message) && cJSON_IsString(emotion)) {
-                Alert(status->valuestring, message->valuestring, emotion->valuestring, Lang::Sounds::OGG_VIBRATION);
-            } else {
-                ESP_LOGW(TAG, "Alert command requires status, message and emotion");
+            // If timer was active and we're still in listening state, switch to speaking
+            if (has_active_timer && device_state_ == kDeviceStateListening) {
+                SetDeviceState(kDeviceStateSpeaking);
             }
+        });
+    }
+}
+
+void Application::OnMcpMessage(const IncomingMessage& message) {
+    if (message.payload != nullptr) {
+        McpServer::GetInstance().ParseMessage(message.payload);
+    }
+}
+
+void Application::OnSystemMessage(const IncomingMessage& message) {
+    if (message.command == nullptr) {
+        return;
+    }
+    ESP_LOGI(TAG, "System command: %s", message.command);
+    if (strcmp(message.command, "reboot") == 0) {
+        // Do a reboot if user requests a OTA update
+        Schedule([this]() {
+            Reboot();
+        });
+    } else if (strcmp(message.command, "sleep") == 0) {
+        Schedule([this]() {
+            ai_sleep_ = true;
+        });
+    } else {
+        ESP_LOGW(TAG, "Unknown system command: %s", message.command);
+    }
+}
+
+void Application::OnAlertMessage(const IncomingMessage& message) {
+    if (message.status != nullptr && message.message != nullptr && message.emotion != nullptr) {
+        Alert(message.status, message.message, message.emotion, Lang::Sounds::OGG_VIBRATION);
+    } else {
+        ESP_LOGW(TAG, "Alert command requires status, message and emotion");
+    }
+}
+
 #if CONFIG_RECEIVE_CUSTOM_MESSAGE
-        } else if (strcmp(type->valuestring, "custom") == 0) {
-            auto payload = cJSON_GetObjectItem(root, "payload");
-            ESP_LOGI(TAG, "Received custom message: %s", cJSON_PrintUnformatted(root));
-            if (cJSON_IsObject(payload)) {
-                Schedule([this, payload_str = std::string(cJSON_PrintUnformatted(payload))]() {
-                    auto display = Board::GetInstance().GetDisplay();
-                    if (display != nullptr) {
-                        display->SetChatMessage("system", payload_str.c_str());
-                    }
-                });
-            } else {
-                ESP_LOGW(TAG, "Invalid custom message format: missing payload");
-            }
-#endif
-        } else {
-            ESP_LOGW(TAG, "Unknown message type: %s", type->valuestring);
+void Application::OnCustomMessage(const IncomingMessage& message) {
+    if (message.payload == nullptr) {
+        ESP_LOGW(TAG, "Invalid custom message format: missing payload");
+        return;
+    }
+    char* payload = cJSON_PrintUnformatted(message.payload);
+    std::string payload_str = payload != nullptr ? payload : "";
+    cJSON_free(payload);
+    ESP_LOGI(TAG, "Received custom message: %s", payload_str.c_str());
+    Schedule([this, payload_str]() {
+        auto display = Board::GetInstance().GetDisplay();
+        if (display != nullptr) {
+            display->SetChatMessage("system", payload_str.c_str());
         }
     });
-    bool protocol_started = protocol_->Start();
+}
+#endif
 
-    SystemInfo::PrintHeapStats();
-    SetDeviceState(kDeviceStateIdle);
+void Application::PrintMessageStatistics() {
+    static const char* const names[kIncomingMessageTypeCount] = {
+        "unknown", "tts", "stt", "llm", "mcp", "system", "alert", "custom"
+    };
+    IncomingMessageStatistics stats;
+    {
+        std::lock_guard<std::mutex> lock(message_statistics_mutex_);
+        stats = message_statistics_;
+    }
+    ESP_LOGI(TAG, "Message stats: json parses %lu", stats.json_parse_count);
+    for (int i = 1; i < kIncomingMessageTypeCount; i++) {
+        if (stats.count[i] == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Message stats: %s count %lu avg %lu us max %lu us", names[i], stats.count[i],
+            (uint32_t)(stats.total_latency_us[i] / stats.count[i]), stats.max_latency_us[i]);
+    }
+}
 
-    has_server_time_ = ota.HasServerTime();
-    if (protocol_started) {
-        ESP_LOGI(TAG, "Protocol started successfully aec_mode = %d", aec_mode_);
-        std::string message = std::string(Lang::Strings::VERSION) + ota.GetCurrentVersion();
-        display->ShowNotification(message.c_str());
-        display->SetChatMessage("system", "");
-        // Play the success sound to indicate the device is ready
-        audio_service_.PlaySound(Lang::Sounds::OGG_SUCCESS);
+void Application::NotifyScheduleFromISR() {
+    if (xPortInIsrContext()) {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        xEventGroupSetBitsFromISR(event_group_, MAIN_EVENT_SCHEDULE, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    } else {
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
     }
 }
 
-// Add a async task to MainLoop
-void Application::Schedule(std::function<void()> callback) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        main_tasks_.push_back(std::move(callback));
+void Application::RunScheduledTasks() {
+    if (schedule_lanes_.RunPending()) {
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+    }
+}
+
+void Application::PrintScheduleStatistics() {
+    static const char* const names[kSchedulePriorityCount] = { "normal", "high" };
+    for (int i = 0; i < kSchedulePriorityCount; i++) {
+        auto& stats = schedule_lanes_.statistics((SchedulePriority)i);
+        if (stats.count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Schedule stats: %s count %lu max depth %lu avg wait %lu us max wait %lu us", names[i],
+            stats.count, stats.max_depth, (uint32_t)(stats.total_wait_us / stats.count), stats.max_wait_us);
     }
-    xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+    ESP_LOGI(TAG, "Schedule stats: heap captures %lu overflows %lu isr drops %lu",
+        schedule_lanes_.heap_fallbacks(), schedule_lanes_.overflows(), schedule_lanes_.isr_drops());
 }
 
 // The Main Event Loop controls the chat state and websocket connection
@@ -774,6 +933,9 @@ void Application::MainEventLoop() {
                 if (protocol_ && !protocol_->SendAudio(std::move(packet))) {
                     break;
                 }
+                if (wake_uplink_step_ >= 0) {
+                    OnWakeUplinkSent();
+                }
             }
         }
 
@@ -789,24 +951,40 @@ void Application::MainEventLoop() {
         }
 
         if (bits & MAIN_EVENT_SCHEDULE) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto tasks = std::move(main_tasks_);
-            lock.unlock();
-            for (auto& task : tasks) {
-                task();
-            }
+            RunScheduledTasks();
         }
 
         if (bits & MAIN_EVENT_CLOCK_TICK) {
             clock_ticks_++;
             auto display = Board::GetInstance().GetDisplay();
             display->UpdateStatusBar();
+
+#if CONFIG_USE_ADAPTIVE_OPUS_FRAME_DURATION
+            // 每 2 秒按链路质量调整上行帧长；下行丢包主要在播报时才有样本，所以聆听和播报时都采样
+            if (clock_ticks_ % 2 == 0 && protocol_ && protocol_->IsAudioChannelOpened() &&
+                (device_state_ == kDeviceStateListening || device_state_ == kDeviceStateSpeaking)) {
+                LinkStatistics link;
+                if (protocol_->GetLinkStatistics(link)) {
+                    audio_service_.AdaptUplinkFrameDuration(link);
+                }
+            }
+#endif
         
             // Print the debug info every 10 seconds
             if (clock_ticks_ % 10 == 0) {
                 // SystemInfo::PrintTaskCpuUsage(pdMS_TO_TICKS(1000));
                 // SystemInfo::PrintTaskList();
                 SystemInfo::PrintHeapStats();
+                audio_service_.PrintDebugStatistics();
+                PrintMessageStatistics();
+                PrintScheduleStatistics();
+                DeviceStateEventManager::GetInstance().PrintStatistics();
+                DeferredWork::PrintStatistics();
+                CJsonArena::PrintStatistics();
+                McpServer::GetInstance().PrintStatistics();
+#if CONFIG_CONNECTION_TYPE_NERTC
+                NeRtcExternalNetwork::PrintStatistics();
+#endif
             }
 
             if (ai_sleep_ && (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening)) {
@@ -828,14 +1006,18 @@ void Application::OnWakeWordDetected() {
     }
 
     if (device_state_ == kDeviceStateIdle) {
+        wake_timeline_.Start();
+        wake_uplink_step_ = -1;
 #ifdef CONFIG_USE_MUSIC_PLAYER
         MusicPlayer::GetInstance().InterruptPlay();
 #endif
+        // 唤醒词 Opus 编码在独立任务中进行，与下面建立音频通道并行
+        int step = wake_timeline_.Begin("encode_wake_word");
         audio_service_.EncodeWakeWord();
+        wake_timeline_.End(step);
 
         if (!protocol_->IsAudioChannelOpened()) {
-            SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OpenAudioChannel(std::string(NERTC_AI_START_TOPIC))) {
+            if (!OpenAudioChannelForWake()) {
                 // 连接失败，设置表情为error
                 auto display = Board::GetInstance().GetDisplay();
                 if (display != nullptr) {
@@ -851,17 +1033,24 @@ void Application::OnWakeWordDetected() {
         ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
 #if CONFIG_SEND_WAKE_WORD_DATA
         // Encode and send the wake word data to the server
+        step = wake_timeline_.Begin("send_wake_word_audio");
         while (auto packet = audio_service_.PopWakeWordPacket()) {
             protocol_->SendAudio(std::move(packet));
         }
+        wake_timeline_.End(step);
         // Set the chat state to wake word detected
         protocol_->SendWakeWordDetected(wake_word);
+        step = wake_timeline_.Begin("start_listening");
         SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+        wake_timeline_.End(step);
 #else
+        step = wake_timeline_.Begin("start_listening");
         SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+        wake_timeline_.End(step);
         // Play the pop up sound to indicate the wake word is detected
         audio_service_.PlaySound(Lang::Sounds::OGG_POPUP);
 #endif
+        wake_uplink_step_ = wake_timeline_.Begin("first_uplink");
     } else if (device_state_ == kDeviceStateSpeaking) {
         AbortSpeaking(kAbortReasonWakeWordDetected);
     } else if (device_state_ == kDeviceStateActivating) {
@@ -869,9 +1058,54 @@ void Application::OnWakeWordDetected() {
     }
 }
 
+// 建连放到临时任务中，主循环同时切换到 connecting 状态（刷新界面）并准备音频处理器，两路在此汇合
+bool Application::OpenAudioChannelForWake() {
+    xEventGroupClearBits(event_group_, MAIN_EVENT_WAKE_CHANNEL_OPENED);
+    wake_channel_opened_ = false;
+    BaseType_t created = xTaskCreate([](void* arg) {
+        auto app = static_cast<Application*>(arg);
+        int step = app->wake_timeline_.Begin("open_audio_channel");
+        app->wake_channel_opened_ = app->protocol_->OpenAudioChannel(std::string(NERTC_AI_START_TOPIC));
+        app->wake_timeline_.End(step);
+        xEventGroupSetBits(app->event_group_, MAIN_EVENT_WAKE_CHANNEL_OPENED);
+        vTaskDelete(NULL);
+    }, "wake_open", 4096 * 2, this, 3, nullptr);
+    if (created != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create wake_open task, opening audio channel serially");
+        SetDeviceState(kDeviceStateConnecting);
+        return protocol_->OpenAudioChannel(std::string(NERTC_AI_START_TOPIC));
+    }
+
+    int step = wake_timeline_.Begin("connecting_state");
+    SetDeviceState(kDeviceStateConnecting);
+    wake_timeline_.End(step);
+    step = wake_timeline_.Begin("prepare_audio");
+    audio_service_.PrepareVoiceProcessing();
+    wake_timeline_.End(step);
+
+    xEventGroupWaitBits(event_group_, MAIN_EVENT_WAKE_CHANNEL_OPENED, pdTRUE, pdTRUE, portMAX_DELAY);
+    wake_timeline_.Mark("channel_joined");
+    return wake_channel_opened_;
+}
+
+void Application::OnWakeUplinkSent() {
+    wake_timeline_.End(wake_uplink_step_);
+    wake_uplink_step_ = -1;
+    uint32_t latency_us = (uint32_t)wake_timeline_.elapsed_us();
+    wake_count_++;
+    wake_total_latency_us_ += latency_us;
+    if (latency_us > wake_max_latency_us_) {
+        wake_max_latency_us_ = latency_us;
+    }
+    wake_timeline_.Print(TAG, "Wake to first uplink");
+    ESP_LOGI(TAG, "Wake to first uplink: %lu ms, avg %lu ms max %lu ms over %lu wakes", latency_us / 1000,
+        (uint32_t)(wake_total_latency_us_ / wake_count_ / 1000), wake_max_latency_us_ / 1000, wake_count_);
+}
+
 void Application::AbortSpeaking(AbortReason reason) {
     ESP_LOGI(TAG, "Abort speaking");
     aborted_ = true;
+    last_abort_us_ = esp_timer_get_time();
     if (protocol_) {
         protocol_->SendAbortSpeaking(reason);
     }
@@ -892,6 +1126,10 @@ void Application::SetDeviceState(DeviceState state) {
     auto previous_state = device_state_;
     device_state_ = state;
     ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[device_state_]);
+    if (state != kDeviceStateListening) {
+        // 没等到上行包就离开了聆听状态，本次唤醒不计入统计
+        wake_uplink_step_ = -1;
+    }
 
     // Send the state change event
     DeviceStateEventManager::GetInstance().PostStateChangeEvent(previous_state, state);
@@ -1087,17 +1325,18 @@ bool Application::CanEnterSleepMode() {
     return true;
 }
 
-void Application::SendMcpMessage(const std::string& payload) {
+void Application::SendMcpMessage(std::string payload) {
     if (protocol_ == nullptr) {
         return;
     }
 
     // Make sure you are using main thread to send MCP message
+    // payload 一路移交，图片结果不会在这里再拷贝一份
     if (xTaskGetCurrentTaskHandle() == main_event_loop_task_handle_) {
-        protocol_->SendMcpMessage(payload);
+        protocol_->SendMcpMessage(std::move(payload));
     } else {
-        Schedule([this, payload = std::move(payload)]() {
-            protocol_->SendMcpMessage(payload);
+        Schedule([this, payload = std::move(payload)]() mutable {
+            protocol_->SendMcpMessage(std::move(payload));
         });
     }
 }
@@ -10,8 +10,12 @@
 #include <mutex>
 #include <deque>
 #include <memory>
+#include <atomic>
 
 #include "protocol.h"
+#include "schedule_queue.h"
+#include "timeline.h"
+#include "boot_orchestrator.h"
 #include "ota.h"
 #include "audio_service.h"
 #include "device_state_event.h"
@@ -25,6 +29,7 @@
 #define MAIN_EVENT_ERROR (1 << 4)
 #define MAIN_EVENT_CHECK_NEW_VERSION_DONE (1 << 5)
 #define MAIN_EVENT_CLOCK_TICK (1 << 6)
+#define MAIN_EVENT_WAKE_CHANNEL_OPENED (1 << 7)
 
 
 enum AecMode {
@@ -34,6 +39,13 @@ enum AecMode {
     kAecOnNertc,
 };
 
+struct IncomingMessageStatistics {
+    uint32_t json_parse_count = 0;
+    uint32_t count[kIncomingMessageTypeCount] = {};
+    uint64_t total_latency_us[kIncomingMessageTypeCount] = {};
+    uint32_t max_latency_us[kIncomingMessageTypeCount] = {};
+};
+
 class Application {
 public:
     static Application& GetInstance() {
@@ -48,7 +60,24 @@ public:
     void MainEventLoop();
     DeviceState GetDeviceState() const { return device_state_; }
     bool IsVoiceDetected() const { return audio_service_.IsVoiceDetected(); }
-    void Schedule(std::function<void()> callback);
+    // Add a async task to MainLoop
+    // 同一通道内按投递顺序执行：状态切换（tts start/stop、CloseAudioChannel 等）都放在普通通道
+    template <typename F>
+    void Schedule(F&& callback, SchedulePriority priority = kSchedulePriorityNormal) {
+        schedule_lanes_.Push(ScheduledTask(std::forward<F>(callback)), priority);
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+    }
+    // 可在中断和 esp_timer 回调中调用：闭包必须能放进内联缓冲，不加锁、不分配内存，通道满时丢弃并返回 false
+    template <typename F>
+    bool ScheduleFromISR(F&& callback, SchedulePriority priority = kSchedulePriorityNormal) {
+        static_assert(ScheduledTask::fits_inline<std::decay_t<F>>, "ISR task capture is too large");
+        ScheduledTask task(std::forward<F>(callback));
+        if (!schedule_lanes_.PushFromISR(task, priority)) {
+            return false;
+        }
+        NotifyScheduleFromISR();
+        return true;
+    }
     void SetDeviceState(DeviceState state);
     void Alert(const char* status, const char* message, const char* emotion = "", const std::string_view& sound = "");
     void DismissAlert();
@@ -60,7 +89,7 @@ public:
     void WakeWordInvoke(const std::string& wake_word);
     bool UpgradeFirmware(Ota& ota, const std::string& url = "");
     bool CanEnterSleepMode();
-    void SendMcpMessage(const std::string& payload);
+    void SendMcpMessage(std::string payload);
     void SetAecMode(AecMode mode);
     AecMode GetAecMode() const { return aec_mode_; }
     int GetAgentInterruptMode() const { return agent_interrupt_mode_; }
@@ -68,6 +97,7 @@ public:
     AudioService& GetAudioService() { return audio_service_; }
     void Close();
     void SetMicDisabledForNextListening(bool disabled) { mic_disabled_for_next_listening_ = disabled; }
+    std::string GetBootTimelineJson() const { return boot_timeline_.ToJson(); }
 
 #if CONFIG_CONNECTION_TYPE_NERTC
     // photo explain
@@ -80,8 +110,7 @@ private:
     Application();
     ~Application();
 
-    std::mutex mutex_;
-    std::deque<std::function<void()>> main_tasks_;
+    ScheduleLanes<32> schedule_lanes_;
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
@@ -98,18 +127,51 @@ private:
 
     bool has_server_time_ = false;
     bool aborted_ = false;
+    int64_t last_abort_us_ = 0;    // 最近一次 AbortSpeaking 的时间，打断走高优先级通道，可能先于更早收到的 tts start 执行
     int clock_ticks_ = 0;
     TaskHandle_t check_new_version_task_handle_ = nullptr;
     TaskHandle_t main_event_loop_task_handle_ = nullptr;
 
     bool ai_sleep_ = false;
     bool mic_disabled_for_next_listening_ = false;
+    // 协议任务更新、主循环打印，读写都在 message_statistics_mutex_ 下进行
+    IncomingMessageStatistics message_statistics_;
+    std::mutex message_statistics_mutex_;
+
+    BootTimeline boot_timeline_;
+
+    // 唤醒到首个上行音频包的时间线，wake_uplink_step_ >= 0 表示正在等待首个上行包
+    Timeline<12> wake_timeline_;
+    int wake_uplink_step_ = -1;
+    bool wake_channel_opened_ = false;
+    uint32_t wake_count_ = 0;
+    uint64_t wake_total_latency_us_ = 0;
+    uint32_t wake_max_latency_us_ = 0;
 
     void OnWakeWordDetected();
-    void CheckNewVersion(Ota& ota);
+    bool OpenAudioChannelForWake();
+    void OnWakeUplinkSent();
+    void CheckNewVersion(Ota& ota, esp_err_t first_result);
+    void StartProtocol(Ota& ota);
     void CheckAssetsVersion();
     void ShowActivationCode(const std::string& code, const std::string& message);
     void SetListeningMode(ListeningMode mode);
+
+    void HandleIncomingMessage(const IncomingMessage& message);
+    void OnTtsMessage(const IncomingMessage& message);
+    void OnSttMessage(const IncomingMessage& message);
+    void OnLlmMessage(const IncomingMessage& message);
+    void OnMcpMessage(const IncomingMessage& message);
+    void OnSystemMessage(const IncomingMessage& message);
+    void OnAlertMessage(const IncomingMessage& message);
+#if CONFIG_RECEIVE_CUSTOM_MESSAGE
+    void OnCustomMessage(const IncomingMessage& message);
+#endif
+    void PrintMessageStatistics();
+
+    void NotifyScheduleFromISR();
+    void RunScheduledTasks();
+    void PrintScheduleStatistics();
 };
 
 
@@ -3,6 +3,7 @@
 #include "display.h"
 #include "application.h"
 #include "lvgl_theme.h"
+#include "settings.h"
 #include <esp_afe_sr_models.h>
 #include <esp_nsn_models.h>
 #include <esp_mn_iface.h>
@@ -15,6 +16,7 @@
 #include <spi_flash_mmap.h>
 #include <esp_timer.h>
 #include <cbin_font.h>
+#include <algorithm>
 #include <cstring>
 #include <esp_heap_caps.h>
 #include <freertos/FreeRTOS.h>
@@ -23,6 +25,9 @@
 
 #define TAG "Assets"
 
+// 后台校验每次处理的字节数，块之间让出 CPU
+#define ASSETS_VERIFY_BLOCK_SIZE (64 * 1024)
+
 struct mmap_assets_table {
     char asset_name[32];          /*!< Name of the asset */
     uint32_t asset_size;          /*!< Size of the asset */
@@ -38,6 +43,7 @@ Assets::Assets() {
 }
 
 Assets::~Assets() {
+    StopBackgroundVerify();
     if (mmap_handle_ != 0) {
         esp_partition_munmap(mmap_handle_);
     }
@@ -51,6 +57,25 @@ uint32_t Assets::CalculateChecksum(const char* data, uint32_t length) {
     return checksum & 0xFFFF;
 }
 
+// 分区代号：分区位置、头部和文件表的 FNV-1a，只读几 KB；资源重新下载或烧录后会变化
+uint32_t Assets::CalculateGenerationMark(uint32_t stored_files, uint32_t stored_chksum, uint32_t stored_len) {
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const void* data, size_t length) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+    mix(&partition_->address, sizeof(partition_->address));
+    mix(&partition_->size, sizeof(partition_->size));
+    mix(&stored_files, sizeof(stored_files));
+    mix(&stored_chksum, sizeof(stored_chksum));
+    mix(&stored_len, sizeof(stored_len));
+    size_t table_size = (size_t)std::min<uint64_t>((uint64_t)stored_files * sizeof(mmap_assets_table), stored_len);
+    mix(mmap_root_ + 12, table_size);
+    return hash;
+}
+
 bool Assets::InitializePartition() {
     partition_valid_ = false;
     checksum_valid_ = false;
@@ -88,14 +113,34 @@ bool Assets::InitializePartition() {
         return false;
     }
 
-    auto start_time = esp_timer_get_time();
-    uint32_t calculated_checksum = CalculateChecksum(mmap_root_ + 12, stored_len);
-    auto end_time = esp_timer_get_time();
-    ESP_LOGI(TAG, "The checksum calculation time is %d ms", int((end_time - start_time) / 1000));
-
-    if (calculated_checksum != stored_chksum) {
-        ESP_LOGE(TAG, "The calculated checksum (0x%lx) does not match the stored checksum (0x%lx)", calculated_checksum, stored_chksum);
-        return false;
+    // 同一代分区已完整校验过时直接使用缓存结果，只有下载/重新烧录后才整体求和
+    uint32_t mark = CalculateGenerationMark(stored_files, stored_chksum, stored_len);
+    Settings settings("assets", true);
+    if ((uint32_t)settings.GetInt("verified_mark", 0) == mark && settings.GetInt("verify_ms", -1) >= 0) {
+        ESP_LOGI(TAG, "The checksum is cached (mark 0x%08lx), skipped %lu KB, saved about %ld ms",
+            mark, stored_len / 1024, settings.GetInt("verify_ms", 0));
+#if CONFIG_ASSETS_BACKGROUND_VERIFY
+        // 每 N 次使用缓存的启动才整体重读一遍分区，避免每次开机都占用 flash 带宽
+        int cached_boots = settings.GetInt("cached_boots", 0) + 1;
+        if (cached_boots >= CONFIG_ASSETS_BACKGROUND_VERIFY_INTERVAL) {
+            cached_boots = 0;
+            StartBackgroundVerify(stored_chksum, stored_len);
+        }
+        settings.SetInt("cached_boots", cached_boots);
+#endif
+    } else {
+        auto start_time = esp_timer_get_time();
+        uint32_t calculated_checksum = CalculateChecksum(mmap_root_ + 12, stored_len);
+        auto end_time = esp_timer_get_time();
+        ESP_LOGI(TAG, "The checksum calculation time is %d ms", int((end_time - start_time) / 1000));
+
+        if (calculated_checksum != stored_chksum) {
+            ESP_LOGE(TAG, "The calculated checksum (0x%lx) does not match the stored checksum (0x%lx)", calculated_checksum, stored_chksum);
+            settings.EraseKey("verified_mark");
+            return false;
+        }
+        settings.SetInt("verified_mark", (int32_t)mark);
+        settings.SetInt("verify_ms", (int32_t)((end_time - start_time) / 1000));
     }
 
     checksum_valid_ = true;
@@ -111,6 +156,53 @@ bool Assets::InitializePartition() {
     return checksum_valid_;
 }
 
+void Assets::StartBackgroundVerify(uint32_t stored_chksum, uint32_t stored_len) {
+    if (verify_running_.exchange(true)) {
+        return;
+    }
+    verify_cancel_ = false;
+    verify_checksum_ = stored_chksum;
+    verify_length_ = stored_len;
+    BaseType_t created = xTaskCreate([](void* arg) {
+        auto self = static_cast<Assets*>(arg);
+        auto start_time = esp_timer_get_time();
+        const char* data = self->mmap_root_ + 12;
+        uint32_t checksum = 0;
+        uint32_t offset = 0;
+        while (offset < self->verify_length_ && !self->verify_cancel_) {
+            uint32_t length = std::min<uint32_t>(ASSETS_VERIFY_BLOCK_SIZE, self->verify_length_ - offset);
+            checksum += self->CalculateChecksum(data + offset, length);
+            offset += length;
+            vTaskDelay(1);
+        }
+        if (!self->verify_cancel_) {
+            checksum &= 0xFFFF;
+            if (checksum != self->verify_checksum_) {
+                // 本次已经加载的资源保持不变，清掉缓存让下次启动重新完整校验
+                ESP_LOGE(TAG, "Background verify failed, checksum 0x%lx does not match 0x%lx", checksum, self->verify_checksum_);
+                Settings settings("assets", true);
+                settings.EraseKey("verified_mark");
+            } else {
+                ESP_LOGI(TAG, "Background verify passed in %d ms", int((esp_timer_get_time() - start_time) / 1000));
+            }
+        }
+        self->verify_running_ = false;
+        vTaskDelete(NULL);
+    }, "assets_verify", 3072, this, tskIDLE_PRIORITY + 1, nullptr);
+    if (created != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create assets_verify task");
+        verify_running_ = false;
+    }
+}
+
+// 取消内存映射之前调用，等后台校验退出
+void Assets::StopBackgroundVerify() {
+    verify_cancel_ = true;
+    while (verify_running_) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
 bool Assets::Apply() {
     void* ptr = nullptr;
     size_t size = 0;
@@ -325,6 +417,13 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
     }
 #endif
     
+    // 分区即将被改写，作废校验缓存
+    StopBackgroundVerify();
+    {
+        Settings settings("assets", true);
+        settings.EraseKey("verified_mark");
+    }
+
     // 取消当前资源分区的内存映射
     if (mmap_handle_ != 0) {
         esp_partition_munmap(mmap_handle_);
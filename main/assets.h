@@ -1,6 +1,7 @@
 #ifndef ASSETS_H
 #define ASSETS_H
 
+#include <atomic>
 #include <map>
 #include <string>
 #include <functional>
@@ -38,6 +39,9 @@ private:
 
     bool InitializePartition();
     uint32_t CalculateChecksum(const char* data, uint32_t length);
+    uint32_t CalculateGenerationMark(uint32_t stored_files, uint32_t stored_chksum, uint32_t stored_len);
+    void StartBackgroundVerify(uint32_t stored_chksum, uint32_t stored_len);
+    void StopBackgroundVerify();
 
     const esp_partition_t* partition_ = nullptr;
     esp_partition_mmap_handle_t mmap_handle_ = 0;
@@ -47,6 +51,10 @@ private:
     std::string default_assets_url_;
     srmodel_list_t* models_list_ = nullptr;
     std::map<std::string, Asset> assets_;
+    std::atomic<bool> verify_running_{false};
+    std::atomic<bool> verify_cancel_{false};
+    uint32_t verify_checksum_ = 0;
+    uint32_t verify_length_ = 0;
 };
 
 #endif
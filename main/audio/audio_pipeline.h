@@ -0,0 +1,212 @@
+#ifndef AUDIO_PIPELINE_H
+#define AUDIO_PIPELINE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <esp_cpu.h>
+#include <opus_resampler.h>
+
+/*
+ * Audio input pipeline: (Codec) -> [Read] -> [Deinterleave] -> [Resample] -> (Processor / Wake word)
+ *
+ * The board audio shape (codec input sample rate and channel count) is injected by main/CMakeLists.txt
+ * as AUDIO_PIPELINE_INPUT_SAMPLE_RATE / AUDIO_PIPELINE_INPUT_CHANNELS, so the stages are resolved at
+ * build time and the per-frame path carries no runtime shape checks.
+ * Boards without these definitions fall back to DynamicAudioInputPipeline.
+ *
+ * Process and encode stages are already selected by Kconfig (USE_AUDIO_PROCESSOR / USE_AUDIO_CODEC_ENCODE_OPUS).
+ * The codec is a template parameter (AudioCodec on the device) so the pipelines can be driven by a fake codec in host tests.
+ */
+
+#ifndef AUDIO_PIPELINE_INPUT_SAMPLE_RATE
+#define AUDIO_PIPELINE_INPUT_SAMPLE_RATE 0
+#endif
+#ifndef AUDIO_PIPELINE_INPUT_CHANNELS
+#define AUDIO_PIPELINE_INPUT_CHANNELS 0
+#endif
+
+#define AUDIO_PIPELINE_PROCESS_SAMPLE_RATE 16000
+
+namespace audio_pipeline {
+
+// (mic, ref, mic, ref, ...) -> (mic...), (ref...)
+inline void Deinterleave(const int16_t* input, size_t frames, int16_t* mic, int16_t* reference) {
+    for (size_t i = 0, j = 0; i < frames; ++i, j += 2) {
+        mic[i] = input[j];
+        reference[i] = input[j + 1];
+    }
+}
+
+// (mic...), (ref...) -> (mic, ref, mic, ref, ...)
+inline void Interleave(const int16_t* mic, const int16_t* reference, size_t frames, int16_t* output) {
+    for (size_t i = 0, j = 0; i < frames; ++i, j += 2) {
+        output[j] = mic[i];
+        output[j + 1] = reference[i];
+    }
+}
+
+// Keep the mic channel only, in place
+inline void ExtractMic(std::vector<int16_t>& data) {
+    size_t frames = data.size() / 2;
+    for (size_t i = 0, j = 0; i < frames; ++i, j += 2) {
+        data[i] = data[j];
+    }
+    data.resize(frames);
+}
+
+} // namespace audio_pipeline
+
+template <int kInputSampleRate, int kInputChannels>
+class AudioInputPipeline {
+public:
+    static_assert(kInputSampleRate > 0, "Invalid input sample rate");
+    static_assert(kInputChannels == 1 || kInputChannels == 2, "Only mono or mic + reference input is supported");
+
+    static constexpr int kProcessSampleRate = AUDIO_PIPELINE_PROCESS_SAMPLE_RATE;
+    static constexpr int kChannels = kInputChannels;
+    static constexpr bool kNeedResample = kInputSampleRate != kProcessSampleRate;
+    static constexpr bool kHasReference = kInputChannels == 2;
+
+    // Returns false if the codec does not match the shape this firmware was built for
+    template <typename Codec>
+    bool Configure(Codec* codec) {
+        if (codec->input_sample_rate() != kInputSampleRate || codec->input_channels() != kInputChannels) {
+            return false;
+        }
+        if constexpr (kNeedResample) {
+            mic_resampler_.Configure(kInputSampleRate, kProcessSampleRate);
+            if constexpr (kHasReference) {
+                reference_resampler_.Configure(kInputSampleRate, kProcessSampleRate);
+            }
+        }
+        return true;
+    }
+
+    // Read `samples` frames at kProcessSampleRate into `data` (interleaved when kHasReference)
+    template <typename Codec>
+    bool Read(Codec* codec, std::vector<int16_t>& data, int samples) {
+        if constexpr (!kNeedResample) {
+            data.resize(samples * kInputChannels);
+            last_cycles_ = 0;
+            return codec->InputData(data);
+        } else {
+            const int codec_samples = samples * kInputSampleRate / kProcessSampleRate;
+            raw_.resize(codec_samples * kInputChannels);
+            if (!codec->InputData(raw_)) {
+                return false;
+            }
+
+            uint32_t start = esp_cpu_get_cycle_count();
+            const int output_samples = mic_resampler_.GetOutputSamples(codec_samples);
+            if constexpr (kHasReference) {
+                mic_.resize(codec_samples);
+                reference_.resize(codec_samples);
+                audio_pipeline::Deinterleave(raw_.data(), codec_samples, mic_.data(), reference_.data());
+
+                resampled_mic_.resize(output_samples);
+                resampled_reference_.resize(output_samples);
+                mic_resampler_.Process(mic_.data(), codec_samples, resampled_mic_.data());
+                reference_resampler_.Process(reference_.data(), codec_samples, resampled_reference_.data());
+
+                data.resize(output_samples * 2);
+                audio_pipeline::Interleave(resampled_mic_.data(), resampled_reference_.data(), output_samples, data.data());
+            } else {
+                data.resize(output_samples);
+                mic_resampler_.Process(raw_.data(), codec_samples, data.data());
+            }
+            last_cycles_ = esp_cpu_get_cycle_count() - start;
+            return true;
+        }
+    }
+
+    constexpr bool has_reference() const { return kHasReference; }
+    // CPU cycles spent after the codec read for the last frame
+    uint32_t last_cycles() const { return last_cycles_; }
+
+private:
+    OpusResampler mic_resampler_;
+    OpusResampler reference_resampler_;
+    // Scratch buffers, sized on the first frame and reused afterwards
+    std::vector<int16_t> raw_;
+    std::vector<int16_t> mic_;
+    std::vector<int16_t> reference_;
+    std::vector<int16_t> resampled_mic_;
+    std::vector<int16_t> resampled_reference_;
+    uint32_t last_cycles_ = 0;
+};
+
+// Used when the board does not declare its audio shape at build time
+class DynamicAudioInputPipeline {
+public:
+    static constexpr int kProcessSampleRate = AUDIO_PIPELINE_PROCESS_SAMPLE_RATE;
+
+    template <typename Codec>
+    bool Configure(Codec* codec) {
+        input_sample_rate_ = codec->input_sample_rate();
+        input_channels_ = codec->input_channels();
+        if (input_sample_rate_ != kProcessSampleRate) {
+            mic_resampler_.Configure(input_sample_rate_, kProcessSampleRate);
+            reference_resampler_.Configure(input_sample_rate_, kProcessSampleRate);
+        }
+        return true;
+    }
+
+    template <typename Codec>
+    bool Read(Codec* codec, std::vector<int16_t>& data, int samples) {
+        last_cycles_ = 0;
+        if (input_sample_rate_ == kProcessSampleRate) {
+            data.resize(samples * input_channels_);
+            return codec->InputData(data);
+        }
+
+        const int codec_samples = samples * input_sample_rate_ / kProcessSampleRate;
+        raw_.resize(codec_samples * input_channels_);
+        if (!codec->InputData(raw_)) {
+            return false;
+        }
+
+        uint32_t start = esp_cpu_get_cycle_count();
+        const int output_samples = mic_resampler_.GetOutputSamples(codec_samples);
+        if (input_channels_ == 2) {
+            mic_.resize(codec_samples);
+            reference_.resize(codec_samples);
+            audio_pipeline::Deinterleave(raw_.data(), codec_samples, mic_.data(), reference_.data());
+            resampled_mic_.resize(output_samples);
+            resampled_reference_.resize(output_samples);
+            mic_resampler_.Process(mic_.data(), codec_samples, resampled_mic_.data());
+            reference_resampler_.Process(reference_.data(), codec_samples, resampled_reference_.data());
+            data.resize(output_samples * 2);
+            audio_pipeline::Interleave(resampled_mic_.data(), resampled_reference_.data(), output_samples, data.data());
+        } else {
+            data.resize(output_samples);
+            mic_resampler_.Process(raw_.data(), codec_samples, data.data());
+        }
+        last_cycles_ = esp_cpu_get_cycle_count() - start;
+        return true;
+    }
+
+    bool has_reference() const { return input_channels_ == 2; }
+    uint32_t last_cycles() const { return last_cycles_; }
+
+private:
+    int input_sample_rate_ = kProcessSampleRate;
+    int input_channels_ = 1;
+    OpusResampler mic_resampler_;
+    OpusResampler reference_resampler_;
+    std::vector<int16_t> raw_;
+    std::vector<int16_t> mic_;
+    std::vector<int16_t> reference_;
+    std::vector<int16_t> resampled_mic_;
+    std::vector<int16_t> resampled_reference_;
+    uint32_t last_cycles_ = 0;
+};
+
+#if AUDIO_PIPELINE_INPUT_SAMPLE_RATE > 0
+using BoardAudioInputPipeline = AudioInputPipeline<AUDIO_PIPELINE_INPUT_SAMPLE_RATE, AUDIO_PIPELINE_INPUT_CHANNELS>;
+#else
+using BoardAudioInputPipeline = DynamicAudioInputPipeline;
+#endif
+
+#endif // AUDIO_PIPELINE_H
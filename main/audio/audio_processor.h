@@ -21,6 +21,8 @@ public:
     virtual void OnVadStateChange(std::function<void(bool speaking)> callback) = 0;
     virtual size_t GetFeedSize() = 0;
     virtual void EnableDeviceAec(bool enable) = 0;
+    // 运行时调整输出帧长，之后输出的帧按新的长度切分
+    virtual void SetOutputFrameDuration(int frame_duration_ms) = 0;
 };
 
 #endif
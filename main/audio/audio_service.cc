@@ -1,6 +1,7 @@
 #include "audio_service.h"
 #include <esp_log.h>
 #include <cstring>
+#include <cstdlib>
 
 #if CONFIG_USE_AUDIO_PROCESSOR
 #include "processors/afe_audio_processor.h"
@@ -37,17 +38,12 @@ AudioService::~AudioService() {
 void AudioService::ResetOpusParameters() {
     opus_frame_duration_ = OPUS_FRAME_DURATION_MS;
 #ifdef CONFIG_CONNECTION_TYPE_NERTC
-    auto* config_json = NeRtcProtocol::ReadConfigJson();
-    if(config_json) {
-        cJSON* audio_config = cJSON_GetObjectItem(config_json, "audio_config");
-        if (audio_config) {
-            cJSON* frame_size = cJSON_GetObjectItem(audio_config, "frame_size");
-            if (cJSON_IsNumber(frame_size)) {
-                opus_frame_duration_ = frame_size->valueint;
-            }
-        }
+    const auto& local_config = NeRtcProtocol::GetLocalConfig();
+    if (local_config.frame_size > 0) {
+        opus_frame_duration_ = local_config.frame_size;
     }
 #endif
+    uplink_frame_duration_ = opus_frame_duration_;
 #if defined(CONFIG_USE_DEVICE_AEC) && !defined(CONFIG_USE_AUDIO_CODEC_ENCODE_OPUS)
     max_send_packets_size_ = (960 / opus_frame_duration_);
 #else
@@ -69,14 +65,19 @@ void AudioService::Initialize(AudioCodec* codec) {
     opus_decoder_ = std::make_unique<OpusDecoderWrapper>(codec->output_sample_rate(), 1, opus_frame_duration());
 #ifdef CONFIG_USE_AUDIO_CODEC_ENCODE_OPUS
     opus_decoder2_ = std::make_unique<OpusDecoderWrapper>(16000, 1, 20);
-#else
+#elif !CONFIG_USE_NERTC_PCM_UPLINK
     opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, opus_frame_duration());
     opus_encoder_->SetComplexity(0);
+    encoder_frame_duration_ = opus_frame_duration();
 #endif
 
-    if (codec->input_sample_rate() != 16000) {
-        input_resampler_.Configure(codec->input_sample_rate(), 16000);
-        reference_resampler_.Configure(codec->input_sample_rate(), 16000);
+    if (!input_pipeline_.Configure(codec)) {
+        // 板级 CMake 声明的形状与实际 codec 不符是构建配置错误，Release 构建下同样终止，而不是读出错位的数据
+        ESP_LOGE(TAG, "Codec input (%d Hz, %d ch) does not match the build-time pipeline (%d Hz, %d ch), "
+            "fix BOARD_AUDIO_INPUT_SAMPLE_RATE / BOARD_AUDIO_INPUT_CHANNELS in main/CMakeLists.txt",
+            codec->input_sample_rate(), codec->input_channels(),
+            AUDIO_PIPELINE_INPUT_SAMPLE_RATE, AUDIO_PIPELINE_INPUT_CHANNELS);
+        abort();
     }
 
 #if CONFIG_USE_AUDIO_PROCESSOR
@@ -99,7 +100,7 @@ void AudioService::Initialize(AudioCodec* codec) {
     esp_timer_create_args_t audio_power_timer_args = {
         .callback = [](void* arg) {
             AudioService* audio_service = (AudioService*)arg;
-            audio_service->CheckAndUpdateAudioPowerState();
+            audio_service->audio_power_work_.Post();
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -232,37 +233,18 @@ bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, in
         codec_->EnableInput(true);
     }
 
-    if (codec_->input_sample_rate() != sample_rate) {
-        data.resize(samples * codec_->input_sample_rate() / sample_rate * codec_->input_channels());
-        if (!codec_->InputData(data)) {
-            return false;
-        }
-        if (codec_->input_channels() == 2) {
-            auto mic_channel = std::vector<int16_t>(data.size() / 2);
-            auto reference_channel = std::vector<int16_t>(data.size() / 2);
-            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2) {
-                mic_channel[i] = data[j];
-                reference_channel[i] = data[j + 1];
-            }
-            auto resampled_mic = std::vector<int16_t>(input_resampler_.GetOutputSamples(mic_channel.size()));
-            auto resampled_reference = std::vector<int16_t>(reference_resampler_.GetOutputSamples(reference_channel.size()));
-            input_resampler_.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
-            reference_resampler_.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
-            data.resize(resampled_mic.size() + resampled_reference.size());
-            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2) {
-                data[j] = resampled_mic[i];
-                data[j + 1] = resampled_reference[i];
-            }
-        } else {
-            auto resampled = std::vector<int16_t>(input_resampler_.GetOutputSamples(data.size()));
-            input_resampler_.Process(data.data(), data.size(), resampled.data());
-            data = std::move(resampled);
-        }
-    } else {
-        data.resize(samples * codec_->input_channels());
-        if (!codec_->InputData(data)) {
-            return false;
-        }
+    if (sample_rate != AUDIO_PIPELINE_PROCESS_SAMPLE_RATE) {
+        ESP_LOGE(TAG, "Unsupported read sample rate: %d", sample_rate);
+        return false;
+    }
+    if (!input_pipeline_.Read(codec_, data, samples)) {
+        return false;
+    }
+
+    uint32_t cycles = input_pipeline_.last_cycles();
+    debug_statistics_.input_pipeline_cycles += cycles;
+    if (cycles > debug_statistics_.input_pipeline_max_cycles) {
+        debug_statistics_.input_pipeline_max_cycles = cycles;
     }
 
     /* Update the last input time */
@@ -307,12 +289,8 @@ void AudioService::AudioInputTask() {
             int samples = opus_frame_duration() * 16000 / 1000;
             if (ReadAudioData(data, 16000, samples)) {
                 // If input channels is 2, we need to fetch the left channel data
-                if (codec_->input_channels() == 2) {
-                    auto mono_data = std::vector<int16_t>(data.size() / 2);
-                    for (size_t i = 0, j = 0; i < mono_data.size(); ++i, j += 2) {
-                        mono_data[i] = data[j];
-                    }
-                    data = std::move(mono_data);
+                if (input_pipeline_.has_reference()) {
+                    audio_pipeline::ExtractMic(data);
                 }
                 PushTaskToEncodeQueue(kAudioTaskTypeEncodeToTestingQueue, std::move(data));
                 continue;
@@ -470,14 +448,25 @@ void AudioService::OpusCodecTask() {
             audio_queue_cv_.notify_all();
             lock.unlock();
 
+            // 编码器按实际 PCM 帧长创建：PCM 上行模式下只有音频测试才会用到，按需创建；
+            // 自适应帧长切换后，旧帧长的帧仍按旧编码器参数处理完
+            int frame_duration = task->pcm.size() * 1000 / 16000;
+            if (!opus_encoder_ || frame_duration != encoder_frame_duration_) {
+                opus_encoder_.reset();
+                opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, frame_duration);
+                opus_encoder_->SetComplexity(0);
+                encoder_frame_duration_ = frame_duration;
+            }
             auto packet = std::make_unique<AudioStreamPacket>();
-            packet->frame_duration = opus_frame_duration();
+            packet->frame_duration = frame_duration;
             packet->sample_rate = 16000;
             packet->timestamp = task->timestamp;
+            uint32_t start_cycles = esp_cpu_get_cycle_count();
             if (!opus_encoder_->Encode(std::move(task->pcm), packet->payload)) {
                 ESP_LOGE(TAG, "Failed to encode audio");
                 continue;
             }
+            debug_statistics_.encode_cycles += esp_cpu_get_cycle_count() - start_cycles;
 
             if (task->type == kAudioTaskTypeEncodeToSendQueue) {
                 {
@@ -506,6 +495,7 @@ void AudioService::SetDecodeSampleRate(int sample_rate, int frame_duration) {
 
     opus_decoder_.reset();
     opus_decoder_ = std::make_unique<OpusDecoderWrapper>(sample_rate, 1, frame_duration);
+    max_decode_packets_size_ = 600 / frame_duration;
 
     auto codec = Board::GetInstance().GetAudioCodec();
     if (opus_decoder_->sample_rate() != codec->output_sample_rate()) {
@@ -515,6 +505,12 @@ void AudioService::SetDecodeSampleRate(int sample_rate, int frame_duration) {
 }
 
 void AudioService::PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm) {
+#if CONFIG_USE_NERTC_PCM_UPLINK
+    if (type == kAudioTaskTypeEncodeToSendQueue) {
+        PushPcmToSendQueue(std::move(pcm));
+        return;
+    }
+#endif
     auto task = std::make_unique<AudioTask>();
     task->type = type;
     task->pcm = std::move(pcm);
@@ -537,6 +533,35 @@ void AudioService::PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t
     audio_queue_cv_.notify_all();
 }
 
+#if CONFIG_USE_NERTC_PCM_UPLINK
+void AudioService::PushPcmToSendQueue(std::vector<int16_t>&& pcm) {
+    // 处理器输出的帧直接作为上行包，不经过编码队列和 Opus 编码
+    auto packet = std::make_unique<AudioStreamPacket>();
+    packet->frame_duration = opus_frame_duration();
+    packet->sample_rate = 16000;
+    packet->pcm_payload = std::move(pcm);
+
+    {
+        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+        if (!timestamp_queue_.empty()) {
+            if (timestamp_queue_.size() <= MAX_TIMESTAMPS_IN_QUEUE) {
+                packet->timestamp = timestamp_queue_.front();
+            }
+            timestamp_queue_.pop_front();
+        }
+        if (audio_send_queue_.size() >= max_send_packets_size_) {
+            ESP_LOGW(TAG, "Audio send queue is full (%u), dropping oldest PCM frame", audio_send_queue_.size());
+            audio_send_queue_.pop_front();
+        }
+        audio_send_queue_.push_back(std::move(packet));
+        debug_statistics_.pcm_passthrough_count++;
+    }
+    if (callbacks_.on_send_queue_available) {
+        callbacks_.on_send_queue_available();
+    }
+}
+#endif
+
 bool AudioService::PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> packet, bool wait) {
     std::unique_lock<std::mutex> lock(audio_queue_mutex_);
     if (audio_decode_queue_.size() >= max_decode_packets_size_) {
@@ -613,13 +638,17 @@ void AudioService::EnableWakeWordDetection(bool enable) {
     }
 }
 
+void AudioService::PrepareVoiceProcessing() {
+    if (!audio_processor_initialized_) {
+        audio_processor_->Initialize(codec_, uplink_frame_duration_, models_list_);
+        audio_processor_initialized_ = true;
+    }
+}
+
 void AudioService::EnableVoiceProcessing(bool enable) {
     ESP_LOGD(TAG, "%s voice processing", enable ? "Enabling" : "Disabling");
     if (enable) {
-        if (!audio_processor_initialized_) {
-            audio_processor_->Initialize(codec_, opus_frame_duration(), models_list_);
-            audio_processor_initialized_ = true;
-        }
+        PrepareVoiceProcessing();
 
         /* We should make sure no audio is playing */
         ResetDecoder();
@@ -651,10 +680,7 @@ void AudioService::EnableAudioTesting(bool enable) {
 
 void AudioService::EnableDeviceAec(bool enable) {
     ESP_LOGI(TAG, "%s device AEC", enable ? "Enabling" : "Disabling");
-    if (!audio_processor_initialized_) {
-        audio_processor_->Initialize(codec_, opus_frame_duration(), models_list_);
-        audio_processor_initialized_ = true;
-    }
+    PrepareVoiceProcessing();
 
     audio_processor_->EnableDeviceAec(enable);
 }
@@ -835,6 +861,109 @@ void AudioService::SetModelsList(srmodel_list_t* models_list) {
     }
 }
 
+void AudioService::PrintDebugStatistics() {
+    uint32_t input_count = debug_statistics_.input_count;
+    uint32_t encode_count = debug_statistics_.encode_count;
+    uint32_t avg_cycles = input_count > 0 ? debug_statistics_.input_pipeline_cycles / input_count : 0;
+    uint32_t avg_encode_cycles = encode_count > 0 ? debug_statistics_.encode_cycles / encode_count : 0;
+    ESP_LOGI(TAG, "Audio stats: input %lu decode %lu encode %lu playback %lu, input pipeline avg %lu max %lu cycles/frame",
+        debug_statistics_.input_count, debug_statistics_.decode_count, debug_statistics_.encode_count,
+        debug_statistics_.playback_count, avg_cycles, debug_statistics_.input_pipeline_max_cycles);
+    ESP_LOGI(TAG, "Audio stats: encode avg %lu cycles/frame, pcm passthrough %lu frames, encoder %s, uplink frame %d ms (%lu switches)",
+        avg_encode_cycles, debug_statistics_.pcm_passthrough_count, opus_encoder_ ? "allocated" : "not allocated",
+        uplink_frame_duration(), debug_statistics_.frame_duration_switches);
+
+    int64_t now = esp_timer_get_time();
+    uint32_t copied = debug_statistics_.downlink_bytes_copied.load(std::memory_order_relaxed);
+    if (last_statistics_time_us_ > 0 && now > last_statistics_time_us_) {
+        uint32_t bytes_per_second = (uint64_t)(copied - last_downlink_bytes_copied_) * 1000000 / (now - last_statistics_time_us_);
+        ESP_LOGI(TAG, "Audio stats: downlink copied %lu B/s", bytes_per_second);
+    }
+    last_statistics_time_us_ = now;
+    last_downlink_bytes_copied_ = copied;
+}
+
+void AudioService::SetUplinkFrameDuration(int frame_duration) {
+    int old_frame_duration = uplink_frame_duration_;
+    if (frame_duration == old_frame_duration) {
+        return;
+    }
+    uplink_frame_duration_ = frame_duration;
+    if (audio_processor_initialized_) {
+        audio_processor_->SetOutputFrameDuration(frame_duration);
+    }
+    {
+        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+#if defined(CONFIG_USE_DEVICE_AEC) && !defined(CONFIG_USE_AUDIO_CODEC_ENCODE_OPUS)
+        max_send_packets_size_ = (960 / frame_duration);
+#else
+        max_send_packets_size_ = (600 / frame_duration);
+#endif
+    }
+    debug_statistics_.frame_duration_switches++;
+    ESP_LOGI(TAG, "Uplink frame duration %d -> %d ms, max send packets %d, switches %lu",
+        old_frame_duration, frame_duration, max_send_packets_size_, debug_statistics_.frame_duration_switches);
+}
+
+void AudioService::ResetUplinkFrameDuration() {
+    adaptive_stable_rounds_ = 0;
+    SetUplinkFrameDuration(opus_frame_duration_);
+}
+
+// 弱网（丢包 / RTT 高 / 发送队列堆积）立即加长帧；网络持续良好若干轮后才缩短，避免来回抖动
+// 只在服务端声明的最长帧长以内切换，服务端未声明时保持协商的固定帧长
+void AudioService::AdaptUplinkFrameDuration(const LinkStatistics& link) {
+    static const int kFrameDurations[] = {20, 40, 60, 120};
+    if (link.max_uplink_frame_duration <= 0) {
+        if (uplink_frame_duration_ != opus_frame_duration_) {
+            ResetUplinkFrameDuration();
+        }
+        return;
+    }
+    int count = 0;
+    while (count < (int)(sizeof(kFrameDurations) / sizeof(kFrameDurations[0])) &&
+        kFrameDurations[count] <= link.max_uplink_frame_duration) {
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+    int current = uplink_frame_duration_;
+    int index = 0;
+    while (index < count - 1 && kFrameDurations[index] < current) {
+        index++;
+    }
+
+    size_t send_queue_depth;
+    {
+        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+        send_queue_depth = audio_send_queue_.size();
+    }
+
+    // 丢包率只在样本足够时参与判定，样本不足的一轮不算良好；RTT 只有新样本时参与
+    bool loss_valid = link.packets >= ADAPTIVE_FRAME_MIN_PACKETS;
+    bool degraded = (loss_valid && link.loss_rate > ADAPTIVE_FRAME_LOSS_HIGH) || link.rtt_ms > ADAPTIVE_FRAME_RTT_HIGH_MS ||
+        send_queue_depth > (size_t)max_send_packets_size_ / 2;
+    bool good = loss_valid && link.loss_rate < ADAPTIVE_FRAME_LOSS_LOW && link.rtt_ms < ADAPTIVE_FRAME_RTT_LOW_MS &&
+        send_queue_depth <= 1;
+
+    if (degraded) {
+        adaptive_stable_rounds_ = 0;
+        if (index < count - 1) {
+            ESP_LOGI(TAG, "Link degraded: loss %.1f%% of %lu rtt %d ms jitter %.1f ms send queue %u",
+                link.loss_rate * 100, link.packets, link.rtt_ms, link.jitter_ms, send_queue_depth);
+            SetUplinkFrameDuration(kFrameDurations[index + 1]);
+        }
+    } else if (good) {
+        if (++adaptive_stable_rounds_ >= ADAPTIVE_FRAME_STABLE_ROUNDS && index > 0) {
+            adaptive_stable_rounds_ = 0;
+            SetUplinkFrameDuration(kFrameDurations[index - 1]);
+        }
+    } else if (loss_valid) {
+        adaptive_stable_rounds_ = 0;
+    }
+}
+
 void AudioService::UpdateLastOutputTime(){
     last_output_time_ =  std::chrono::steady_clock::now();
 }
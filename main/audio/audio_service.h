@@ -6,6 +6,7 @@
 #include <condition_variable>
 #include <chrono>
 #include <mutex>
+#include <atomic>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -18,10 +19,12 @@
 #include <opus_resampler.h>
 
 #include "audio_codec.h"
+#include "audio_pipeline.h"
 #include "audio_processor.h"
 #include "processors/audio_debugger.h"
 #include "wake_word.h"
 #include "protocol.h"
+#include "deferred_work.h"
 
 /*
  * There are two types of audio data flow:
@@ -42,6 +45,15 @@
 #define AUDIO_TESTING_MAX_DURATION_MS 10000
 #define MAX_TIMESTAMPS_IN_QUEUE 3
 
+// 自适应上行帧长的判定阈值
+#define ADAPTIVE_FRAME_LOSS_HIGH 0.05f
+#define ADAPTIVE_FRAME_LOSS_LOW 0.01f
+#define ADAPTIVE_FRAME_RTT_HIGH_MS 300
+#define ADAPTIVE_FRAME_RTT_LOW_MS 120
+#define ADAPTIVE_FRAME_STABLE_ROUNDS 5
+// 区间内少于这么多包时不按丢包率判定
+#define ADAPTIVE_FRAME_MIN_PACKETS 20
+
 #define AUDIO_POWER_TIMEOUT_MS 15000
 #define AUDIO_POWER_CHECK_INTERVAL_MS 1000
 
@@ -76,6 +88,16 @@ struct DebugStatistics {
     uint32_t decode_count = 0;
     uint32_t encode_count = 0;
     uint32_t playback_count = 0;
+    // Input pipeline cost after the codec read (deinterleave + resample), in CPU cycles
+    uint64_t input_pipeline_cycles = 0;
+    uint32_t input_pipeline_max_cycles = 0;
+    // Opus encode cost, and frames sent as raw PCM without local encode
+    uint64_t encode_cycles = 0;
+    uint32_t pcm_passthrough_count = 0;
+    // Bytes copied from transport buffers into downlink packets, counted from network tasks
+    std::atomic<uint32_t> downlink_bytes_copied {0};
+    // Uplink frame duration switches
+    uint32_t frame_duration_switches = 0;
 };
 
 class AudioService {
@@ -98,6 +120,8 @@ public:
 
     void EnableWakeWordDetection(bool enable);
     void EnableVoiceProcessing(bool enable);
+    // 提前初始化音频处理器，可与建立音频通道并行
+    void PrepareVoiceProcessing();
     void EnableAudioTesting(bool enable);
     void EnableDeviceAec(bool enable);
 
@@ -119,7 +143,15 @@ public:
     void SetModelsList(srmodel_list_t* models_list);
 
     inline int opus_frame_duration() const { return opus_frame_duration_; }
+    inline int uplink_frame_duration() const { return uplink_frame_duration_; }
+    void SetUplinkFrameDuration(int frame_duration);
+    void AdaptUplinkFrameDuration(const LinkStatistics& link);
+    // 恢复 hello 协商的帧长，每个会话重新开始自适应
+    void ResetUplinkFrameDuration();
     void EnableMicInput(bool enable);
+    const DebugStatistics& debug_statistics() const { return debug_statistics_; }
+    void CountDownlinkBytesCopied(size_t bytes) { debug_statistics_.downlink_bytes_copied.fetch_add(bytes, std::memory_order_relaxed); }
+    void PrintDebugStatistics();
 
 private:
     AudioCodec* codec_ = nullptr;
@@ -132,8 +164,7 @@ private:
 #ifdef CONFIG_USE_AUDIO_CODEC_ENCODE_OPUS
     std::unique_ptr<OpusDecoderWrapper> opus_decoder2_;
 #endif
-    OpusResampler input_resampler_;
-    OpusResampler reference_resampler_;
+    BoardAudioInputPipeline input_pipeline_;
     OpusResampler output_resampler_;
     DebugStatistics debug_statistics_;
     srmodel_list_t* models_list_ = nullptr;
@@ -168,8 +199,14 @@ private:
     bool audio_input_need_warmup_ = false;
 
     esp_timer_handle_t audio_power_timer_ = nullptr;
+    // 关闭 codec 要走 I2C，放到 deferred_work 任务里执行
+    DeferredWork audio_power_work_{"audio_power", [](void* arg) {
+        static_cast<AudioService*>(arg)->CheckAndUpdateAudioPowerState();
+    }, this, 10000};
     std::chrono::steady_clock::time_point last_input_time_;
     std::chrono::steady_clock::time_point last_output_time_;
+    int64_t last_statistics_time_us_ = 0;
+    uint32_t last_downlink_bytes_copied_ = 0;
 
     void AudioInputTask();
     void AudioOutputTask();
@@ -178,10 +215,17 @@ private:
     void WakeOpusCodecTask();
 #endif
     void PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm);
+#if CONFIG_USE_NERTC_PCM_UPLINK
+    void PushPcmToSendQueue(std::vector<int16_t>&& pcm);
+#endif
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
     void CheckAndUpdateAudioPowerState();
 
     int opus_frame_duration_ = 60;
+    // 上行编码帧长，可运行时调整；编码器按实际 PCM 帧长重建
+    std::atomic<int> uplink_frame_duration_ {60};
+    int encoder_frame_duration_ = 0;
+    int adaptive_stable_rounds_ = 0;
     int max_decode_packets_size_ = 40;
     int max_send_packets_size_ = 40;
 
@@ -156,22 +156,28 @@ void AfeAudioProcessor::AudioProcessorTask() {
             output_buffer_.insert(output_buffer_.end(), res->data, res->data + samples);
             
             // Output complete frames when buffer has enough data
-            while (output_buffer_.size() >= frame_samples_) {
-                if (output_buffer_.size() == frame_samples_) {
+            size_t frame_samples = frame_samples_;
+            while (output_buffer_.size() >= frame_samples) {
+                if (output_buffer_.size() == frame_samples) {
                     // If buffer size equals frame size, move the entire buffer
                     output_callback_(std::move(output_buffer_));
                     output_buffer_.clear();
-                    output_buffer_.reserve(frame_samples_);
+                    output_buffer_.reserve(frame_samples);
                 } else {
                     // If buffer size exceeds frame size, copy one frame and remove it
-                    output_callback_(std::vector<int16_t>(output_buffer_.begin(), output_buffer_.begin() + frame_samples_));
-                    output_buffer_.erase(output_buffer_.begin(), output_buffer_.begin() + frame_samples_);
+                    output_callback_(std::vector<int16_t>(output_buffer_.begin(), output_buffer_.begin() + frame_samples));
+                    output_buffer_.erase(output_buffer_.begin(), output_buffer_.begin() + frame_samples);
                 }
             }
         }
     }
 }
 
+// 由处理任务在下一次切帧时生效，缓冲中已有的数据按新帧长输出
+void AfeAudioProcessor::SetOutputFrameDuration(int frame_duration_ms) {
+    frame_samples_ = frame_duration_ms * 16000 / 1000;
+}
+
 void AfeAudioProcessor::EnableDeviceAec(bool enable) {
     if (enable) {
 #if CONFIG_USE_DEVICE_AEC
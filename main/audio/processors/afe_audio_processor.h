@@ -6,6 +6,7 @@
 #include <freertos/task.h>
 #include <freertos/event_groups.h>
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <functional>
@@ -27,6 +28,7 @@ public:
     void OnVadStateChange(std::function<void(bool speaking)> callback) override;
     size_t GetFeedSize() override;
     void EnableDeviceAec(bool enable) override;
+    void SetOutputFrameDuration(int frame_duration_ms) override;
 
 private:
     EventGroupHandle_t event_group_ = nullptr;
@@ -35,7 +37,7 @@ private:
     std::function<void(std::vector<int16_t>&& data)> output_callback_;
     std::function<void(bool speaking)> vad_state_change_callback_;
     AudioCodec* codec_ = nullptr;
-    int frame_samples_ = 0;
+    std::atomic<int> frame_samples_ {0};
     bool is_speaking_ = false;
     std::vector<int16_t> output_buffer_;
 
@@ -52,6 +52,10 @@ size_t NoAudioProcessor::GetFeedSize() {
     return frame_samples_;
 }
 
+void NoAudioProcessor::SetOutputFrameDuration(int frame_duration_ms) {
+    frame_samples_ = frame_duration_ms * 16000 / 1000;
+}
+
 void NoAudioProcessor::EnableDeviceAec(bool enable) {
     if (enable) {
         ESP_LOGE(TAG, "Device AEC is not supported");
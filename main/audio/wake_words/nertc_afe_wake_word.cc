@@ -146,23 +146,16 @@ bool NertcAfeWakeWord::Initialize(AudioCodec* codec, srmodel_list_t* models_list
     config.user_data = this;
     std::string device_id = Board::GetInstance().GetBoardName();
     config.deviceId = device_id.c_str();
-    cJSON* config_json = NeRtcProtocol::ReadConfigJson();
+    const auto& local_config = NeRtcProtocol::GetLocalConfig();
     std::string custom_config_string;
     std::string local_config_appkey_;
-    if(config_json) {
-        cJSON* appkey = cJSON_GetObjectItem(config_json, "appkey");
-        if (appkey && cJSON_IsString(appkey)) {
-            ESP_LOGI(TAG, "local config set appkey to %s", appkey->valuestring);
-            local_config_appkey_ = appkey->valuestring;
-        }
-        cJSON* custom_config = cJSON_GetObjectItem(config_json, "custom_config");
-        if (custom_config && cJSON_IsObject(custom_config)) {
-            custom_config_string = cJSON_Print(custom_config);
-            ESP_LOGI(TAG, "local config set custom_config to %s", custom_config_string.c_str());
-        }
+    if (local_config.valid) {
+        local_config_appkey_ = local_config.appkey;
+        custom_config_string = local_config.custom_config;
+        ESP_LOGI(TAG, "local config set appkey to %s", local_config_appkey_.c_str());
+        ESP_LOGI(TAG, "local config set custom_config to %s", custom_config_string.c_str());
         config.appkey = local_config_appkey_.c_str();
         config.custom_config = custom_config_string.c_str();
-        cJSON_Delete(config_json);
     } else {
         config.appkey = nullptr;
         config.custom_config = nullptr;
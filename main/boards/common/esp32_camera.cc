@@ -5,6 +5,7 @@
 #include "display/clock_desktop_ui.h"
 #include "display/lcd_display.h"
 #include "application.h"
+#include "mcp_server.h"
 #include "settings.h"
 
 #include <esp_log.h>
@@ -253,8 +254,9 @@ std::string Esp32Camera::Explain(const std::string& question) {
         http->Write(file_header.c_str(), file_header.size());
     }
 
-    // 第三块：JPEG数据
+    // 第三块：JPEG数据；tool 调用超时后停止上传，但继续取完队列让编码线程退出
     size_t total_sent = 0;
+    bool cancelled = false;
     while (true) {
         JpegChunk chunk;
         if (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) != pdPASS) {
@@ -264,8 +266,14 @@ std::string Esp32Camera::Explain(const std::string& question) {
         if (chunk.data == nullptr) {
             break; // The last chunk
         }
-        http->Write((const char*)chunk.data, chunk.len);
-        total_sent += chunk.len;
+        if (!cancelled && McpServer::IsToolCallCancelled()) {
+            ESP_LOGW(TAG, "Tool call cancelled, stop uploading after %u bytes", total_sent);
+            cancelled = true;
+        }
+        if (!cancelled) {
+            http->Write((const char*)chunk.data, chunk.len);
+            total_sent += chunk.len;
+        }
         heap_caps_free(chunk.data);
     }
     // Wait for the encoder thread to finish
@@ -273,6 +281,11 @@ std::string Esp32Camera::Explain(const std::string& question) {
     // 清理队列
     vQueueDelete(jpeg_queue);
 
+    if (cancelled) {
+        http->Close();
+        throw std::runtime_error("Tool call cancelled");
+    }
+
     {
         // 第四块：multipart尾部
         std::string multipart_footer;
@@ -9,11 +9,16 @@
 #include <driver/temperature_sensor.h>
 #include <esp_sleep.h>
 #include "config.h"
+#include "deferred_work.h"
 
 class PowerManager {
 private:
     // 定时器句柄
     esp_timer_handle_t timer_handle_;
+    // ADC 采样和充电检测放到 deferred_work 任务，定时器回调只负责投递
+    DeferredWork battery_check_work_{"battery_check", [](void* arg) {
+        static_cast<PowerManager*>(arg)->CheckBatteryStatus();
+    }, this, 5000};
     std::function<void(bool)> on_charging_status_changed_;
     std::function<void(bool)> on_low_battery_status_changed_;
     std::function<void(float)> on_temperature_changed_;
@@ -249,7 +254,7 @@ private:
         esp_timer_create_args_t timer_args = {
             .callback = [](void* arg) {
                 PowerManager* self = static_cast<PowerManager*>(arg);
-                self->CheckBatteryStatus();
+                self->battery_check_work_.Post();
             },
             .arg = this,
             .dispatch_method = ESP_TIMER_TASK,
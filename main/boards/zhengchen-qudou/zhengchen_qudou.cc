@@ -32,6 +32,10 @@
 
 #define TAG "Zhengchen_Qudou"
 
+// 编译期音频输入流水线参数由 main/CMakeLists.txt 注入，需与本板 config.h 一致
+static_assert(AUDIO_PIPELINE_INPUT_SAMPLE_RATE == AUDIO_INPUT_SAMPLE_RATE, "Update BOARD_AUDIO_INPUT_SAMPLE_RATE in main/CMakeLists.txt");
+static_assert(AUDIO_PIPELINE_INPUT_CHANNELS == (AUDIO_INPUT_REFERENCE ? 2 : 1), "Update BOARD_AUDIO_INPUT_CHANNELS in main/CMakeLists.txt");
+
 class Pca9557 : public I2cDevice {
 public:
     Pca9557(i2c_master_bus_handle_t i2c_bus, uint8_t addr) : I2cDevice(i2c_bus, addr) {
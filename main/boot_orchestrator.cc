@@ -0,0 +1,88 @@
+#include "boot_orchestrator.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define TAG "BootOrchestrator"
+
+int BootOrchestrator::AddStep(const char* name, std::function<void()> work, std::initializer_list<int> dependencies) {
+    if (step_count_ >= BOOT_MAX_STEPS) {
+        ESP_LOGE(TAG, "Too many boot steps, %s not added", name);
+        return -1;
+    }
+    auto& step = steps_[step_count_];
+    step.name = name;
+    step.work = std::move(work);
+    for (int dependency : dependencies) {
+        if (dependency < 0 || dependency >= step_count_) {
+            ESP_LOGE(TAG, "Boot step %s has invalid dependency %d, ignored", name, dependency);
+            continue;
+        }
+        step.dependencies |= 1u << dependency;
+    }
+    return step_count_++;
+}
+
+// 调用时持有 mutex_
+int BootOrchestrator::PickReadyStep() {
+    for (int i = 0; i < step_count_; i++) {
+        auto& step = steps_[i];
+        if (!step.started && (step.dependencies & done_mask_) == step.dependencies) {
+            step.started = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void BootOrchestrator::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (finished_count_ < step_count_) {
+        int index = PickReadyStep();
+        if (index < 0) {
+            cv_.wait(lock);
+            continue;
+        }
+        auto& step = steps_[index];
+        lock.unlock();
+        int trace = timeline_.Begin(step.name);
+        step.work();
+        timeline_.End(trace);
+        lock.lock();
+        done_mask_ |= 1u << index;
+        finished_count_++;
+        cv_.notify_all();
+    }
+}
+
+void BootOrchestrator::Run() {
+    for (int i = 0; i < BOOT_WORKER_COUNT; i++) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_workers_++;
+        }
+        BaseType_t created = xTaskCreate([](void* arg) {
+            auto self = static_cast<BootOrchestrator*>(arg);
+            self->WorkerLoop();
+            {
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                self->active_workers_--;
+                self->cv_.notify_all();
+            }
+            vTaskDelete(NULL);
+        }, "boot_worker", BOOT_WORKER_STACK_SIZE, this, uxTaskPriorityGet(NULL), nullptr);
+        if (created != pdPASS) {
+            // 少一个临时任务只是并行度降低，调用任务仍会执行全部步骤
+            ESP_LOGW(TAG, "Failed to create boot worker %d", i);
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_workers_--;
+        }
+    }
+
+    WorkerLoop();
+
+    // 临时任务引用本对象，等它们全部退出
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return active_workers_ == 0; });
+}
@@ -0,0 +1,52 @@
+#ifndef BOOT_ORCHESTRATOR_H
+#define BOOT_ORCHESTRATOR_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+
+#include "timeline.h"
+
+#define BOOT_MAX_STEPS 16
+#define BOOT_WORKER_COUNT 2
+#define BOOT_WORKER_STACK_SIZE (4096 * 2)
+
+using BootTimeline = Timeline<BOOT_MAX_STEPS>;
+
+// 启动步骤依赖图：依赖都已完成的步骤由调用任务和 BOOT_WORKER_COUNT 个临时任务并行执行，
+// 每个步骤的起止时间记录到 timeline 中。依赖只能指向之前添加的步骤，因此不会成环
+class BootOrchestrator {
+public:
+    explicit BootOrchestrator(BootTimeline& timeline) : timeline_(timeline) {}
+    BootOrchestrator(const BootOrchestrator&) = delete;
+    BootOrchestrator& operator=(const BootOrchestrator&) = delete;
+
+    // 返回步骤 id，供后续步骤声明依赖；步骤数超出 BOOT_MAX_STEPS 时返回 -1
+    int AddStep(const char* name, std::function<void()> work, std::initializer_list<int> dependencies = {});
+    // 所有步骤执行完毕、临时任务全部退出后返回
+    void Run();
+
+private:
+    struct Step {
+        const char* name = "";
+        std::function<void()> work;
+        uint32_t dependencies = 0;
+        bool started = false;
+    };
+
+    BootTimeline& timeline_;
+    Step steps_[BOOT_MAX_STEPS];
+    int step_count_ = 0;
+    uint32_t done_mask_ = 0;
+    int finished_count_ = 0;
+    int active_workers_ = 0;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    void WorkerLoop();
+    int PickReadyStep();
+};
+
+#endif // BOOT_ORCHESTRATOR_H
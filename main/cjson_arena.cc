@@ -0,0 +1,120 @@
+#include "cjson_arena.h"
+
+#include <cJSON.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstdlib>
+
+#define TAG "CJsonArena"
+
+static uint8_t* arena_base = nullptr;
+// arena_used / arena_suspended 只由持有竞技场的任务访问
+static size_t arena_used = 0;
+static bool arena_suspended = false;
+static std::atomic<TaskHandle_t> arena_owner {nullptr};
+// 统计由各任务更新、其他任务读取
+static std::atomic<uint32_t> statistics_scopes {0};
+static std::atomic<uint32_t> statistics_nested_scopes {0};
+static std::atomic<uint32_t> statistics_arena_allocations {0};
+static std::atomic<uint32_t> statistics_heap_fallbacks {0};
+static std::atomic<size_t> statistics_peak_used {0};
+
+static void* ArenaMalloc(size_t size) {
+    if (arena_owner.load(std::memory_order_acquire) == xTaskGetCurrentTaskHandle() && !arena_suspended) {
+        size_t aligned = (size + 7) & ~(size_t)7;
+        if (aligned <= CJSON_ARENA_SIZE - arena_used) {
+            void* ptr = arena_base + arena_used;
+            arena_used += aligned;
+            statistics_arena_allocations.fetch_add(1, std::memory_order_relaxed);
+            if (arena_used > statistics_peak_used.load(std::memory_order_relaxed)) {
+                statistics_peak_used.store(arena_used, std::memory_order_relaxed);
+            }
+            return ptr;
+        }
+        statistics_heap_fallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+    return malloc(size);
+}
+
+static void ArenaFree(void* ptr) {
+    auto p = static_cast<uint8_t*>(ptr);
+    if (p >= arena_base && p < arena_base + CJSON_ARENA_SIZE) {
+        // 随作用域整体回收
+        return;
+    }
+    free(ptr);
+}
+
+void CJsonArena::Initialize() {
+    if (arena_base != nullptr) {
+        return;
+    }
+    arena_base = (uint8_t*)heap_caps_malloc(CJSON_ARENA_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (arena_base == nullptr) {
+        ESP_LOGW(TAG, "No PSRAM for cJSON arena, using heap");
+        return;
+    }
+    cJSON_Hooks hooks = {
+        .malloc_fn = ArenaMalloc,
+        .free_fn = ArenaFree,
+    };
+    cJSON_InitHooks(&hooks);
+    ESP_LOGI(TAG, "cJSON arena enabled, %d bytes", CJSON_ARENA_SIZE);
+}
+
+CJsonArenaStatistics CJsonArena::GetStatistics() {
+    CJsonArenaStatistics stats;
+    stats.scopes = statistics_scopes.load(std::memory_order_relaxed);
+    stats.nested_scopes = statistics_nested_scopes.load(std::memory_order_relaxed);
+    stats.arena_allocations = statistics_arena_allocations.load(std::memory_order_relaxed);
+    stats.heap_fallbacks = statistics_heap_fallbacks.load(std::memory_order_relaxed);
+    stats.peak_used = statistics_peak_used.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void CJsonArena::PrintStatistics() {
+    if (arena_base == nullptr) {
+        return;
+    }
+    auto stats = GetStatistics();
+    ESP_LOGI(TAG, "cJSON arena: scopes %lu nested %lu allocations %lu heap fallbacks %lu peak %u/%d bytes",
+        stats.scopes, stats.nested_scopes, stats.arena_allocations, stats.heap_fallbacks, stats.peak_used, CJSON_ARENA_SIZE);
+}
+
+CJsonArenaScope::CJsonArenaScope() {
+    if (arena_base == nullptr) {
+        return;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (arena_owner.load(std::memory_order_acquire) == self) {
+        // 嵌套：回退会让内层带出的对象指向被复用的内存，内层改走堆
+        if (!arena_suspended) {
+            arena_suspended = true;
+            suspended_ = true;
+        }
+        statistics_nested_scopes.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // 竞技场已被其他任务持有时，本作用域照常走堆
+    TaskHandle_t expected = nullptr;
+    if (arena_owner.compare_exchange_strong(expected, self, std::memory_order_acq_rel)) {
+        owner_ = true;
+        arena_used = 0;
+        arena_suspended = false;
+        statistics_scopes.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+CJsonArenaScope::~CJsonArenaScope() {
+    if (suspended_) {
+        arena_suspended = false;
+    }
+    if (owner_) {
+        arena_used = 0;
+        arena_owner.store(nullptr, std::memory_order_release);
+    }
+}
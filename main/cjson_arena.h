@@ -0,0 +1,43 @@
+#ifndef CJSON_ARENA_H
+#define CJSON_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 竞技场容量，放在 PSRAM 中；超出部分回退到堆分配
+#define CJSON_ARENA_SIZE (32 * 1024)
+
+struct CJsonArenaStatistics {
+    uint32_t scopes = 0;            // 持有竞技场的作用域次数（约等于消息数）
+    uint32_t nested_scopes = 0;     // 在已持有竞技场的任务中再次进入的作用域，期间分配走堆
+    uint32_t arena_allocations = 0;
+    uint32_t heap_fallbacks = 0;    // 竞技场剩余空间不足而回退到堆的分配次数
+    size_t peak_used = 0;
+};
+
+// 通过 cJSON_InitHooks 接管 cJSON 的内存分配：
+// 在 CJsonArenaScope 作用域内，持有竞技场的任务从 PSRAM 块中顺序分配，作用域结束时整体回退，free 为空操作；
+// 其他任务以及作用域外的分配照常走堆。作用域内创建的 cJSON 对象和打印结果不能带出作用域
+class CJsonArena {
+public:
+    // 在首次使用 cJSON 前调用；没有 PSRAM 时不启用
+    static void Initialize();
+    static CJsonArenaStatistics GetStatistics();
+    static void PrintStatistics();
+};
+
+// 不回退嵌套：同一任务已持有竞技场时，内层作用域期间的分配改走堆，结束后恢复外层的竞技场分配
+// 内层分配的对象因此可以带到外层使用，竞技场只在最外层作用域结束时整体回收
+class CJsonArenaScope {
+public:
+    CJsonArenaScope();
+    ~CJsonArenaScope();
+    CJsonArenaScope(const CJsonArenaScope&) = delete;
+    CJsonArenaScope& operator=(const CJsonArenaScope&) = delete;
+
+private:
+    bool owner_ = false;        // 本作用域取得了竞技场
+    bool suspended_ = false;    // 本作用域暂停了外层的竞技场分配
+};
+
+#endif // CJSON_ARENA_H
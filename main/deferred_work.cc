@@ -0,0 +1,153 @@
+#include "deferred_work.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <condition_variable>
+#include <mutex>
+
+#define TAG "DeferredWork"
+
+static QueueHandle_t work_queue = nullptr;
+// 保护工作项链表和 running_work；工作项执行时不持有，工作项里可以创建或析构 DeferredWork
+static std::mutex work_mutex;
+static std::condition_variable work_done_cv;
+static DeferredWork* work_list = nullptr;
+// 正在执行的工作项，执行期间析构会等待它结束；在工作项自身中析构时置空，执行完后不再访问该对象
+static DeferredWork* running_work = nullptr;
+static TaskHandle_t worker_task = nullptr;
+
+DeferredWork::DeferredWork(const char* name, void (*work)(void* arg), void* arg, uint32_t budget_us)
+    : name_(name), work_(work), arg_(arg), budget_us_(budget_us) {
+    std::lock_guard<std::mutex> lock(work_mutex);
+    if (work_queue == nullptr) {
+        work_queue = xQueueCreate(DEFERRED_WORK_QUEUE_LENGTH, sizeof(DeferredWork*));
+        xTaskCreate(WorkerLoop, "deferred_work", DEFERRED_WORK_TASK_STACK_SIZE, nullptr, DEFERRED_WORK_TASK_PRIORITY, nullptr);
+    }
+    next_ = work_list;
+    work_list = this;
+}
+
+// 调用前应先停止会调用 Post() 的定时器
+DeferredWork::~DeferredWork() {
+    std::unique_lock<std::mutex> lock(work_mutex);
+    if (running_work == this) {
+        if (xTaskGetCurrentTaskHandle() == worker_task) {
+            // 在自身的工作函数中析构，返回后 WorkerLoop 不再访问本对象
+            running_work = nullptr;
+        } else {
+            work_done_cv.wait(lock, [this]() { return running_work != this; });
+        }
+    }
+    for (auto p = &work_list; *p != nullptr; p = &(*p)->next_) {
+        if (*p == this) {
+            *p = next_;
+            break;
+        }
+    }
+    // 从队列中滤掉本对象，其他工作项按原顺序放回，避免之后同地址的新对象被误执行
+    UBaseType_t waiting = uxQueueMessagesWaiting(work_queue);
+    for (UBaseType_t i = 0; i < waiting; i++) {
+        DeferredWork* work;
+        if (xQueueReceive(work_queue, &work, 0) != pdTRUE) {
+            break;
+        }
+        if (work != this && xQueueSend(work_queue, &work, 0) != pdTRUE) {
+            work->pending_.store(false, std::memory_order_release);
+            work->dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool DeferredWork::Post() {
+    if (pending_.exchange(true, std::memory_order_acq_rel)) {
+        coalesced_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    DeferredWork* self = this;
+    BaseType_t ret;
+    if (xPortInIsrContext()) {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        ret = xQueueSendFromISR(work_queue, &self, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    } else {
+        ret = xQueueSend(work_queue, &self, 0);
+    }
+    if (ret != pdTRUE) {
+        pending_.store(false, std::memory_order_release);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void DeferredWork::Run() {
+    // 先清标记，执行期间的新投递会在之后再执行一次
+    pending_.store(false, std::memory_order_release);
+    int64_t start_time = esp_timer_get_time();
+    work_(arg_);
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_time);
+
+    std::lock_guard<std::mutex> lock(work_mutex);
+    if (running_work != this) {
+        // 工作函数中析构了自身
+        return;
+    }
+    running_work = nullptr;
+    work_done_cv.notify_all();
+
+    statistics_.count++;
+    statistics_.total_us += elapsed_us;
+    if (elapsed_us > budget_us_) {
+        statistics_.over_budget++;
+        // 只在刷新最大值时告警，避免周期性工作刷屏
+        if (elapsed_us > statistics_.max_us) {
+            ESP_LOGW(TAG, "%s took %lu us, budget %lu us", name_, elapsed_us, budget_us_);
+        }
+    }
+    if (elapsed_us > statistics_.max_us) {
+        statistics_.max_us = elapsed_us;
+    }
+}
+
+void DeferredWork::WorkerLoop(void* arg) {
+    {
+        std::lock_guard<std::mutex> lock(work_mutex);
+        worker_task = xTaskGetCurrentTaskHandle();
+    }
+    DeferredWork* work;
+    while (true) {
+        if (xQueueReceive(work_queue, &work, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(work_mutex);
+            // 取出后、加锁前析构的工作项不在链表中，直接丢弃
+            auto p = work_list;
+            while (p != nullptr && p != work) {
+                p = p->next_;
+            }
+            if (p == nullptr) {
+                continue;
+            }
+            running_work = work;
+        }
+        work->Run();
+    }
+}
+
+void DeferredWork::PrintStatistics() {
+    std::lock_guard<std::mutex> lock(work_mutex);
+    for (auto work = work_list; work != nullptr; work = work->next_) {
+        auto& stats = work->statistics_;
+        if (stats.count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Deferred work stats: %s count %lu avg %lu us max %lu us over budget %lu coalesced %lu dropped %lu",
+            work->name_, stats.count, (uint32_t)(stats.total_us / stats.count), stats.max_us, stats.over_budget,
+            work->coalesced_.load(), work->dropped_.load());
+    }
+}
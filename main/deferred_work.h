@@ -0,0 +1,52 @@
+#ifndef DEFERRED_WORK_H
+#define DEFERRED_WORK_H
+
+#include <atomic>
+#include <cstdint>
+
+#define DEFERRED_WORK_QUEUE_LENGTH 16
+#define DEFERRED_WORK_TASK_STACK_SIZE 4096
+// 低于 main_event_loop（3），定时器的重活不抢占主循环
+#define DEFERRED_WORK_TASK_PRIORITY 2
+#define DEFERRED_WORK_DEFAULT_BUDGET_US 2000
+
+struct DeferredWorkStatistics {
+    uint32_t count = 0;
+    uint32_t coalesced = 0;    // 上一次还未执行时再次投递，被合并
+    uint32_t dropped = 0;      // 队列已满
+    uint32_t over_budget = 0;
+    uint64_t total_us = 0;
+    uint32_t max_us = 0;
+};
+
+// 把 esp_timer 回调里的重活挪到 deferred_work 任务：回调里只调用 Post()，不阻塞其他定时器
+// 同一工作项未执行前重复投递会合并为一次；每个工作项单独统计耗时，超过预算时告警
+class DeferredWork {
+public:
+    DeferredWork(const char* name, void (*work)(void* arg), void* arg, uint32_t budget_us = DEFERRED_WORK_DEFAULT_BUDGET_US);
+    ~DeferredWork();
+    DeferredWork(const DeferredWork&) = delete;
+    DeferredWork& operator=(const DeferredWork&) = delete;
+
+    // 可在定时器回调和中断中调用
+    bool Post();
+    const char* name() const { return name_; }
+
+    static void PrintStatistics();
+
+private:
+    const char* name_;
+    void (*work_)(void* arg);
+    void* arg_;
+    uint32_t budget_us_;
+    std::atomic<bool> pending_{false};
+    std::atomic<uint32_t> coalesced_{0};
+    std::atomic<uint32_t> dropped_{0};
+    DeferredWorkStatistics statistics_;
+    DeferredWork* next_ = nullptr;
+
+    static void WorkerLoop(void* arg);
+    void Run();
+};
+
+#endif // DEFERRED_WORK_H
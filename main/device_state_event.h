@@ -1,39 +1,33 @@
 #ifndef _DEVICE_STATE_EVENT_H_
 #define _DEVICE_STATE_EVENT_H_
 
-#include <esp_event.h>
-#include <functional>
-#include <vector>
-#include <mutex>
 #include "device_state.h"
+#include "event_bus.h"
 
-ESP_EVENT_DECLARE_BASE(XIAOZHI_STATE_EVENTS);
+#define DEVICE_STATE_MAX_SUBSCRIBERS 8
 
-enum {
-    XIAOZHI_STATE_CHANGED_EVENT,
-};
-
-struct device_state_event_data_t {
+struct DeviceStateEvent {
     DeviceState previous_state;
     DeviceState current_state;
 };
 
+using DeviceStateEventBus = EventBus<DeviceStateEvent, DEVICE_STATE_MAX_SUBSCRIBERS>;
+
 class DeviceStateEventManager {
 public:
     static DeviceStateEventManager& GetInstance();
     DeviceStateEventManager(const DeviceStateEventManager&) = delete;
     DeviceStateEventManager& operator=(const DeviceStateEventManager&) = delete;
 
-    void RegisterStateChangeCallback(std::function<void(DeviceState, DeviceState)> callback);
+    // 回调在调用 SetDeviceState 的任务（主循环）中同步执行，不要在回调里阻塞
+    bool RegisterStateChangeCallback(DeviceStateEventBus::Callback callback, void* context);
     void PostStateChangeEvent(DeviceState previous_state, DeviceState current_state);
-    std::vector<std::function<void(DeviceState, DeviceState)>> GetCallbacks();
+    void PrintStatistics();
 
 private:
-    DeviceStateEventManager();
-    ~DeviceStateEventManager();
+    DeviceStateEventManager() = default;
 
-    std::vector<std::function<void(DeviceState, DeviceState)>> callbacks_;
-    std::mutex mutex_;
+    DeviceStateEventBus bus_;
 };
 
-#endif // _DEVICE_STATE_EVENT_H_ 
\ No newline at end of file
+#endif // _DEVICE_STATE_EVENT_H_ 
@@ -139,10 +139,9 @@ LcdDisplay::LcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_
     esp_timer_create(&activating_timer_args, &activating_timer_);
 
     DeviceStateEventManager::GetInstance().RegisterStateChangeCallback(
-        [this](DeviceState previous_state, DeviceState current_state) {
-            this->OnDeviceStateChanged(previous_state, current_state);
-        }
-    );
+        [](const DeviceStateEvent& event, void* context) {
+            static_cast<LcdDisplay*>(context)->OnDeviceStateChanged(event.previous_state, event.current_state);
+        }, this);
     
 
     if (text_mode_) {
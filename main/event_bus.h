@@ -0,0 +1,116 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+struct EventBusStatistics {
+    uint32_t published = 0;
+    uint32_t deferred = 0;        // 回调中再次发布、排队到本轮分发之后的事件
+    uint32_t dropped = 0;         // 排队已满而丢弃的事件
+    uint32_t max_fan_out = 0;
+    uint64_t total_dispatch_us = 0;
+    uint32_t max_dispatch_us = 0;
+};
+
+// 定长类型化发布/订阅：订阅者为函数指针 + 上下文，槽位数固定，发布时不分配内存
+// 回调在发布者的任务中同步执行，按订阅顺序调用；回调中再次发布的事件排在本轮之后依次分发，不会递归
+// 其他任务同时发布时在 dispatch_mutex_ 上排队
+template <typename Event, size_t kMaxSubscribers, size_t kMaxDeferred = 4>
+class EventBus {
+public:
+    using Callback = void (*)(const Event& event, void* context);
+
+    // 返回槽位号，槽位已满返回 -1
+    int Subscribe(Callback callback, void* context) {
+        std::lock_guard<std::mutex> lock(subscribe_mutex_);
+        for (size_t i = 0; i < kMaxSubscribers; i++) {
+            if (slots_[i].callback.load(std::memory_order_relaxed) == nullptr) {
+                slots_[i].context = context;
+                slots_[i].callback.store(callback, std::memory_order_release);
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+
+    // 不要与同一槽位的分发并发调用
+    void Unsubscribe(int slot) {
+        if (slot >= 0 && (size_t)slot < kMaxSubscribers) {
+            slots_[slot].callback.store(nullptr, std::memory_order_release);
+        }
+    }
+
+    void Publish(const Event& event) {
+        if (dispatching_task_.load(std::memory_order_acquire) == xTaskGetCurrentTaskHandle()) {
+            if (deferred_count_ == kMaxDeferred) {
+                statistics_.dropped++;
+                return;
+            }
+            deferred_[(deferred_head_ + deferred_count_) % kMaxDeferred] = event;
+            deferred_count_++;
+            statistics_.deferred++;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        dispatching_task_.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+        Dispatch(event);
+        while (deferred_count_ > 0) {
+            Event next = deferred_[deferred_head_];
+            deferred_head_ = (deferred_head_ + 1) % kMaxDeferred;
+            deferred_count_--;
+            Dispatch(next);
+        }
+        dispatching_task_.store(nullptr, std::memory_order_release);
+    }
+
+    EventBusStatistics GetStatistics() {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        return statistics_;
+    }
+
+private:
+    struct Slot {
+        std::atomic<Callback> callback {nullptr};
+        void* context = nullptr;
+    };
+
+    Slot slots_[kMaxSubscribers];
+    std::mutex subscribe_mutex_;
+    std::mutex dispatch_mutex_;
+    std::atomic<TaskHandle_t> dispatching_task_ {nullptr};
+    Event deferred_[kMaxDeferred] = {};
+    size_t deferred_head_ = 0;
+    size_t deferred_count_ = 0;
+    EventBusStatistics statistics_;
+
+    void Dispatch(const Event& event) {
+        int64_t start_time = esp_timer_get_time();
+        uint32_t fan_out = 0;
+        for (size_t i = 0; i < kMaxSubscribers; i++) {
+            auto callback = slots_[i].callback.load(std::memory_order_acquire);
+            if (callback != nullptr) {
+                callback(event, slots_[i].context);
+                fan_out++;
+            }
+        }
+        uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_time);
+        statistics_.published++;
+        statistics_.total_dispatch_us += elapsed_us;
+        if (elapsed_us > statistics_.max_dispatch_us) {
+            statistics_.max_dispatch_us = elapsed_us;
+        }
+        if (fan_out > statistics_.max_fan_out) {
+            statistics_.max_fan_out = fan_out;
+        }
+    }
+};
+
+#endif // EVENT_BUS_H
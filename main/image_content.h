@@ -0,0 +1,94 @@
+#ifndef IMAGE_CONTENT_H
+#define IMAGE_CONTENT_H
+
+#include <string>
+#include <algorithm>
+#include <mbedtls/base64.h>
+
+// MCP tool 返回的图片内容，序列化时直接拼接 JSON 文本，输出与 cJSON_PrintUnformatted 一致
+class ImageContent {
+private:
+    std::string data_;
+    std::string mime_type_;
+
+    static constexpr size_t kBase64ChunkSize = 3 * 1024;  // 3 的倍数，块之间不会产生填充
+
+    size_t encoded_size() const { return (data_.size() + 2) / 3 * 4; }
+
+    // base64 按块直接编码到 out 尾部，不生成中间字符串
+    void AppendBase64(std::string& out) const {
+        size_t offset = out.size();
+        size_t encoded = encoded_size();
+        // mbedtls 会在每块末尾写 '\0'，多预留一个字节，最后截掉
+        out.resize(offset + encoded + 1);
+        auto dst = (unsigned char*)&out[offset];
+        auto src = (const unsigned char*)data_.data();
+        for (size_t i = 0; i < data_.size(); i += kBase64ChunkSize) {
+            size_t length = std::min(kBase64ChunkSize, data_.size() - i);
+            size_t olen = 0;
+            mbedtls_base64_encode(dst, encoded + 1 - (dst - (unsigned char*)&out[offset]), &olen, src + i, length);
+            dst += olen;
+        }
+        out.resize(offset + encoded);
+    }
+
+public:
+    ImageContent(const std::string& mime_type, std::string data)
+        : data_(std::move(data)), mime_type_(mime_type) {}
+
+    // 与 cJSON_PrintUnformatted 的转义规则一致，追加到 out（不含引号）
+    static void AppendEscaped(std::string& out, const std::string& text) {
+        static const char hex[] = "0123456789abcdef";
+        for (unsigned char c : text) {
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out += hex[c >> 4];
+                    out += hex[c & 0xF];
+                } else {
+                    out += (char)c;
+                }
+                break;
+            }
+        }
+    }
+
+    // {"type":"image","mimeType":"...","data":"<base64>"}
+    std::string to_json() const {
+        std::string json;
+        json.reserve(encoded_size() + mime_type_.size() + 48);
+        json = "{\"type\":\"image\",\"mimeType\":\"";
+        AppendEscaped(json, mime_type_);
+        json += "\",\"data\":\"";
+        AppendBase64(json);
+        json += "\"}";
+        return json;
+    }
+
+    // 把 to_json() 作为 JSON 字符串值（已转义、不含引号）追加到 out；base64 字符无需转义，直接编码进 out
+    void AppendAsJsonString(std::string& out) const {
+        std::string mime_type;
+        AppendEscaped(mime_type, mime_type_);
+        out.reserve(out.size() + json_string_size());
+        out += "{\\\"type\\\":\\\"image\\\",\\\"mimeType\\\":\\\"";
+        AppendEscaped(out, mime_type);
+        out += "\\\",\\\"data\\\":\\\"";
+        AppendBase64(out);
+        out += "\\\"}";
+    }
+
+    // AppendAsJsonString 输出长度的上界
+    size_t json_string_size() const {
+        return encoded_size() + mime_type_.size() * 12 + 64;
+    }
+};
+
+#endif // IMAGE_CONTENT_H
@@ -27,10 +27,7 @@ CircularStrip::CircularStrip(gpio_num_t gpio, uint8_t max_leds) : max_leds_(max_
     esp_timer_create_args_t strip_timer_args = {
         .callback = [](void *arg) {
             auto strip = static_cast<CircularStrip*>(arg);
-            std::lock_guard<std::mutex> lock(strip->mutex_);
-            if (strip->strip_callback_ != nullptr) {
-                strip->strip_callback_();
-            }
+            strip->strip_work_.Post();
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -40,6 +37,14 @@ CircularStrip::CircularStrip(gpio_num_t gpio, uint8_t max_leds) : max_leds_(max_
     ESP_ERROR_CHECK(esp_timer_create(&strip_timer_args, &strip_timer_));
 }
 
+void CircularStrip::OnStripTimer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 投递之后动画可能已被停止（切换成常亮等），此时不再刷新
+    if (strip_callback_ != nullptr && esp_timer_is_active(strip_timer_)) {
+        strip_callback_();
+    }
+}
+
 CircularStrip::~CircularStrip() {
     esp_timer_stop(strip_timer_);
     if (led_strip_ != nullptr) {
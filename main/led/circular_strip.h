@@ -2,6 +2,7 @@
 #define _CIRCULAR_STRIP_H_
 
 #include "led.h"
+#include "deferred_work.h"
 #include <driver/gpio.h>
 #include <led_strip.h>
 #include <esp_timer.h>
@@ -39,11 +40,15 @@ private:
     int blink_interval_ms_ = 0;
     esp_timer_handle_t strip_timer_ = nullptr;
     std::function<void()> strip_callback_ = nullptr;
+    DeferredWork strip_work_{"strip_animation", [](void* arg) {
+        static_cast<CircularStrip*>(arg)->OnStripTimer();
+    }, this};
 
     uint8_t default_brightness_ = DEFAULT_BRIGHTNESS;
     uint8_t low_brightness_ = LOW_BRIGHTNESS;
 
     void StartStripTask(int interval_ms, std::function<void()> cb);
+    void OnStripTimer();
     void Rainbow(StripColor low, StripColor high, int interval_ms);
     void FadeOut(int interval_ms);
 };
@@ -9,6 +9,7 @@
 
 #include "application.h"
 #include "system_info.h"
+#include "cjson_arena.h"
 
 #define TAG "main"
 
@@ -26,6 +27,9 @@ extern "C" void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
+    // cJSON 分配钩子需要在任何 cJSON 调用之前安装
+    CJsonArena::Initialize();
+
     // Launch the application
     auto& app = Application::GetInstance();
     app.Start();
@@ -9,6 +9,9 @@
  #include <algorithm>
  #include <cstring>
  #include <esp_pthread.h>
+ #include <esp_timer.h>
+ #include <esp_heap_caps.h>
+ #include <atomic>
  
 #include "application.h"
 #include "display.h"
@@ -22,6 +25,62 @@
  
  #define TAG "MCP"
  
+ // 请求统计会在主循环和工作线程中同时更新
+ static std::mutex statistics_mutex;
+ 
+ // 局部最低水位监控是全局的，同一时间只允许一个请求使用
+ static std::atomic<bool> heap_monitor_busy {false};
+ 
+ // 请求计量：耗时，以及请求期间内部 RAM 的最大占用；并发请求时后来者只统计耗时
+ class McpRequestMeter {
+ public:
+     explicit McpRequestMeter(int64_t start_time_us = 0)
+         : start_time_us_(start_time_us != 0 ? start_time_us : esp_timer_get_time()) {
+         bool expected = false;
+         if (heap_monitor_busy.compare_exchange_strong(expected, true)) {
+             free_at_start_ = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+             monitoring_ = heap_caps_monitor_local_minimum_free_size_start() == ESP_OK;
+             if (!monitoring_) {
+                 heap_monitor_busy = false;
+             }
+         }
+     }
+ 
+     ~McpRequestMeter() {
+         StopMonitor();
+     }
+ 
+     void Finish(McpRequestStatistics& stats) {
+         uint32_t latency_us = esp_timer_get_time() - start_time_us_;
+         std::lock_guard<std::mutex> lock(statistics_mutex);
+         stats.count++;
+         stats.total_latency_us += latency_us;
+         if (latency_us > stats.max_latency_us) {
+             stats.max_latency_us = latency_us;
+         }
+         if (monitoring_) {
+             size_t minimum_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+             if (minimum_free < free_at_start_ && free_at_start_ - minimum_free > stats.max_heap_used) {
+                 stats.max_heap_used = free_at_start_ - minimum_free;
+             }
+         }
+         StopMonitor();
+     }
+ 
+ private:
+     int64_t start_time_us_;
+     size_t free_at_start_ = 0;
+     bool monitoring_ = false;
+ 
+     void StopMonitor() {
+         if (monitoring_) {
+             heap_caps_monitor_local_minimum_free_size_stop();
+             monitoring_ = false;
+             heap_monitor_busy = false;
+         }
+     }
+ };
+ 
  McpServer::McpServer() {
  }
  
@@ -176,7 +235,8 @@
                 }
             });
 #else
-        AddTool("self.camera.take_photo",
+        // 拍照、JPEG 编码与上传耗时较长，放到工作线程执行，不阻塞主循环
+        auto take_photo = new McpTool("self.camera.take_photo",
             "拍照并根据用户问题进行解释/分析。\n"
             "适用场景：用户让你“看看/拍照/识别/描述画面”等。\n"
             "参数：\n"
@@ -193,9 +253,15 @@
                 if (!camera->Capture()) {
                     throw std::runtime_error("Failed to capture photo");
                 }
+                // 拍照期间已超时，不再上传
+                if (McpServer::IsToolCallCancelled()) {
+                    throw std::runtime_error("Tool call cancelled");
+                }
                 auto question = properties["question"].value<std::string>();
                 return camera->Explain(question);
             });
+        take_photo->set_concurrency(kMcpToolCamera, 60000);
+        AddTool(take_photo);
 #endif
      }
  #endif
@@ -236,6 +302,7 @@
  
      // Restore the original tools list to the end of the tools list
      tools_.insert(tools_.end(), original_tools.begin(), original_tools.end());
+     InvalidateToolsList();
  }
  
  void McpServer::AddUserOnlyTools() {
@@ -248,6 +315,13 @@
             return board.GetSystemInfoJson();
         });
 
+    AddUserOnlyTool("self.get_boot_timeline",
+        "获取本次启动各步骤相对上电后的起止时间（毫秒），用于分析启动耗时。",
+        PropertyList(),
+        [](const PropertyList& properties) -> ReturnValue {
+            return Application::GetInstance().GetBootTimelineJson();
+        });
+
     AddUserOnlyTool("self.reboot", "重启设备。",
         PropertyList(),
         [](const PropertyList& properties) -> ReturnValue {
@@ -423,20 +497,28 @@
  
  void McpServer::AddTool(McpTool* tool) {
      // Prevent adding duplicate tools
-     if (std::find_if(tools_.begin(), tools_.end(), [tool](const McpTool* t) { return t->name() == tool->name(); }) != tools_.end()) {
-         ESP_LOGW(TAG, "Tool %s already added", tool->name().c_str());
+     if (tool_index_.find(tool->name()) != tool_index_.end()) {
+         ESP_LOGW(TAG, "Tool %s already added", tool->name());
          return;
      }
  
-     ESP_LOGI(TAG, "Add tool: %s%s", tool->name().c_str(), tool->user_only() ? " [user]" : "");
+     ESP_LOGI(TAG, "Add tool: %s%s", tool->name(), tool->user_only() ? " [user]" : "");
      tools_.push_back(tool);
+     tool_index_.emplace(tool->name(), tool);
+     InvalidateToolsList();
  }
  
- void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
+ void McpServer::InvalidateToolsList() {
+     std::lock_guard<std::mutex> lock(tools_list_mutex_);
+     tools_list_cache_[0].clear();
+     tools_list_cache_[1].clear();
+ }
+ 
+ void McpServer::AddTool(const char* name, const char* description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
      AddTool(new McpTool(name, description, properties, callback));
  }
  
- void McpServer::AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
+ void McpServer::AddUserOnlyTool(const char* name, const char* description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
      auto tool = new McpTool(name, description, properties, callback);
      tool->set_user_only(true);
      AddTool(tool);
@@ -557,11 +639,23 @@
  }
  
  void McpServer::ReplyResult(int id, const std::string& result) {
-     std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
-     payload += std::to_string(id) + ",\"result\":";
+     std::string payload = BeginReplyResult(id);
+     payload.reserve(payload.size() + result.size() + MCP_REPLY_HEADROOM);
      payload += result;
+     FinishReplyResult(std::move(payload));
+ }
+ 
+ std::string McpServer::BeginReplyResult(int id) {
+     std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
+     payload += std::to_string(id);
+     payload += ",\"result\":";
+     return payload;
+ }
+ 
+ void McpServer::FinishReplyResult(std::string payload) {
+     // 图片结果可能有上百 KB，整个回复只在这一个缓冲中，一路移交到协议层
      payload += "}";
-     Application::GetInstance().SendMcpMessage(payload);
+     Application::GetInstance().SendMcpMessage(std::move(payload));
  }
  
  void McpServer::ReplyError(int id, const std::string& message) {
@@ -574,8 +668,30 @@
  }
  
  void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_only_tools) {
+     McpRequestMeter meter;
+     std::lock_guard<std::mutex> lock(tools_list_mutex_);
+     auto& cache = tools_list_cache_[list_user_only_tools ? 1 : 0];
+     auto it = cache.find(cursor);
+     if (it == cache.end()) {
+         it = cache.emplace(cursor, BuildToolsListPage(cursor, list_user_only_tools)).first;
+     }
+ 
+     const auto& page = it->second;
+     if (!page.error.empty()) {
+         ESP_LOGE(TAG, "tools/list: %s", page.error.c_str());
+         ReplyError(id, page.error);
+     } else {
+         ReplyResult(id, page.result);
+     }
+     meter.Finish(tools_list_statistics_);
+ }
+ 
+ // 调用方持有 tools_list_mutex_
+ McpToolsListPage McpServer::BuildToolsListPage(const std::string& cursor, bool list_user_only_tools) {
      const int max_payload_size = 8000;
-     std::string json = "{\"tools\":[";
+     McpToolsListPage page;
+     std::string& json = page.result;
+     json = "{\"tools\":[";
      
      bool found_cursor = cursor.empty();
      auto it = tools_.begin();
@@ -597,15 +713,23 @@
              continue;
          }
          
+         // tool 的描述只序列化一次，在竞技场中生成
+         auto cached = tool_json_cache_.find(*it);
+         if (cached == tool_json_cache_.end()) {
+             CJsonArenaScope arena;
+             cached = tool_json_cache_.emplace(*it, (*it)->to_json()).first;
+         }
+         const std::string& tool_json = cached->second;
+ 
          // 添加tool前检查大小
-         std::string tool_json = (*it)->to_json() + ",";
-         if (json.length() + tool_json.length() + 30 > max_payload_size) {
+         if (json.length() + tool_json.length() + 31 > max_payload_size) {
              // 如果添加这个tool会超出大小限制，设置next_cursor并退出循环
              next_cursor = (*it)->name();
              break;
          }
          
          json += tool_json;
+         json += ',';
          ++it;
      }
      
@@ -615,9 +739,8 @@
      
      if (json.back() == '[' && !tools_.empty()) {
          // 如果没有添加任何tool，返回错误
-         ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
-         ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
-         return;
+         page.error = "Failed to add tool " + next_cursor + " because of payload size limit";
+         return page;
      }
  
      if (next_cursor.empty()) {
@@ -625,23 +748,20 @@
      } else {
          json += "],\"nextCursor\":\"" + next_cursor + "\"}";
      }
-     
-     ReplyResult(id, json);
+     return page;
  }
  
  void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments) {
-     auto tool_iter = std::find_if(tools_.begin(), tools_.end(), 
-                                  [&tool_name](const McpTool* tool) { 
-                                      return tool->name() == tool_name; 
-                                  });
-     
-     if (tool_iter == tools_.end()) {
+     int64_t start_time_us = esp_timer_get_time();
+     auto tool_iter = tool_index_.find(tool_name);
+     if (tool_iter == tool_index_.end()) {
          ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
          ReplyError(id, "Unknown tool: " + tool_name);
          return;
      }
  
-     PropertyList arguments = (*tool_iter)->properties();
+     McpTool* tool = tool_iter->second;
+     PropertyList arguments = tool->properties();
      try {
          for (auto& argument : arguments) {
              bool found = false;
@@ -671,15 +791,233 @@
          return;
      }
  
+     if (tool->concurrency() != kMcpToolMainLoop) {
+         auto call = std::make_shared<McpToolCall>();
+         call->id = id;
+         call->tool = tool;
+         call->arguments = std::move(arguments);
+         call->start_time_us = start_time_us;
+         call->deadline_us = start_time_us + (int64_t)tool->timeout_ms() * 1000;
+         StartToolWorker(tool->concurrency());
+         {
+             std::lock_guard<std::mutex> lock(call_mutex_);
+             pending_calls_.push_back(call);
+             active_calls_.push_back(call);
+         }
+         call_cv_.notify_all();
+         return;
+     }
+ 
      // Use main thread to call the tool
      auto& app = Application::GetInstance();
-     app.Schedule([this, id, tool_iter, arguments = std::move(arguments)]() {
+     app.Schedule([this, id, tool, start_time_us, arguments = std::move(arguments)]() {
+         McpRequestMeter meter(start_time_us);
+         int64_t call_start_us = esp_timer_get_time();
          try {
-             ReplyResult(id, (*tool_iter)->Call(arguments));
+             std::string payload = BeginReplyResult(id);
+             tool->Call(arguments, payload);
+             FinishReplyResult(std::move(payload));
          } catch (const std::exception& e) {
              ESP_LOGE(TAG, "tools/call: %s", e.what());
              ReplyError(id, e.what());
          }
+         uint32_t stall_us = esp_timer_get_time() - call_start_us;
+         std::unique_lock<std::mutex> lock(statistics_mutex);
+         auto& stall = tools_stall_statistics_;
+         stall.main_loop_calls++;
+         stall.main_loop_total_us += stall_us;
+         if (stall_us > stall.main_loop_max_us) {
+             stall.main_loop_max_us = stall_us;
+         }
+         lock.unlock();
+         meter.Finish(tools_call_statistics_);
      });
  }
- 
\ No newline at end of file
+ 
+ // 当前工作线程正在执行的调用，供 IsToolCallCancelled 查询
+ static thread_local McpToolCall* current_tool_call = nullptr;
+ 
+ bool McpServer::IsToolCallCancelled() {
+     return current_tool_call != nullptr && current_tool_call->cancelled.load();
+ }
+ 
+ void McpServer::StartToolWorker(McpToolConcurrency concurrency) {
+     std::lock_guard<std::mutex> lock(call_mutex_);
+     if (concurrency_worker_[concurrency]) {
+         return;
+     }
+     // 同类别串行执行，线程数不超过用到的类别数即可
+     concurrency_worker_[concurrency] = true;
+     xTaskCreate([](void* arg) {
+         ((McpServer*)arg)->ToolWorkerLoop();
+         vTaskDelete(NULL);
+     }, "mcp_tool", MCP_TOOL_WORKER_STACK_SIZE, this, 2, nullptr);
+
+     if (deadline_timer_ != nullptr) {
+         return;
+     }
+     // 超时处理会回复消息，放到主循环执行，不占用共享的 esp_timer 任务
+     esp_timer_create_args_t timer_args = {
+         .callback = [](void* arg) {
+             auto server = (McpServer*)arg;
+             // 周期检查，通道满时跳过这一次即可
+             Application::GetInstance().ScheduleFromISR([server]() {
+                 server->CheckToolCallDeadlines();
+             });
+         },
+         .arg = this,
+         .dispatch_method = ESP_TIMER_TASK,
+         .name = "mcp_deadline",
+         .skip_unhandled_events = true,
+     };
+     esp_timer_create(&timer_args, &deadline_timer_);
+     esp_timer_start_periodic(deadline_timer_, 500 * 1000);
+ }
+ 
+ void McpServer::ToolWorkerLoop() {
+     while (true) {
+         std::shared_ptr<McpToolCall> call;
+         {
+             std::unique_lock<std::mutex> lock(call_mutex_);
+             // 取第一个所属类别空闲的调用，同类别的调用按到达顺序串行
+             auto runnable = [this]() {
+                 return std::find_if(pending_calls_.begin(), pending_calls_.end(), [this](const std::shared_ptr<McpToolCall>& c) {
+                     return !concurrency_busy_[c->tool->concurrency()];
+                 });
+             };
+             call_cv_.wait(lock, [&]() { return runnable() != pending_calls_.end(); });
+             auto it = runnable();
+             call = *it;
+             pending_calls_.erase(it);
+             concurrency_busy_[call->tool->concurrency()] = true;
+         }
+ 
+         RunToolCall(call);
+ 
+         {
+             std::lock_guard<std::mutex> lock(call_mutex_);
+             concurrency_busy_[call->tool->concurrency()] = false;
+         }
+         FinishToolCall(call);
+         call_cv_.notify_all();
+     }
+ }
+ 
+ void McpServer::RunToolCall(const std::shared_ptr<McpToolCall>& call) {
+     if (call->cancelled) {
+         // 排队期间已超时，不再执行
+         return;
+     }
+ 
+     McpRequestMeter meter(call->start_time_us);
+     current_tool_call = call.get();
+     std::string payload = BeginReplyResult(call->id);
+     std::string error;
+     try {
+         call->tool->Call(call->arguments, payload);
+     } catch (const std::exception& e) {
+         ESP_LOGE(TAG, "tools/call: %s", e.what());
+         error = e.what();
+     }
+     current_tool_call = nullptr;
+ 
+     // 结果按完成顺序回复，与请求顺序无关
+     bool late = call->replied.exchange(true);
+     if (late) {
+         ESP_LOGW(TAG, "tools/call: %s finished after timeout, result dropped", call->tool->name());
+     } else if (error.empty()) {
+         FinishReplyResult(std::move(payload));
+     } else {
+         ReplyError(call->id, error);
+     }
+     {
+         std::lock_guard<std::mutex> lock(statistics_mutex);
+         tools_stall_statistics_.worker_calls++;
+         if (late) {
+             tools_stall_statistics_.late_results++;
+         }
+     }
+     meter.Finish(tools_call_statistics_);
+ }
+ 
+ void McpServer::FinishToolCall(const std::shared_ptr<McpToolCall>& call) {
+     std::lock_guard<std::mutex> lock(call_mutex_);
+     auto it = std::find(active_calls_.begin(), active_calls_.end(), call);
+     if (it != active_calls_.end()) {
+         active_calls_.erase(it);
+     }
+ }
+ 
+ void McpServer::CheckToolCallDeadlines() {
+     int64_t now = esp_timer_get_time();
+     // 超时的调用先在锁内摘出，回复放到释放 call_mutex_ 之后，发送不会阻塞工作线程取任务
+     std::vector<std::shared_ptr<McpToolCall>> expired;
+     {
+         std::lock_guard<std::mutex> lock(call_mutex_);
+         for (auto it = active_calls_.begin(); it != active_calls_.end();) {
+             auto& call = *it;
+             if (now < call->deadline_us || call->replied.exchange(true)) {
+                 ++it;
+                 continue;
+             }
+             call->cancelled = true;
+             expired.push_back(call);
+ 
+             // 尚未开始执行的调用直接出队；正在执行的调用在完成后移出
+             auto pending = std::find(pending_calls_.begin(), pending_calls_.end(), call);
+             if (pending != pending_calls_.end()) {
+                 pending_calls_.erase(pending);
+                 it = active_calls_.erase(it);
+             } else {
+                 ++it;
+             }
+         }
+     }
+     if (expired.empty()) {
+         return;
+     }
+ 
+     {
+         std::lock_guard<std::mutex> stats_lock(statistics_mutex);
+         tools_stall_statistics_.timeouts += expired.size();
+     }
+     for (auto& call : expired) {
+         ESP_LOGW(TAG, "tools/call: %s timed out after %d ms", call->tool->name(), call->tool->timeout_ms());
+         ReplyError(call->id, std::string("Tool call timed out: ") + call->tool->name());
+     }
+ }
+ 
+ void McpServer::PrintToolsMemory() {
+     size_t text_size = 0;
+     size_t owned_text_size = 0;
+     for (auto tool : tools_) {
+         text_size += tool->text_size();
+         owned_text_size += tool->owned_text_size();
+     }
+     ESP_LOGI(TAG, "tools %u: name/description %u bytes, %u bytes in flash, %u bytes copied to heap",
+         tools_.size(), text_size, text_size - owned_text_size, owned_text_size);
+ }
+ 
+ void McpServer::PrintStatistics() {
+     const struct {
+         const char* name;
+         const McpRequestStatistics& stats;
+     } entries[] = {
+         {"tools/list", tools_list_statistics_},
+         {"tools/call", tools_call_statistics_},
+     };
+     for (const auto& entry : entries) {
+         if (entry.stats.count == 0) {
+             continue;
+         }
+         ESP_LOGI(TAG, "%s: count %lu avg %lu us max %lu us heap peak %u bytes", entry.name, entry.stats.count,
+             (uint32_t)(entry.stats.total_latency_us / entry.stats.count), entry.stats.max_latency_us, entry.stats.max_heap_used);
+     }
+ 
+     auto& stall = tools_stall_statistics_;
+     if (stall.main_loop_calls + stall.worker_calls + stall.timeouts > 0) {
+         ESP_LOGI(TAG, "tools/call: main loop %lu calls stall total %lu us max %lu us, worker %lu calls, timeouts %lu, late results %lu",
+             stall.main_loop_calls, (uint32_t)stall.main_loop_total_us, stall.main_loop_max_us,
+             stall.worker_calls, stall.timeouts, stall.late_results);
+     }
+ }
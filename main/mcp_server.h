@@ -9,46 +9,40 @@
 #include <optional>
 #include <stdexcept>
 #include <thread>
-#include <mbedtls/base64.h>
+#include <mutex>
+#include <unordered_map>
+#include <string_view>
+#include <cstring>
+#include <deque>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <esp_memory_utils.h>
+#include <esp_timer.h>
 
 #include <cJSON.h>
 
-class ImageContent {
-private:
-    std::string encoded_data_;
-    std::string mime_type_;
-
-    static std::string Base64Encode(const std::string& data) {
-        size_t dlen = 0, olen = 0;
-        mbedtls_base64_encode((unsigned char*)nullptr, 0, &dlen, (const unsigned char*)data.data(), data.size());
-        std::string result(dlen, 0);
-        mbedtls_base64_encode((unsigned char*)result.data(), result.size(), &olen, (const unsigned char*)data.data(), data.size());
-        return result;
-    }
-
-public:
-    ImageContent(const std::string& mime_type, const std::string& data) {
-        mime_type_ = mime_type;
-        // base64 encode data
-        encoded_data_ = Base64Encode(data);
-    }
-
-    std::string to_json() const {
-        cJSON *json = cJSON_CreateObject();
-        cJSON_AddStringToObject(json, "type", "image");
-        cJSON_AddStringToObject(json, "mimeType", mime_type_.c_str());
-        cJSON_AddStringToObject(json, "data", encoded_data_.c_str());
-        char* json_str = cJSON_PrintUnformatted(json);
-        std::string result(json_str);
-        cJSON_free(json_str);
-        cJSON_Delete(json);
-        return result;
-    }
-};
+#include "cjson_arena.h"
+#include "image_content.h"
 
 // 添加类型别名
 using ReturnValue = std::variant<bool, int, std::string, cJSON*, ImageContent*>;
 
+// tools/call 工作线程与超时；同一并发类别的 tool 串行执行，不同类别之间并行，
+// 每个实际收到调用的类别才创建一个工作线程
+#define MCP_TOOL_WORKER_STACK_SIZE (4096 * 2)
+#define MCP_TOOL_DEFAULT_TIMEOUT_MS 30000
+// 图片结果预留的尾部空间：结果与 JSON-RPC 收尾，以及 Protocol::SendMcpMessage 原地插入的会话包头
+#define MCP_REPLY_HEADROOM 192
+
+enum McpToolConcurrency {
+    kMcpToolMainLoop,   // 在主事件循环中执行（默认），可直接操作设备状态和显示
+    kMcpToolCamera,     // 拍照、编码与上传
+    kMcpToolNetwork,    // 其他耗时的网络请求
+    kMcpToolConcurrencyCount
+};
+
 enum PropertyType {
     kPropertyTypeBoolean,
     kPropertyTypeInteger,
@@ -207,34 +201,59 @@ public:
 
 class McpTool {
 private:
-    std::string name_;
-    std::string description_;
+    // 名称和描述是 flash 中的字面量时直接引用，其他来源的字符串才拷贝到 owned_* 中
+    std::string owned_name_;
+    std::string owned_description_;
+    const char* name_;
+    const char* description_;
     PropertyList properties_;
     std::function<ReturnValue(const PropertyList&)> callback_;
     bool user_only_ = false;
+    McpToolConcurrency concurrency_ = kMcpToolMainLoop;
+    int timeout_ms_ = MCP_TOOL_DEFAULT_TIMEOUT_MS;
+
+    static const char* StoreText(const char* text, std::string& owned) {
+        if (esp_ptr_in_drom(text)) {
+            return text;
+        }
+        owned = text;
+        return owned.c_str();
+    }
 
 public:
-    McpTool(const std::string& name, 
-            const std::string& description, 
+    McpTool(const char* name, 
+            const char* description, 
             const PropertyList& properties, 
             std::function<ReturnValue(const PropertyList&)> callback)
-        : name_(name), 
-        description_(description), 
+        : name_(StoreText(name, owned_name_)), 
+        description_(StoreText(description, owned_description_)), 
         properties_(properties), 
         callback_(callback) {}
+    McpTool(const McpTool&) = delete;
+    McpTool& operator=(const McpTool&) = delete;
 
     void set_user_only(bool user_only) { user_only_ = user_only; }
-    inline const std::string& name() const { return name_; }
-    inline const std::string& description() const { return description_; }
+    // 非主循环类别的 tool 在工作线程中执行，超过 timeout_ms 后回复超时错误并置位取消标志
+    void set_concurrency(McpToolConcurrency concurrency, int timeout_ms = MCP_TOOL_DEFAULT_TIMEOUT_MS) {
+        concurrency_ = concurrency;
+        timeout_ms_ = timeout_ms;
+    }
+    inline McpToolConcurrency concurrency() const { return concurrency_; }
+    inline int timeout_ms() const { return timeout_ms_; }
+    inline const char* name() const { return name_; }
+    inline const char* description() const { return description_; }
     inline const PropertyList& properties() const { return properties_; }
     inline bool user_only() const { return user_only_; }
+    // 拷贝到堆上的文本字节数，字面量注册的 tool 为 0
+    inline size_t owned_text_size() const { return owned_name_.size() + owned_description_.size(); }
+    inline size_t text_size() const { return strlen(name_) + strlen(description_); }
 
     std::string to_json() const {
         std::vector<std::string> required = properties_.GetRequired();
         
         cJSON *json = cJSON_CreateObject();
-        cJSON_AddStringToObject(json, "name", name_.c_str());
-        cJSON_AddStringToObject(json, "description", description_.c_str());
+        cJSON_AddStringToObject(json, "name", name_);
+        cJSON_AddStringToObject(json, "description", description_);
         
         cJSON *input_schema = cJSON_CreateObject();
         cJSON_AddStringToObject(input_schema, "type", "object");
@@ -269,48 +288,85 @@ public:
         return result;
     }
 
-    std::string Call(const PropertyList& properties) {
+    // 结果追加到 out 尾部，out 通常已是 JSON-RPC 回复的包头，图片结果不再整体拷贝
+    void Call(const PropertyList& properties, std::string& out) {
         ReturnValue return_value = callback_(properties);
-        // 返回结果
-        cJSON* result = cJSON_CreateObject();
-        cJSON* content = cJSON_CreateArray();
-
         if (std::holds_alternative<ImageContent*>(return_value)) {
+            // 图片结果直接拼接：base64 按块编码进最终发送的字符串，不经过 cJSON 的多次拷贝，输出与 cJSON 版本一致
             auto image_content = std::get<ImageContent*>(return_value);
-            cJSON* image = cJSON_CreateObject();
-            cJSON_AddStringToObject(image, "type", "image");
-            cJSON_AddStringToObject(image, "image", image_content->to_json().c_str());
-            cJSON_AddItemToArray(content, image);
+            out.reserve(out.size() + image_content->json_string_size() + MCP_REPLY_HEADROOM);
+            out += "{\"content\":[{\"type\":\"image\",\"image\":\"";
+            image_content->AppendAsJsonString(out);
+            out += "\"}],\"isError\":false}";
             delete image_content;
-        } else {
-            cJSON* text = cJSON_CreateObject();
-            cJSON_AddStringToObject(text, "type", "text");
-            if (std::holds_alternative<std::string>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::get<std::string>(return_value).c_str());
-            } else if (std::holds_alternative<bool>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::get<bool>(return_value) ? "true" : "false");
-            } else if (std::holds_alternative<int>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::to_string(std::get<int>(return_value)).c_str());
-            } else if (std::holds_alternative<cJSON*>(return_value)) {
-                cJSON* json = std::get<cJSON*>(return_value);
-                char* json_str = cJSON_PrintUnformatted(json);
-                cJSON_AddStringToObject(text, "text", json_str);
-                cJSON_free(json_str);
-                cJSON_Delete(json);
-            }
-            cJSON_AddItemToArray(content, text);
+            return;
+        }
+
+        // 返回结果，组装过程中的 cJSON 节点在竞技场中分配，返回前整体回收
+        CJsonArenaScope arena;
+        cJSON* result = cJSON_CreateObject();
+        cJSON* content = cJSON_CreateArray();
+
+        cJSON* text = cJSON_CreateObject();
+        cJSON_AddStringToObject(text, "type", "text");
+        if (std::holds_alternative<std::string>(return_value)) {
+            cJSON_AddStringToObject(text, "text", std::get<std::string>(return_value).c_str());
+        } else if (std::holds_alternative<bool>(return_value)) {
+            cJSON_AddStringToObject(text, "text", std::get<bool>(return_value) ? "true" : "false");
+        } else if (std::holds_alternative<int>(return_value)) {
+            cJSON_AddStringToObject(text, "text", std::to_string(std::get<int>(return_value)).c_str());
+        } else if (std::holds_alternative<cJSON*>(return_value)) {
+            cJSON* json = std::get<cJSON*>(return_value);
+            char* json_str = cJSON_PrintUnformatted(json);
+            cJSON_AddStringToObject(text, "text", json_str);
+            cJSON_free(json_str);
+            cJSON_Delete(json);
         }
+        cJSON_AddItemToArray(content, text);
         cJSON_AddItemToObject(result, "content", content);
         cJSON_AddBoolToObject(result, "isError", false);
 
         auto json_str = cJSON_PrintUnformatted(result);
-        std::string result_str(json_str);
+        out += json_str;
         cJSON_free(json_str);
         cJSON_Delete(result);
-        return result_str;
     }
 };
 
+struct McpRequestStatistics {
+    uint32_t count = 0;
+    uint64_t total_latency_us = 0;
+    uint32_t max_latency_us = 0;
+    size_t max_heap_used = 0;   // 请求期间内部 RAM 相对请求开始时的最大占用
+};
+
+// tools/call 对主循环的占用
+struct McpToolStallStatistics {
+    uint32_t main_loop_calls = 0;
+    uint64_t main_loop_total_us = 0;
+    uint32_t main_loop_max_us = 0;
+    uint32_t worker_calls = 0;
+    uint32_t timeouts = 0;
+    uint32_t late_results = 0;   // 超时后才完成、被丢弃的结果
+};
+
+// 一次在工作线程中执行的 tool 调用；cancelled 为取消令牌，replied 保证结果与超时错误只回复其一
+struct McpToolCall {
+    int id = 0;
+    McpTool* tool = nullptr;
+    PropertyList arguments;
+    int64_t start_time_us = 0;
+    int64_t deadline_us = 0;
+    std::atomic<bool> cancelled {false};
+    std::atomic<bool> replied {false};
+};
+
+// tools/list 的一页结果，按请求的 cursor 缓存
+struct McpToolsListPage {
+    std::string result;         // 完整的 result JSON，error 非空时无效
+    std::string error;
+};
+
 class McpServer {
 public:
     static McpServer& GetInstance() {
@@ -321,10 +377,21 @@ public:
     void AddCommonTools();
     void AddUserOnlyTools();
     void AddTool(McpTool* tool);
-    void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
-    void AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    // 名称和描述传字面量时直接引用 flash 中的文本，不占用堆
+    void AddTool(const char* name, const char* description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    void AddUserOnlyTool(const char* name, const char* description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
+        AddTool(name.c_str(), description.c_str(), properties, callback);
+    }
+    void AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
+        AddUserOnlyTool(name.c_str(), description.c_str(), properties, callback);
+    }
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
+    void PrintStatistics();
+    void PrintToolsMemory();
+    // 供工作线程中执行的 tool 轮询，超时后返回 true；主循环中执行的 tool 始终返回 false
+    static bool IsToolCallCancelled();
 
 private:
     McpServer();
@@ -333,12 +400,42 @@ private:
     void ParseCapabilities(const cJSON* capabilities);
 
     void ReplyResult(int id, const std::string& result);
+    // JSON-RPC 结果回复的包头，结果直接追加在后面，由 FinishReplyResult 收尾并移交发送
+    static std::string BeginReplyResult(int id);
+    void FinishReplyResult(std::string payload);
     void ReplyError(int id, const std::string& message);
 
     void GetToolsList(int id, const std::string& cursor, bool list_user_only_tools);
+    McpToolsListPage BuildToolsListPage(const std::string& cursor, bool list_user_only_tools);
     void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments);
+    void InvalidateToolsList();
 
     std::vector<McpTool*> tools_;
+    std::unordered_map<std::string_view, McpTool*> tool_index_;
+
+    // tools/list 缓存：每个 tool 的描述与分页结果都只序列化一次，增加 tool 时失效
+    std::mutex tools_list_mutex_;
+    std::unordered_map<const McpTool*, std::string> tool_json_cache_;
+    std::unordered_map<std::string, McpToolsListPage> tools_list_cache_[2];
+
+    McpRequestStatistics tools_list_statistics_;
+    McpRequestStatistics tools_call_statistics_;
+    McpToolStallStatistics tools_stall_statistics_;
+
+    // 工作线程池，按并发类别在首次调用时扩充
+    std::mutex call_mutex_;
+    std::condition_variable call_cv_;
+    std::deque<std::shared_ptr<McpToolCall>> pending_calls_;
+    std::vector<std::shared_ptr<McpToolCall>> active_calls_;
+    bool concurrency_busy_[kMcpToolConcurrencyCount] = {};
+    bool concurrency_worker_[kMcpToolConcurrencyCount] = {};
+    esp_timer_handle_t deadline_timer_ = nullptr;
+
+    void StartToolWorker(McpToolConcurrency concurrency);
+    void ToolWorkerLoop();
+    void RunToolCall(const std::shared_ptr<McpToolCall>& call);
+    void CheckToolCallDeadlines();
+    void FinishToolCall(const std::shared_ptr<McpToolCall>& call);
 };
 
 #endif // MCP_SERVER_H
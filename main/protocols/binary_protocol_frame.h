@@ -0,0 +1,41 @@
+#ifndef BINARY_PROTOCOL_FRAME_H
+#define BINARY_PROTOCOL_FRAME_H
+
+#include "protocol.h"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+#include <vector>
+
+// 把一帧音频按 BinaryProtocol2/3 封装进 buffer，包头原地写入，payload 只拷贝一次
+// buffer 的容量跨帧复用，稳态下不分配内存；版本 1 没有包头，返回 false 由调用方直接发送 payload
+inline bool FrameBinaryAudio(std::vector<uint8_t>& buffer, int version, const AudioStreamPacket& packet) {
+    const size_t payload_size = packet.payload.size();
+    if (version == 2) {
+        buffer.resize(sizeof(BinaryProtocol2) + payload_size);
+        auto bp2 = (BinaryProtocol2*)buffer.data();
+        bp2->version = htons(version);
+        bp2->type = 0;
+        bp2->reserved = 0;
+        bp2->timestamp = htonl(packet.timestamp);
+        bp2->payload_size = htonl(payload_size);
+        if (payload_size > 0) {
+            memcpy(bp2->payload, packet.payload.data(), payload_size);
+        }
+        return true;
+    } else if (version == 3) {
+        buffer.resize(sizeof(BinaryProtocol3) + payload_size);
+        auto bp3 = (BinaryProtocol3*)buffer.data();
+        bp3->type = 0;
+        bp3->reserved = 0;
+        bp3->payload_size = htons(payload_size);
+        if (payload_size > 0) {
+            memcpy(bp3->payload, packet.payload.data(), payload_size);
+        }
+        return true;
+    }
+    return false;
+}
+
+#endif // BINARY_PROTOCOL_FRAME_H
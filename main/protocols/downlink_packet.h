@@ -0,0 +1,34 @@
+#ifndef DOWNLINK_PACKET_H
+#define DOWNLINK_PACKET_H
+
+#include "protocol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// 传输层的下行帧缓冲只在回调内有效，这里做下行链路唯一的一次拷贝，count_bytes 记录拷贝的字节数
+template <typename CountBytes>
+inline std::unique_ptr<AudioStreamPacket> CopyDownlinkFrame(const uint8_t* data, size_t length, uint32_t timestamp,
+    int sample_rate, int frame_duration, CountBytes&& count_bytes) {
+    auto packet = std::make_unique<AudioStreamPacket>();
+    packet->sample_rate = sample_rate;
+    packet->frame_duration = frame_duration;
+    packet->timestamp = timestamp;
+    if (data != nullptr) {
+        packet->payload.assign(data, data + length);
+        count_bytes(length);
+    }
+    return packet;
+}
+
+// 先把借用的包同步交给 AEC 参考帧接口（调用返回后不再引用包的内容），再把所有权移交给解码队列
+template <typename SendReference, typename PushToDecodeQueue>
+inline void HandOffDownlinkPacket(std::unique_ptr<AudioStreamPacket> packet, SendReference&& send_reference,
+    PushToDecodeQueue&& push_to_decode_queue) {
+    send_reference(static_cast<const AudioStreamPacket&>(*packet));
+    push_to_decode_queue(std::move(packet));
+}
+
+#endif // DOWNLINK_PACKET_H
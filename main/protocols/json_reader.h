@@ -0,0 +1,349 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+enum JsonValueType {
+    kJsonNone,
+    kJsonString,
+    kJsonNumber,
+    kJsonBool,
+    kJsonNull,
+    kJsonObject,
+    kJsonArray,
+};
+
+// 原地 JSON 读取器：只索引顶层对象的字段，不分配内存
+// 顶层字符串值在原缓冲区内反转义并以 '\0' 结尾，返回的指针直接指向缓冲区；嵌套对象/数组只记录原始文本范围
+// 键按原始字节比较（不处理键中的转义）；超过 kMaxFields 的字段仍会校验但不索引
+class JsonReader {
+public:
+    static constexpr size_t kMaxFields = 16;
+
+    JsonReader(char* data, size_t length) : data_(data), end_(data + length) {}
+
+    // 解析并校验顶层对象，失败返回 false，此时缓冲区内容可能已被部分改写
+    bool Parse() {
+        field_count_ = 0;
+        const char* p = SkipSpace(data_);
+        if (p == end_ || *p != '{') {
+            return false;
+        }
+        p = SkipSpace(p + 1);
+        if (p != end_ && *p == '}') {
+            return true;
+        }
+        while (true) {
+            if (p == end_ || *p != '"') {
+                return false;
+            }
+            const char* key = p + 1;
+            p = SkipString(p);
+            if (p == nullptr) {
+                return false;
+            }
+            size_t key_length = p - 1 - key;
+            p = SkipSpace(p);
+            if (p == end_ || *p != ':') {
+                return false;
+            }
+            p = SkipSpace(p + 1);
+
+            Field field = {key, key_length, kJsonNone, p, 0};
+            p = ParseValue(const_cast<char*>(p), field);
+            if (p == nullptr) {
+                return false;
+            }
+            if (field_count_ < kMaxFields) {
+                fields_[field_count_++] = field;
+            }
+
+            p = SkipSpace(p);
+            if (p == end_) {
+                return false;
+            }
+            if (*p == '}') {
+                return true;
+            }
+            if (*p != ',') {
+                return false;
+            }
+            p = SkipSpace(p + 1);
+        }
+    }
+
+    JsonValueType GetType(const char* name) const {
+        auto field = Find(name);
+        return field != nullptr ? field->type : kJsonNone;
+    }
+
+    const char* GetString(const char* name) const {
+        auto field = Find(name);
+        return field != nullptr && field->type == kJsonString ? field->value : nullptr;
+    }
+
+    bool GetInt(const char* name, int& value) const {
+        auto field = Find(name);
+        if (field == nullptr || field->type != kJsonNumber) {
+            return false;
+        }
+        value = (int)strtol(field->value, nullptr, 10);
+        return true;
+    }
+
+    bool GetBool(const char* name, bool& value) const {
+        auto field = Find(name);
+        if (field == nullptr || field->type != kJsonBool) {
+            return false;
+        }
+        value = field->value[0] == 't';
+        return true;
+    }
+
+    // 嵌套对象/数组的原始文本（含括号），可交给 cJSON_ParseWithLength 按需解析
+    bool GetRaw(const char* name, JsonValueType type, const char*& value, size_t& length) const {
+        auto field = Find(name);
+        if (field == nullptr || field->type != type) {
+            return false;
+        }
+        value = field->value;
+        length = field->length;
+        return true;
+    }
+
+    size_t field_count() const { return field_count_; }
+
+private:
+    struct Field {
+        const char* key;
+        size_t key_length;
+        JsonValueType type;
+        const char* value;
+        size_t length;
+    };
+
+    char* data_;
+    const char* end_;
+    Field fields_[kMaxFields];
+    size_t field_count_ = 0;
+
+    const Field* Find(const char* name) const {
+        size_t length = strlen(name);
+        for (size_t i = 0; i < field_count_; i++) {
+            if (fields_[i].key_length == length && memcmp(fields_[i].key, name, length) == 0) {
+                return &fields_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    const char* SkipSpace(const char* p) const {
+        while (p != end_ && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+            p++;
+        }
+        return p;
+    }
+
+    // p 指向起始引号，返回结束引号之后的位置
+    const char* SkipString(const char* p) const {
+        for (p++; p != end_; p++) {
+            if (*p == '"') {
+                return p + 1;
+            }
+            if (*p == '\\') {
+                if (++p == end_) {
+                    return nullptr;
+                }
+            } else if ((uint8_t)*p < 0x20) {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    const char* SkipLiteral(const char* p, const char* literal) const {
+        size_t length = strlen(literal);
+        if ((size_t)(end_ - p) < length || memcmp(p, literal, length) != 0) {
+            return nullptr;
+        }
+        return p + length;
+    }
+
+    // 跳过嵌套对象/数组，只做括号配对，内部字符串不改写
+    const char* SkipContainer(const char* p) const {
+        char stack[32];
+        size_t depth = 0;
+        while (p != end_) {
+            char c = *p;
+            if (c == '"') {
+                p = SkipString(p);
+                if (p == nullptr) {
+                    return nullptr;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                if (depth == sizeof(stack)) {
+                    return nullptr;
+                }
+                stack[depth++] = c == '{' ? '}' : ']';
+            } else if (c == '}' || c == ']') {
+                if (depth == 0 || stack[--depth] != c) {
+                    return nullptr;
+                }
+                if (depth == 0) {
+                    return p + 1;
+                }
+            }
+            p++;
+        }
+        return nullptr;
+    }
+
+    static int HexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool ReadHex4(const char* p, uint32_t& code) const {
+        if (end_ - p < 4) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; i++) {
+            int v = HexValue(p[i]);
+            if (v < 0) {
+                return false;
+            }
+            code = (code << 4) | v;
+        }
+        return true;
+    }
+
+    static char* WriteUtf8(char* w, uint32_t code) {
+        if (code < 0x80) {
+            *w++ = (char)code;
+        } else if (code < 0x800) {
+            *w++ = (char)(0xC0 | (code >> 6));
+            *w++ = (char)(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            *w++ = (char)(0xE0 | (code >> 12));
+            *w++ = (char)(0x80 | ((code >> 6) & 0x3F));
+            *w++ = (char)(0x80 | (code & 0x3F));
+        } else {
+            *w++ = (char)(0xF0 | (code >> 18));
+            *w++ = (char)(0x80 | ((code >> 12) & 0x3F));
+            *w++ = (char)(0x80 | ((code >> 6) & 0x3F));
+            *w++ = (char)(0x80 | (code & 0x3F));
+        }
+        return w;
+    }
+
+    // 原地反转义，写指针始终不超过读指针，结尾的 '\0' 落在结束引号的位置上
+    char* UnescapeString(char* p, Field& field) {
+        char* r = p + 1;
+        char* w = r;
+        field.value = w;
+        while (r != end_) {
+            char c = *r++;
+            if (c == '"') {
+                field.length = w - field.value;
+                *w = '\0';
+                return r;
+            }
+            if ((uint8_t)c < 0x20) {
+                return nullptr;
+            }
+            if (c != '\\') {
+                *w++ = c;
+                continue;
+            }
+            if (r == end_) {
+                return nullptr;
+            }
+            c = *r++;
+            switch (c) {
+            case '"': case '\\': case '/': *w++ = c; break;
+            case 'b': *w++ = '\b'; break;
+            case 'f': *w++ = '\f'; break;
+            case 'n': *w++ = '\n'; break;
+            case 'r': *w++ = '\r'; break;
+            case 't': *w++ = '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if (!ReadHex4(r, code)) {
+                    return nullptr;
+                }
+                r += 4;
+                if (code >= 0xD800 && code < 0xDC00) {
+                    uint32_t low;
+                    if (end_ - r < 6 || r[0] != '\\' || r[1] != 'u' || !ReadHex4(r + 2, low) ||
+                        low < 0xDC00 || low >= 0xE000) {
+                        return nullptr;
+                    }
+                    r += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code < 0xE000) {
+                    return nullptr;
+                }
+                // \uXXXX 至少 6 字节，UTF-8 至多 4 字节，不会追上读指针
+                w = WriteUtf8(w, code);
+                break;
+            }
+            default:
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    const char* ParseValue(char* p, Field& field) {
+        if (p == end_) {
+            return nullptr;
+        }
+        const char* next = nullptr;
+        switch (*p) {
+        case '"':
+            field.type = kJsonString;
+            return UnescapeString(p, field);
+        case '{':
+        case '[':
+            field.type = *p == '{' ? kJsonObject : kJsonArray;
+            next = SkipContainer(p);
+            break;
+        case 't':
+            field.type = kJsonBool;
+            next = SkipLiteral(p, "true");
+            break;
+        case 'f':
+            field.type = kJsonBool;
+            next = SkipLiteral(p, "false");
+            break;
+        case 'n':
+            field.type = kJsonNull;
+            next = SkipLiteral(p, "null");
+            break;
+        default: {
+            field.type = kJsonNumber;
+            const char* q = p;
+            while (q != end_ && ((*q >= '0' && *q <= '9') || *q == '-' || *q == '+' || *q == '.' || *q == 'e' || *q == 'E')) {
+                q++;
+            }
+            // 数字之后必须还有分隔符，因此 strtol 不会读出缓冲区
+            next = q != p && q != end_ ? q : nullptr;
+            break;
+        }
+        }
+        if (next != nullptr) {
+            field.length = next - p;
+        }
+        return next;
+    }
+};
+
+#endif // JSON_READER_H
@@ -1,4 +1,5 @@
 #include "mqtt_protocol.h"
+#include "udp_audio_packet.h"
 #include "board.h"
 #include "application.h"
 #include "settings.h"
@@ -20,14 +21,26 @@ MqttProtocol::MqttProtocol() {
             auto& app = Application::GetInstance();
             if (app.GetDeviceState() == kDeviceStateIdle) {
                 ESP_LOGI(TAG, "Reconnecting to MQTT server");
-                app.Schedule([protocol]() {
+                auto reconnect = [protocol]() {
                     protocol->StartMqttClient(false);
-                });
+                };
+                if (!app.ScheduleFromISR(reconnect)) {
+                    app.Schedule(reconnect);
+                }
             }
         },
         .arg = this,
     };
     esp_timer_create(&reconnect_timer_args, &reconnect_timer_);
+
+    esp_timer_create_args_t reorder_timer_args = {
+        .callback = [](void* arg) {
+            static_cast<MqttProtocol*>(arg)->ExpireReorderWindow();
+        },
+        .arg = this,
+        .name = "udp_reorder",
+    };
+    esp_timer_create(&reorder_timer_args, &reorder_timer_);
 }
 
 MqttProtocol::~MqttProtocol() {
@@ -36,6 +49,10 @@ MqttProtocol::~MqttProtocol() {
         esp_timer_stop(reconnect_timer_);
         esp_timer_delete(reconnect_timer_);
     }
+    if (reorder_timer_ != nullptr) {
+        esp_timer_stop(reorder_timer_);
+        esp_timer_delete(reorder_timer_);
+    }
 
     udp_.reset();
     mqtt_.reset();
@@ -91,32 +108,43 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     });
 
     mqtt_->OnMessage([this](const std::string& topic, const std::string& payload) {
-        cJSON* root = cJSON_Parse(payload.c_str());
-        if (root == nullptr) {
+        // 拷贝到复用缓冲后原地解析，只有 hello 仍走 cJSON
+        incoming_text_.assign(payload);
+        JsonReader reader(incoming_text_.data(), incoming_text_.size());
+        if (!reader.Parse()) {
             ESP_LOGE(TAG, "Failed to parse json message %s", payload.c_str());
             return;
         }
-        cJSON* type = cJSON_GetObjectItem(root, "type");
-        if (!cJSON_IsString(type)) {
+        auto type = reader.GetString("type");
+        if (type == nullptr) {
             ESP_LOGE(TAG, "Message type is invalid");
-            cJSON_Delete(root);
             return;
         }
 
-        if (strcmp(type->valuestring, "hello") == 0) {
-            ParseServerHello(root);
-        } else if (strcmp(type->valuestring, "goodbye") == 0) {
-            auto session_id = cJSON_GetObjectItem(root, "session_id");
-            ESP_LOGI(TAG, "Received goodbye message, session_id: %s", session_id ? session_id->valuestring : "null");
-            if (session_id == nullptr || session_id_ == session_id->valuestring) {
+        if (strcmp(type, "hello") == 0) {
+            cJSON* root = cJSON_ParseWithLength(payload.data(), payload.size());
+            if (root != nullptr) {
+                ParseServerHello(root);
+                cJSON_Delete(root);
+            }
+        } else if (strcmp(type, "goodbye") == 0) {
+            auto session_id = reader.GetString("session_id");
+            ESP_LOGI(TAG, "Received goodbye message, session_id: %s", session_id ? session_id : "null");
+            if (session_id == nullptr || session_id_ == session_id) {
                 Application::GetInstance().Schedule([this]() {
                     CloseAudioChannel();
                 });
             }
-        } else if (on_incoming_json_ != nullptr) {
-            on_incoming_json_(root);
+        } else {
+            if (strcmp(type, "tts") == 0) {
+                auto state = reader.GetString("state");
+                if (state != nullptr && strcmp(state, "stop") == 0) {
+                    // 本轮播报结束，窗口中等待缺口的尾包立即输出，不留到下一轮
+                    FlushReorderWindow();
+                }
+            }
+            DispatchIncomingMessage(reader);
         }
-        cJSON_Delete(root);
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
@@ -158,24 +186,19 @@ bool MqttProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
         return false;
     }
 
-    std::string nonce(aes_nonce_);
-    *(uint16_t*)&nonce[2] = htons(packet->payload.size());
-    *(uint32_t*)&nonce[8] = htonl(packet->timestamp);
-    *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
-
-    std::string encrypted;
-    encrypted.resize(aes_nonce_.size() + packet->payload.size());
-    memcpy(encrypted.data(), nonce.data(), nonce.size());
-
-    size_t nc_off = 0;
-    uint8_t stream_block[16] = {0};
-    if (mbedtls_aes_crypt_ctr(&aes_ctx_, packet->payload.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
-        (uint8_t*)packet->payload.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+    // 包头(nonce)与密文直接写入复用的发送缓冲，稳态下不再分配内存
+    bool packed = PackUdpAudioPacket(udp_send_buffer_, aes_nonce_, packet->payload, packet->timestamp, ++local_sequence_,
+        [this](size_t length, uint8_t* nonce_counter, const uint8_t* input, uint8_t* output) {
+            size_t nc_off = 0;
+            uint8_t stream_block[16] = {0};
+            return mbedtls_aes_crypt_ctr(&aes_ctx_, length, &nc_off, nonce_counter, stream_block, input, output);
+        });
+    if (!packed) {
         ESP_LOGE(TAG, "Failed to encrypt audio data");
         return false;
     }
 
-    return udp_->Send(encrypted) > 0;
+    return udp_->Send(udp_send_buffer_) > 0;
 }
 
 void MqttProtocol::CloseAudioChannel() {
@@ -184,11 +207,15 @@ void MqttProtocol::CloseAudioChannel() {
         udp_.reset();
     }
 
-    std::string message = "{";
-    message += "\"session_id\":\"" + session_id_ + "\",";
-    message += "\"type\":\"goodbye\"";
-    message += "}";
-    SendText(message);
+    std::string goodbye;
+    {
+        // 通道已关闭，窗口中剩余的包直接丢弃
+        std::lock_guard<std::mutex> lock(reorder_mutex_);
+        esp_timer_stop(reorder_timer_);
+        reorder_window_.Discard();
+        goodbye = GetGoodbyeMessage();
+    }
+    SendText(goodbye);
 
     if (on_audio_channel_closed_ != nullptr) {
         on_audio_channel_closed_();
@@ -208,6 +235,7 @@ bool MqttProtocol::OpenAudioChannel(const std::string&) {
     xEventGroupClearBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 
     auto message = GetHelloMessage();
+    hello_sent_time_us_ = esp_timer_get_time();
     if (!SendText(message)) {
         return false;
     }
@@ -229,7 +257,7 @@ bool MqttProtocol::OpenAudioChannel(const std::string&) {
          * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
          * |payload payload_len|
          */
-        if (data.size() < sizeof(aes_nonce_)) {
+        if (data.size() < aes_nonce_.size()) {
             ESP_LOGE(TAG, "Invalid audio packet size: %u", data.size());
             return;
         }
@@ -239,19 +267,15 @@ bool MqttProtocol::OpenAudioChannel(const std::string&) {
         }
         uint32_t timestamp = ntohl(*(uint32_t*)&data[8]);
         uint32_t sequence = ntohl(*(uint32_t*)&data[12]);
-        if (sequence < remote_sequence_) {
-            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_);
-            return;
-        }
-        if (sequence != remote_sequence_ + 1) {
-            ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
-        }
+        int64_t arrival_ms = esp_timer_get_time() / 1000;
 
+        // 直接解密到解码包的 payload，不经过中间缓冲；nonce 拷贝到栈上，避免 mbedtls 改写接收数据
         size_t decrypted_size = data.size() - aes_nonce_.size();
         size_t nc_off = 0;
         uint8_t stream_block[16] = {0};
-        auto nonce = (uint8_t*)data.data();
-        auto encrypted = (uint8_t*)data.data() + aes_nonce_.size();
+        uint8_t nonce[16];
+        memcpy(nonce, data.data(), sizeof(nonce));
+        auto encrypted = (const uint8_t*)data.data() + aes_nonce_.size();
         auto packet = std::make_unique<AudioStreamPacket>();
         packet->sample_rate = server_sample_rate_;
         packet->frame_duration = server_frame_duration_;
@@ -262,10 +286,20 @@ bool MqttProtocol::OpenAudioChannel(const std::string&) {
             ESP_LOGE(TAG, "Failed to decrypt audio data, ret: %d", ret);
             return;
         }
-        if (on_incoming_audio_ != nullptr) {
-            on_incoming_audio_(std::move(packet));
+        // 乱序包在窗口内补齐后按序交给解码队列，过期或重复的包丢弃
+        {
+            std::lock_guard<std::mutex> lock(reorder_mutex_);
+            jitter_estimator_.Update(timestamp, arrival_ms);
+            auto output = [this](std::unique_ptr<AudioStreamPacket>&& packet) {
+                OnReorderedAudio(std::move(packet));
+            };
+            reorder_window_.Push(sequence, std::move(packet), arrival_ms, output);
+            int64_t wait_ms = reorder_window_.Expire(arrival_ms, output);
+            esp_timer_stop(reorder_timer_);
+            if (wait_ms >= 0) {
+                esp_timer_start_once(reorder_timer_, wait_ms * 1000);
+            }
         }
-        remote_sequence_ = sequence;
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
@@ -277,6 +311,84 @@ bool MqttProtocol::OpenAudioChannel(const std::string&) {
     return true;
 }
 
+void MqttProtocol::OnReorderedAudio(std::unique_ptr<AudioStreamPacket>&& packet) {
+    if (on_incoming_audio_ != nullptr) {
+        on_incoming_audio_(std::move(packet));
+    }
+}
+
+// 在 esp_timer 任务中执行：后续包迟迟不到时，按到达时间让缺口之后的包超时输出
+void MqttProtocol::ExpireReorderWindow() {
+    std::lock_guard<std::mutex> lock(reorder_mutex_);
+    int64_t wait_ms = reorder_window_.Expire(esp_timer_get_time() / 1000,
+        [this](std::unique_ptr<AudioStreamPacket>&& packet) {
+            OnReorderedAudio(std::move(packet));
+        });
+    if (wait_ms >= 0) {
+        esp_timer_start_once(reorder_timer_, wait_ms * 1000);
+    }
+}
+
+void MqttProtocol::FlushReorderWindow() {
+    std::lock_guard<std::mutex> lock(reorder_mutex_);
+    esp_timer_stop(reorder_timer_);
+    reorder_window_.Flush([this](std::unique_ptr<AudioStreamPacket>&& packet) {
+        OnReorderedAudio(std::move(packet));
+    });
+}
+
+bool MqttProtocol::GetLinkStatistics(LinkStatistics& statistics) {
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        if (udp_ == nullptr) {
+            return false;
+        }
+    }
+    std::lock_guard<std::mutex> lock(reorder_mutex_);
+    auto& stats = reorder_window_.statistics();
+    uint32_t expected = stats.received - stats.late + stats.lost;
+    uint32_t interval_expected = expected - last_link_expected_;
+    uint32_t interval_lost = stats.lost - last_link_lost_;
+    last_link_expected_ = expected;
+    last_link_lost_ = stats.lost;
+
+    statistics.loss_rate = interval_expected > 0 ? (float)interval_lost / interval_expected : 0;
+    statistics.packets = interval_expected;
+    statistics.jitter_ms = jitter_estimator_.jitter_ms();
+    // hello 的 RTT 只作为一次样本，不让一次慢握手影响整个会话
+    statistics.rtt_ms = rtt_sample_pending_ ? hello_rtt_ms_ : -1;
+    rtt_sample_pending_ = false;
+    statistics.max_uplink_frame_duration = max_uplink_frame_duration_;
+    return true;
+}
+
+// goodbye 附带本次会话的下行 UDP 统计，便于服务端汇总网络质量；调用方持有 reorder_mutex_
+std::string MqttProtocol::GetGoodbyeMessage() {
+    auto& stats = reorder_window_.statistics();
+    uint32_t expected = stats.received - stats.late + stats.lost;
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "session_id", session_id_.c_str());
+    cJSON_AddStringToObject(root, "type", "goodbye");
+    cJSON* statistics = cJSON_CreateObject();
+    cJSON_AddNumberToObject(statistics, "received", stats.received);
+    cJSON_AddNumberToObject(statistics, "lost", stats.lost);
+    cJSON_AddNumberToObject(statistics, "reordered", stats.reordered);
+    cJSON_AddNumberToObject(statistics, "late", stats.late);
+    cJSON_AddNumberToObject(statistics, "expired", stats.expired);
+    cJSON_AddNumberToObject(statistics, "loss_rate", expected > 0 ? (double)stats.lost / expected : 0);
+    cJSON_AddNumberToObject(statistics, "jitter_ms", jitter_estimator_.jitter_ms());
+    cJSON_AddNumberToObject(statistics, "rtt_ms", hello_rtt_ms_);
+    cJSON_AddItemToObject(root, "statistics", statistics);
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string message(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+
+    ESP_LOGI(TAG, "UDP stats: received %lu lost %lu reordered %lu late %lu expired %lu jitter %.1f ms rtt %d ms",
+        stats.received, stats.lost, stats.reordered, stats.late, stats.expired, jitter_estimator_.jitter_ms(), hello_rtt_ms_);
+    return message;
+}
+
 std::string MqttProtocol::GetHelloMessage() {
     // 发送 hello 消息申请 UDP 通道
     cJSON* root = cJSON_CreateObject();
@@ -288,6 +400,10 @@ std::string MqttProtocol::GetHelloMessage() {
     cJSON_AddBoolToObject(features, "aec", true);
 #endif
     cJSON_AddBoolToObject(features, "mcp", true);
+#if CONFIG_USE_ADAPTIVE_OPUS_FRAME_DURATION
+    // 服务端在 hello 的 audio_params.max_frame_duration 中声明可解码的最长帧长后才会切换
+    cJSON_AddBoolToObject(features, "adaptive_frame_duration", true);
+#endif
     cJSON_AddItemToObject(root, "features", features);
     cJSON* audio_params = cJSON_CreateObject();
     cJSON_AddStringToObject(audio_params, "format", "opus");
@@ -317,7 +433,12 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
 
     // Get sample rate from hello message
     auto audio_params = cJSON_GetObjectItem(root, "audio_params");
+    int max_uplink_frame_duration = 0;
     if (cJSON_IsObject(audio_params)) {
+        auto max_frame_duration = cJSON_GetObjectItem(audio_params, "max_frame_duration");
+        if (cJSON_IsNumber(max_frame_duration)) {
+            max_uplink_frame_duration = max_frame_duration->valueint;
+        }
         auto sample_rate = cJSON_GetObjectItem(audio_params, "sample_rate");
         if (cJSON_IsNumber(sample_rate)) {
             server_sample_rate_ = sample_rate->valueint;
@@ -344,7 +465,18 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
     mbedtls_aes_init(&aes_ctx_);
     mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
     local_sequence_ = 0;
-    remote_sequence_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(reorder_mutex_);
+        esp_timer_stop(reorder_timer_);
+        reorder_window_.Reset();
+        jitter_estimator_.Reset();
+        last_link_expected_ = 0;
+        last_link_lost_ = 0;
+        hello_rtt_ms_ = (esp_timer_get_time() - hello_sent_time_us_) / 1000;
+        rtt_sample_pending_ = true;
+        max_uplink_frame_duration_ = max_uplink_frame_duration;
+    }
+    ESP_LOGI(TAG, "Server hello RTT: %d ms, max uplink frame %d ms", hello_rtt_ms_, max_uplink_frame_duration);
     xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 }
 
@@ -3,6 +3,7 @@
 
 
 #include "protocol.h"
+#include "udp_reorder_window.h"
 #include <mqtt.h>
 #include <udp.h>
 #include <cJSON.h>
@@ -21,6 +22,11 @@
 
 #define MQTT_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
+// 下行音频重排窗口（包数），丢包时最多额外缓冲 (N - 1) 帧
+#define MQTT_UDP_REORDER_WINDOW_SIZE 4
+// 缺口之后的包最长等待时间，超时后跳过缺口
+#define MQTT_UDP_REORDER_HOLD_MS 80
+
 class MqttProtocol : public Protocol {
 public:
     MqttProtocol();
@@ -31,6 +37,7 @@ public:
     bool OpenAudioChannel(const std::string&) override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
+    bool GetLinkStatistics(LinkStatistics& statistics) override;
 
 private:
     EventGroupHandle_t event_group_handle_;
@@ -42,18 +49,34 @@ private:
     std::unique_ptr<Udp> udp_;
     mbedtls_aes_context aes_ctx_;
     std::string aes_nonce_;
+    std::string udp_send_buffer_;   // 加密发送缓冲，按最大包复用容量
+    std::string incoming_text_;     // 入站控制消息的原地解析缓冲
     std::string udp_server_;
     int udp_port_;
     uint32_t local_sequence_;
-    uint32_t remote_sequence_;
+    // 重排窗口与抖动估计由 UDP 接收回调、重排定时器和主循环共同访问，都在 reorder_mutex_ 下进行
+    std::mutex reorder_mutex_;
+    UdpReorderWindow<std::unique_ptr<AudioStreamPacket>, MQTT_UDP_REORDER_WINDOW_SIZE> reorder_window_ { MQTT_UDP_REORDER_HOLD_MS };
+    UdpJitterEstimator jitter_estimator_;
+    esp_timer_handle_t reorder_timer_ = nullptr;
+    int64_t hello_sent_time_us_ = 0;
+    int hello_rtt_ms_ = -1;
+    bool rtt_sample_pending_ = false;
+    int max_uplink_frame_duration_ = 0;
+    uint32_t last_link_expected_ = 0;
+    uint32_t last_link_lost_ = 0;
     esp_timer_handle_t reconnect_timer_;
 
     bool StartMqttClient(bool report_error=false);
+    void OnReorderedAudio(std::unique_ptr<AudioStreamPacket>&& packet);
+    void ExpireReorderWindow();
+    void FlushReorderWindow();
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
 
     bool SendText(const std::string& text) override;
     std::string GetHelloMessage();
+    std::string GetGoodbyeMessage();
 };
 
 
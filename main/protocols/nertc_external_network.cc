@@ -1,12 +1,42 @@
 #include <cstring>
+#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include "nertc_external_network.h"
+#include "nertc_ring_buffer.h"
+#include "nertc_send_buffer.h"
 #include "board.h"
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #define TAG "NeRtcExternalNetwork"
 
-#define TCP_RECV_EVENT (1 << 0)
-#define UDP_RECV_EVENT (1 << 1)
+// SDK 拿到的 tcp_handle / udp_handle 指向这些连接对象，接收缓冲按连接隔离
+struct NeRtcTcpConnection {
+    Tcp* tcp = nullptr;
+    std::mutex send_mutex;
+    std::string send_buffer;    // 复用容量，发送路径不再逐包分配
+    std::mutex mutex;
+    std::condition_variable cv;         // 有数据可读
+    ByteRingBuffer recv_buffer { NERTC_EXT_TCP_RECV_BUFFER_SIZE };
+    bool closed = false;
+    // 缓冲扩到上限仍放不下，数据已丢弃、流不完整，之后的 recv 返回错误
+    bool failed = false;
+    uint32_t dropped_bytes = 0;
+    size_t peak_size = 0;
+};
+
+struct NeRtcUdpConnection {
+    Udp* udp = nullptr;
+    std::mutex send_mutex;
+    std::string send_buffer;
+    std::mutex mutex;
+    std::condition_variable cv;
+    DatagramRingBuffer recv_queue { NERTC_EXT_UDP_RECV_QUEUE_SLOTS };
+    int timeout_ms = 5000;
+    bool closed = false;
+};
 
 NeRtcExternalNetwork* NeRtcExternalNetwork::instance_ = nullptr;
 NeRtcExternalNetwork* NeRtcExternalNetwork::GetInstance() {
@@ -54,15 +84,29 @@ NeRtcExternalNetwork::NeRtcExternalNetwork() {
         .recv_udp = RecvUdp
     };
 
-    tcp_event_group_ = xEventGroupCreate();
-    udp_event_group_ = xEventGroupCreate();
-
     ESP_LOGI(TAG, "Create NeRtcExternalNetwork instance");
 }
 
 NeRtcExternalNetwork::~NeRtcExternalNetwork() {
-    vEventGroupDelete(udp_event_group_);
-    vEventGroupDelete(tcp_event_group_);
+}
+
+void NeRtcExternalNetwork::PrintStatistics() {
+    if (instance_ == nullptr) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    uint32_t tx_bytes = instance_->tx_bytes_.load();
+    uint32_t tx_bytes_copied = instance_->tx_bytes_copied_.load();
+    if (instance_->last_statistics_time_us_ > 0 && now > instance_->last_statistics_time_us_) {
+        int64_t elapsed_us = now - instance_->last_statistics_time_us_;
+        ESP_LOGI(TAG, "Ext net stats: tx %lld B/s, copied %lld B/s, send buffer allocations %lu",
+            (int64_t)(tx_bytes - instance_->last_tx_bytes_) * 1000000 / elapsed_us,
+            (int64_t)(tx_bytes_copied - instance_->last_tx_bytes_copied_) * 1000000 / elapsed_us,
+            instance_->tx_allocations_.load());
+    }
+    instance_->last_statistics_time_us_ = now;
+    instance_->last_tx_bytes_ = tx_bytes;
+    instance_->last_tx_bytes_copied_ = tx_bytes_copied;
 }
 
 // HTTP 实现
@@ -95,7 +139,13 @@ bool NeRtcExternalNetwork::OpenHttp(http_handle handle, const char* method, cons
         return false;
         
     Http* http = static_cast<Http*>(handle);
-    http->SetContent(std::string(content, length));
+    // GET 等无请求体时不构造内容
+    if (content != nullptr && length > 0) {
+        http->SetContent(std::string(content, length));
+        instance_->tx_bytes_copied_ += length;
+        instance_->tx_allocations_++;
+    }
+    instance_->tx_bytes_ += length;
     if (!http->Open(method, url)) {
         ESP_LOGE(TAG, "Failed to open HTTP connection. url: %s", url);    
         return false;
@@ -153,16 +203,28 @@ size_t NeRtcExternalNetwork::GetHttpBody(http_handle handle, char* buffer, size_
 tcp_handle NeRtcExternalNetwork::CreateTcp() {
     auto network = Board::GetInstance().GetNetwork();
     auto tcp_unique = network->CreateTcp(1);
-    Tcp* tcp = tcp_unique.release();
-
-    tcp->OnStream([](const std::string& data) {
-        NeRtcExternalNetwork* ext_net = NeRtcExternalNetwork::GetInstance();
-        std::lock_guard<std::mutex> lock(ext_net->tcp_mutex_);
-        ext_net->tcp_recv_buffer_.append(data);
-        xEventGroupSetBits(ext_net->tcp_event_group_, TCP_RECV_EVENT);
+    auto connection = new NeRtcTcpConnection();
+    connection->tcp = tcp_unique.release();
+
+    // 接收回调运行在传输层任务中，不能阻塞：缓冲不够时扩容，扩到上限仍放不下说明 SDK 长时间没有读取，
+    // TCP 字节流缺了一段就无法继续解析，丢弃并把连接标记为失败
+    connection->tcp->OnStream([connection](const std::string& data) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->failed || connection->closed) {
+            connection->dropped_bytes += data.size();
+            return;
+        }
+        if (!connection->recv_buffer.WriteAll(data.data(), data.size(), NERTC_EXT_TCP_RECV_BUFFER_MAX_SIZE)) {
+            ESP_LOGE(TAG, "TCP recv buffer over %d bytes, dropped %u bytes, mark connection failed",
+                NERTC_EXT_TCP_RECV_BUFFER_MAX_SIZE, data.size());
+            connection->dropped_bytes += data.size();
+            connection->failed = true;
+        }
+        connection->peak_size = std::max(connection->peak_size, connection->recv_buffer.size());
+        connection->cv.notify_one();
     });
 
-    return static_cast<void*>(tcp);
+    return static_cast<void*>(connection);
 }
 
 void NeRtcExternalNetwork::SetTcpSocketOpt(tcp_handle, int, int) {
@@ -173,32 +235,53 @@ void NeRtcExternalNetwork::DestroyTcp(tcp_handle handle) {
     if (!handle)
         return;
 
-    Tcp* tcp = static_cast<Tcp*>(handle);
-    delete tcp;
+    auto connection = static_cast<NeRtcTcpConnection*>(handle);
+    delete connection->tcp;
+    if (connection->recv_buffer.grow_count() > 0 || connection->failed) {
+        ESP_LOGW(TAG, "TCP connection destroyed, recv buffer grew %lu times to %u bytes, peak %u bytes, dropped %lu bytes",
+            connection->recv_buffer.grow_count(), connection->recv_buffer.capacity(), connection->peak_size,
+            connection->dropped_bytes);
+    }
+    delete connection;
 }
 
 bool NeRtcExternalNetwork::ConnectTcp(tcp_handle handle, const char* host, int port) {
     if (!handle)
         return false;
-        
-    Tcp* tcp = static_cast<Tcp*>(handle);
-    return tcp->Connect(host, port);
+
+    auto connection = static_cast<NeRtcTcpConnection*>(handle);
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->recv_buffer.Clear();
+        connection->closed = false;
+        connection->failed = false;
+    }
+    return connection->tcp->Connect(host, port);
 }
 
 void NeRtcExternalNetwork::DisconnectTcp(tcp_handle handle) {
     if (!handle)
         return;
 
-    Tcp* tcp = static_cast<Tcp*>(handle);
-    tcp->Disconnect();
+    auto connection = static_cast<NeRtcTcpConnection*>(handle);
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->closed = true;
+        connection->cv.notify_all();
+    }
+    connection->tcp->Disconnect();
 }
 
 int NeRtcExternalNetwork::SendTcp(tcp_handle handle, const char* data, size_t length) {
     if (!handle)
         return -1;
 
-    Tcp* tcp = static_cast<Tcp*>(handle);
-    return tcp->Send(std::string(data, length));
+    auto connection = static_cast<NeRtcTcpConnection*>(handle);
+    std::lock_guard<std::mutex> lock(connection->send_mutex);
+    FillSendBuffer(connection->send_buffer, data, length, instance_->tx_allocations_);
+    instance_->tx_bytes_ += length;
+    instance_->tx_bytes_copied_ += length;
+    return connection->tcp->Send(connection->send_buffer);
 }
 
 int NeRtcExternalNetwork::RecvTcp(tcp_handle handle,
@@ -207,104 +290,104 @@ int NeRtcExternalNetwork::RecvTcp(tcp_handle handle,
     if (!handle || !buffer)
         return -1;
 
-    NeRtcExternalNetwork* ext_net = NeRtcExternalNetwork::GetInstance();
-
-    {
-        std::lock_guard<std::mutex> lock(ext_net->tcp_mutex_);
-        if (!ext_net->tcp_recv_buffer_.empty()) {
-            size_t to_copy = std::min(buffer_size, ext_net->tcp_recv_buffer_.size());
-            memcpy(buffer, ext_net->tcp_recv_buffer_.data(), to_copy);
-            ext_net->tcp_recv_buffer_.erase(0, to_copy);
-            return static_cast<int>(to_copy);   // 立刻返回，不阻塞
-        }
+    // 有数据立刻返回，否则阻塞到有数据或连接断开；接收缓冲溢出后返回错误
+    auto connection = static_cast<NeRtcTcpConnection*>(handle);
+    std::unique_lock<std::mutex> lock(connection->mutex);
+    connection->cv.wait(lock, [connection]() {
+        return !connection->recv_buffer.empty() || connection->closed || connection->failed;
+    });
+    if (connection->failed) {
+        return -1;
     }
-
-    EventBits_t bits = xEventGroupWaitBits(ext_net->tcp_event_group_,
-                                           TCP_RECV_EVENT,
-                                           pdTRUE,          // 退出时清除事件
-                                           pdFALSE,
-                                           portMAX_DELAY);
-    if ((bits & TCP_RECV_EVENT) == 0)
-        return 0;  
-
-    std::lock_guard<std::mutex> lock(ext_net->tcp_mutex_);
-    size_t to_copy = std::min(buffer_size, ext_net->tcp_recv_buffer_.size());
-    memcpy(buffer, ext_net->tcp_recv_buffer_.data(), to_copy);
-    ext_net->tcp_recv_buffer_.erase(0, to_copy);
-    return static_cast<int>(to_copy);
+    return static_cast<int>(connection->recv_buffer.Read(buffer, buffer_size));
 }
 
 udp_handle NeRtcExternalNetwork::CreateUdp() {
     auto network = Board::GetInstance().GetNetwork();
     auto udp_unique = network->CreateUdp(2);
-    Udp* udp = udp_unique.release();
+    auto connection = new NeRtcUdpConnection();
+    connection->udp = udp_unique.release();
 
-    udp->OnMessage([](const std::string& data) {
-        NeRtcExternalNetwork* ext_net = NeRtcExternalNetwork::GetInstance();
-        std::lock_guard<std::mutex> lock(ext_net->udp_mutex_);
-        ext_net->udp_data_queue_.emplace_back(data);
-        xEventGroupSetBits(ext_net->udp_event_group_, UDP_RECV_EVENT);
+    connection->udp->OnMessage([connection](const std::string& data) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->recv_queue.Push(data.data(), data.size());
+        connection->cv.notify_one();
     });
 
-    return static_cast<void*>(udp);
+    return static_cast<void*>(connection);
 }
 
-void NeRtcExternalNetwork::SetUdpSocketOpt(udp_handle, int timeout, int) {
-    NeRtcExternalNetwork* ext_net = NeRtcExternalNetwork::GetInstance();
-    ext_net->udp_timeout_ms_ = timeout;
+void NeRtcExternalNetwork::SetUdpSocketOpt(udp_handle handle, int timeout, int) {
+    if (!handle)
+        return;
+
+    auto connection = static_cast<NeRtcUdpConnection*>(handle);
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    connection->timeout_ms = timeout;
 }
 
 void NeRtcExternalNetwork::DestroyUdp(udp_handle handle) {
     if (!handle)
         return;
 
-    Udp* udp = static_cast<Udp*>(handle);
-    delete udp;
+    auto connection = static_cast<NeRtcUdpConnection*>(handle);
+    delete connection->udp;
+    if (connection->recv_queue.dropped() > 0 || connection->recv_queue.truncated() > 0) {
+        ESP_LOGW(TAG, "UDP connection destroyed, dropped %lu datagrams, truncated %lu",
+            connection->recv_queue.dropped(), connection->recv_queue.truncated());
+    }
+    delete connection;
 }
 
 bool NeRtcExternalNetwork::ConnectUdp(udp_handle handle, const char* host, int port) {
     if (!handle)
         return false;
-        
-    Udp* udp = static_cast<Udp*>(handle);
-    return udp->Connect(std::string(host), (int)port);
+
+    auto connection = static_cast<NeRtcUdpConnection*>(handle);
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->recv_queue.Clear();
+        connection->closed = false;
+    }
+    return connection->udp->Connect(std::string(host), (int)port);
 }
 
 void NeRtcExternalNetwork::DisconnectUdp(udp_handle handle) {
     if (!handle)
         return;
 
-    Udp* udp = static_cast<Udp*>(handle);
-    udp->Disconnect();
+    auto connection = static_cast<NeRtcUdpConnection*>(handle);
+    connection->udp->Disconnect();
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    connection->closed = true;
+    connection->cv.notify_all();
 }
 
 int NeRtcExternalNetwork::SendUdp(udp_handle handle, const char* data, size_t length) {
     if (!handle)
         return -1;
 
-    Udp* udp = static_cast<Udp*>(handle);
-    return udp->Send(std::string(data, length));
+    auto connection = static_cast<NeRtcUdpConnection*>(handle);
+    std::lock_guard<std::mutex> lock(connection->send_mutex);
+    FillSendBuffer(connection->send_buffer, data, length, instance_->tx_allocations_);
+    instance_->tx_bytes_ += length;
+    instance_->tx_bytes_copied_ += length;
+    return connection->udp->Send(connection->send_buffer);
 }
 
 int NeRtcExternalNetwork::RecvUdp(udp_handle handle, char* buffer, size_t buffer_size) {
     if (!handle)
         return -1;
 
-    NeRtcExternalNetwork* ext_net = NeRtcExternalNetwork::GetInstance();
-    auto bits = xEventGroupWaitBits(ext_net->udp_event_group_, UDP_RECV_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(ext_net->udp_timeout_ms_));
-    if (bits & UDP_RECV_EVENT) {
-        std::lock_guard<std::mutex> lock(ext_net->udp_mutex_);
-        if (!ext_net->udp_data_queue_.empty()) {
-            auto& data = ext_net->udp_data_queue_.front();
-            size_t to_copy = std::min(buffer_size, data.size());
-            memcpy(buffer, data.data(), to_copy);
-            ext_net->udp_data_queue_.pop_front();
-            return to_copy;
-        } else {
-            return 0;
-        }
-    } else {
+    // 按队列是否为空判断，而不是事件位，队列中还有数据报时不会再等待
+    auto connection = static_cast<NeRtcUdpConnection*>(handle);
+    std::unique_lock<std::mutex> lock(connection->mutex);
+    bool ready = connection->cv.wait_for(lock, std::chrono::milliseconds(connection->timeout_ms), [connection]() {
+        return !connection->recv_queue.empty() || connection->closed;
+    });
+    if (!ready || connection->recv_queue.empty()) {
         // Timeout
         return 0;
     }
-}
\ No newline at end of file
+    return connection->recv_queue.Pop(buffer, buffer_size);
+}
@@ -1,19 +1,24 @@
 #ifndef _NERTC_EXTERN_NETWORK_H_
 #define _NERTC_EXTERN_NETWORK_H_
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/event_groups.h>
-#include <list>
-#include <mutex>
+#include <atomic>
 #include <string>
 #include "nertc_sdk_ext_net.h"
 
+// 每个 TCP / UDP 句柄独立的接收缓冲容量
+#define NERTC_EXT_TCP_RECV_BUFFER_SIZE (16 * 1024)
+// TCP 接收缓冲满时按需扩容的上限，超过则丢弃并判定连接失败（接收回调不能阻塞传输层任务）
+#define NERTC_EXT_TCP_RECV_BUFFER_MAX_SIZE (64 * 1024)
+#define NERTC_EXT_UDP_RECV_QUEUE_SLOTS 32
+
 class NeRtcExternalNetwork {
 public:
     static NeRtcExternalNetwork* GetInstance();
     static void DestroyInstance();
     
     nertc_sdk_ext_net_handle_t* GetHandle() { return &handle_; }
+    // 实例未创建时不输出
+    static void PrintStatistics();
 private:
     NeRtcExternalNetwork();
     ~NeRtcExternalNetwork();
@@ -51,13 +56,14 @@ private:
 private:
     static NeRtcExternalNetwork* instance_;
     nertc_sdk_ext_net_handle_t handle_;
-    EventGroupHandle_t tcp_event_group_ = nullptr;
-    EventGroupHandle_t udp_event_group_ = nullptr;
-    std::mutex tcp_mutex_;
-    std::mutex udp_mutex_;
-    std::string tcp_recv_buffer_;
-    std::list<std::string> udp_data_queue_; 
-    int udp_timeout_ms_ = 5000;
+
+    // 发送路径统计：网络库接口以 std::string 收发，发送缓冲按连接复用，这里统计仍需拷贝的字节
+    std::atomic<uint32_t> tx_bytes_ {0};
+    std::atomic<uint32_t> tx_bytes_copied_ {0};
+    std::atomic<uint32_t> tx_allocations_ {0};
+    int64_t last_statistics_time_us_ = 0;
+    uint32_t last_tx_bytes_ = 0;
+    uint32_t last_tx_bytes_copied_ = 0;
 };
 
 
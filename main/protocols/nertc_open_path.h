@@ -0,0 +1,24 @@
+#ifndef NERTC_OPEN_PATH_H
+#define NERTC_OPEN_PATH_H
+
+// 打开音频通道时 AI 会话的处理方式
+enum NeRtcOpenPath {
+    kNeRtcOpenCold,        // AI 未启动：start_ai，唤醒词作为 start_topic
+    kNeRtcOpenWarm,        // AI 已预热且没有唤醒词：只打开本地通道
+    kNeRtcOpenWarmPrompt,  // AI 已预热，唤醒词以 llm_prompt 文本请求送达（语义与 start_topic 不同）
+    kNeRtcOpenRestart,     // AI 已预热但有唤醒词：重启 AI，唤醒词仍作为 start_topic
+};
+
+// start_topic 只能随 start_ai 下发，预热的会话带唤醒词打开时默认重启以保持与冷启动相同的语义；
+// wake_word_as_prompt 时改为文本请求，省去重启但唤醒词会作为一轮用户输入出现在对话中
+inline NeRtcOpenPath ChooseNeRtcOpenPath(bool ai_started, bool has_wake_word, bool wake_word_as_prompt) {
+    if (!ai_started) {
+        return kNeRtcOpenCold;
+    }
+    if (!has_wake_word) {
+        return kNeRtcOpenWarm;
+    }
+    return wake_word_as_prompt ? kNeRtcOpenWarmPrompt : kNeRtcOpenRestart;
+}
+
+#endif // NERTC_OPEN_PATH_H
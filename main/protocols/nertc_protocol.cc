@@ -1,10 +1,14 @@
 #include <string>
 #include <cstring>
+#include <algorithm>
 #include "nertc_protocol.h"
 #include "nertc_external_network.h"
+#include "downlink_packet.h"
+#include "nertc_open_path.h"
 #include "board.h"
 #include "display.h"
 #include "system_info.h"
+#include "cjson_arena.h"
 #include <esp_random.h>
 #include <esp_log.h>
 #include <application.h>
@@ -15,6 +19,9 @@
 #include <errno.h>
 #include <dirent.h>
 #include <fstream>
+#include <mutex>
+#include <memory>
+#include <vector>
 #endif
 
 #define TAG "NeRtcProtocol"
@@ -23,6 +30,10 @@
 #define USE_SAFE_MODE 0
 #define JOIN_EVENT (1 << 0)
 
+#define RESUME_MAX_ATTEMPTS 5
+#define RESUME_BASE_DELAY_MS 500
+#define RESUME_MAX_DELAY_MS 8000
+
 
 static const char* const RTC_CALL_STATE_STRINGS[] = {
     "idle",
@@ -33,6 +44,10 @@ static const char* const RTC_CALL_STATE_STRINGS[] = {
 
 #if NERTC_ENABLE_CONFIG_FILE
 std::string NeRtcProtocol::config_file_path_ = "/spiffs/config.json";
+
+static std::mutex local_config_mutex;
+static std::unique_ptr<NeRtcLocalConfig> cached_local_config;
+static NeRtcConfigCacheStatistics config_cache_statistics;
 #endif
 
 void ParseSongListFromJson(const std::string& json, std::vector<MusicInfo>& out_list, bool& play_now){
@@ -101,44 +116,31 @@ NeRtcProtocol::NeRtcProtocol() {
         return;
     }
 
-    auto* config_json = NeRtcProtocol::ReadConfigJson();
-    if(config_json) {
-        cJSON* appkey = cJSON_GetObjectItem(config_json, "appkey");
-        if (appkey && cJSON_IsString(appkey)) {
-            ESP_LOGI(TAG, "local config set appkey to %s", appkey->valuestring);
-            local_config_appkey_ = appkey->valuestring;
+    const auto& local_config = NeRtcProtocol::GetLocalConfig();
+    if (local_config.valid) {
+        if (!local_config.appkey.empty()) {
+            ESP_LOGI(TAG, "local config set appkey to %s", local_config.appkey.c_str());
+            local_config_appkey_ = local_config.appkey;
         }
-        cJSON* custom_config = cJSON_GetObjectItem(config_json, "custom_config");
-        if (custom_config && cJSON_IsObject(custom_config)) {
-            cJSON_AddStringToObject(custom_config, "custom_license_key", device_id.c_str());
-            custom_config_string = cJSON_Print(custom_config);
+        if (!local_config.sdk_custom_config.empty()) {
+            custom_config_string = local_config.sdk_custom_config;
             ESP_LOGI(TAG, "local config set custom_config to %s", custom_config_string.c_str());
-            cJSON* asr = cJSON_GetObjectItem(custom_config, "asr");
-            if (asr && cJSON_IsBool(asr)) {
-                asr_enabled_ = asr->valueint;
-                ESP_LOGI(TAG, "local config set asr to %d", asr_enabled_?1:0);
-            }
-            cJSON* rtc_call = cJSON_GetObjectItem(custom_config, "rtc_call");
-            if(rtc_call && cJSON_IsBool(rtc_call)) {
-                rtc_mode_ = rtc_call->valueint;
-                ESP_LOGI(TAG, "local config set rtc_p2p to %d", rtc_mode_?1:0);
-            }
         }
-        cJSON* audio_config = cJSON_GetObjectItem(config_json, "audio_config");
-        if (audio_config) {
-            cJSON* frame_size = cJSON_GetObjectItem(audio_config, "frame_size");
-            if (cJSON_IsNumber(frame_size)) {
-                ESP_LOGI(TAG, "local config set frame size to %d ms", frame_size->valueint);
-                local_frame_duration_config = cJSON_GetNumberValue(frame_size);
-            }
+        if (local_config.asr >= 0) {
+            asr_enabled_ = local_config.asr;
+            ESP_LOGI(TAG, "local config set asr to %d", asr_enabled_?1:0);
         }
-        cJSON* license_config = cJSON_GetObjectItem(config_json, "license_config");
-        if (license_config) {
-            cJSON* local_license = cJSON_GetObjectItem(license_config, "license");
-            if (cJSON_IsString(local_license)) {
-                local_license_config = local_license->valuestring;
-                ESP_LOGI(TAG, "local license config, size: %d", local_license_config.size());
-            }
+        if (local_config.rtc_call >= 0) {
+            rtc_mode_ = local_config.rtc_call;
+            ESP_LOGI(TAG, "local config set rtc_p2p to %d", rtc_mode_?1:0);
+        }
+        if (local_config.frame_size > 0) {
+            ESP_LOGI(TAG, "local config set frame size to %d ms", local_config.frame_size);
+            local_frame_duration_config = local_config.frame_size;
+        }
+        if (!local_config.license.empty()) {
+            local_license_config = local_config.license;
+            ESP_LOGI(TAG, "local license config, size: %d", local_license_config.size());
         }
     }
     else{
@@ -230,10 +232,6 @@ NeRtcProtocol::NeRtcProtocol() {
         engine_config.ext_net_handle = nullptr;
     }
 
-#if NERTC_ENABLE_CONFIG_FILE
-    cJSON_Delete(config_json);
-#endif
-
     // 初始化引擎
     auto ret = nertc_init_engine(engine_, &engine_config);
 
@@ -247,10 +245,14 @@ NeRtcProtocol::NeRtcProtocol() {
         .callback = [](void* arg) {
             NeRtcProtocol* instance = static_cast<NeRtcProtocol*>(arg);
             if (instance) {
-                cJSON* data = cJSON_CreateObject();
-                cJSON_AddStringToObject(data, "type", "system");
-                cJSON_AddStringToObject(data, "command", "sleep");
-                if (instance->on_incoming_json_) instance->on_incoming_json_(data);
+                // 不占用 esp_timer 任务，与其他 NeRTC 定时器一样转到主循环处理
+                Application::GetInstance().Schedule([instance]() {
+                    IncomingMessage message;
+                    message.type = kIncomingMessageSystem;
+                    message.type_name = "system";
+                    message.command = "sleep";
+                    instance->DispatchIncomingMessage(message);
+                });
             }
         },
         .arg = this,
@@ -263,6 +265,43 @@ NeRtcProtocol::NeRtcProtocol() {
         return;
     }
 
+    const esp_timer_create_args_t resume_timer_args = {
+        .callback = [](void* arg) {
+            NeRtcProtocol* instance = static_cast<NeRtcProtocol*>(arg);
+            Application::GetInstance().Schedule([instance]() {
+                instance->TryResume();
+            });
+        },
+        .arg = this,
+        .name = "nertc_resume_timer"
+    };
+    err = esp_timer_create(&resume_timer_args, &resume_timer_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "create nertc_resume_timer fail err: %s", esp_err_to_name(err));
+        return;
+    }
+
+#if CONFIG_NERTC_WARM_STANDBY
+    const esp_timer_create_args_t standby_timer_args = {
+        .callback = [](void* arg) {
+            NeRtcProtocol* instance = static_cast<NeRtcProtocol*>(arg);
+            Application::GetInstance().Schedule([instance]() {
+                if (!instance->audio_channel_opened_.load() && instance->ai_started_.load()) {
+                    ESP_LOGI(TAG, "Warm standby budget exhausted, stop AI");
+                    instance->StopAi();
+                }
+            });
+        },
+        .arg = this,
+        .name = "nertc_standby_timer"
+    };
+    err = esp_timer_create(&standby_timer_args, &standby_timer_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "create nertc_standby_timer fail err: %s", esp_err_to_name(err));
+        return;
+    }
+#endif
+
     event_group_ = xEventGroupCreate();
 
     ESP_LOGI(TAG, "Create success device_id:%s rtc_sdk version:%s mem:[Free:%u Mini: %u])", device_id.c_str(), nertc_get_version(),
@@ -277,6 +316,16 @@ NeRtcProtocol::~NeRtcProtocol() {
         esp_timer_stop(close_timer_);
         esp_timer_delete(close_timer_);
     }
+    if (resume_timer_ != nullptr) {
+        esp_timer_stop(resume_timer_);
+        esp_timer_delete(resume_timer_);
+    }
+#if CONFIG_NERTC_WARM_STANDBY
+    if (standby_timer_ != nullptr) {
+        esp_timer_stop(standby_timer_);
+        esp_timer_delete(standby_timer_);
+    }
+#endif
 
     if (engine_) {
         nertc_destroy_engine(engine_);
@@ -307,27 +356,28 @@ bool NeRtcProtocol::Start() {
     // join room
     uint64_t uid = UID;
 #if NERTC_ENABLE_CONFIG_FILE
-    cJSON* config_json = NeRtcProtocol::ReadConfigJson();
-    if(config_json) {
-        cJSON* custom_config = cJSON_GetObjectItem(config_json, "custom_config");
-        if (custom_config && cJSON_IsObject(custom_config)) {
-            cJSON* item = cJSON_GetObjectItem(custom_config, "cname");
-            if(item && cJSON_IsString(item)) {
-                cname_ = item->valuestring;
-            }
-            item = cJSON_GetObjectItem(custom_config, "uid");
-            if(item && cJSON_IsNumber(item)) {
-                uid = item->valueint;
-            }
-        }
-        cJSON_Delete(config_json);
+    const auto& local_config = NeRtcProtocol::GetLocalConfig();
+    if (!local_config.cname.empty()) {
+        cname_ = local_config.cname;
     }
+    if (local_config.has_uid) {
+        uid = local_config.uid;
+    }
+    auto cache_statistics = NeRtcProtocol::GetConfigCacheStatistics();
+    uint32_t session_hits = cache_statistics.cache_hits - last_config_cache_hits_;
+    last_config_cache_hits_ = cache_statistics.cache_hits;
+    ESP_LOGI(TAG, "Config cache: spiffs reads %lu, hits %lu (+%lu this session, ~%lld us saved)",
+        cache_statistics.spiffs_reads, cache_statistics.cache_hits, session_hits,
+        cache_statistics.last_load_time_us * session_hits);
 #endif
     if (cname_.empty()) {
         uint32_t random_num = 100000 + (esp_random() % 900000);
         cname_ = std::string("80") + std::to_string(random_num);
     }
     ESP_LOGI(TAG, "Join cname = %s", cname_.c_str());
+    checksum_ = checksum;
+    join_uid_ = uid;
+    xEventGroupClearBits(event_group_, JOIN_EVENT);
     auto ret = nertc_join(engine_, cname_.c_str(), checksum.c_str(), uid);
     if (ret != 0) {
         ESP_LOGE(TAG, "Join failed, error: %d", ret);
@@ -336,6 +386,16 @@ bool NeRtcProtocol::Start() {
 
     xEventGroupWaitBits(event_group_, JOIN_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000)); //最长阻塞10秒
 
+#if CONFIG_NERTC_WARM_STANDBY
+    // 入会后立即预热 AI 会话，唤醒时无需再等待 start_ai
+    if (join_.load() && !rtc_mode_ && !ai_started_.load()) {
+        StartAi("");
+        if (CONFIG_NERTC_WARM_STANDBY_BUDGET_SECONDS > 0) {
+            esp_timer_stop(standby_timer_);
+            esp_timer_start_once(standby_timer_, (uint64_t)CONFIG_NERTC_WARM_STANDBY_BUDGET_SECONDS * 1000 * 1000);
+        }
+    }
+#endif
     return join_.load();
 }
 
@@ -348,24 +408,36 @@ bool NeRtcProtocol::OpenAudioChannel(const std::string& wake_word) {
         return false;
     }
 
-    nertc_sdk_start_ai_config_t config;
-    nertc_sdk_start_ai_config_init(&config);
-    if (!wake_word.empty()) {
-        config.start_topic = wake_word.c_str();
-        config.start_topic_len = wake_word.length();
-    }
-    auto ret = nertc_start_ai_with_config(engine_, &config);
-    if (ret != 0) {
-        ESP_LOGE(TAG, "Start AI failed, error: %d", ret);
-        return false;
+    open_time_us_.store(esp_timer_get_time());
+#if CONFIG_NERTC_WARM_WAKE_WORD_AS_PROMPT
+    constexpr bool wake_word_as_prompt = true;
+#else
+    constexpr bool wake_word_as_prompt = false;
+#endif
+    auto path = ChooseNeRtcOpenPath(ai_started_.load(), !wake_word.empty(), wake_word_as_prompt);
+#if CONFIG_NERTC_WARM_STANDBY
+    if (path != kNeRtcOpenCold) {
+        esp_timer_stop(standby_timer_);
     }
-    if (asr_enabled_) {
-        nertc_sdk_asr_caption_config_t asr_config;
-        ret = nertc_start_asr_caption(engine_, &asr_config);
-        if (ret != 0) {
-            ESP_LOGE(TAG, "Start ASR caption failed, error: %d", ret);
+#endif
+    open_warm_ = path == kNeRtcOpenWarm || path == kNeRtcOpenWarmPrompt;
+    if (open_warm_) {
+        // AI 会话已预热，只需本地打开通道
+        if (path == kNeRtcOpenWarmPrompt) {
+            nertc_ai_llm_prompt(engine_, wake_word.c_str(), 1);
+        }
+        open_statistics_.warm_opens++;
+    } else {
+        if (path == kNeRtcOpenRestart) {
+            // 唤醒词需要作为 start_topic 下发，重启预热的会话
+            StopAi();
+            open_statistics_.warm_restarts++;
+        }
+        if (!StartAi(wake_word)) {
+            open_time_us_.store(0);
             return false;
         }
+        open_statistics_.cold_opens++;
     }
 
     if (on_audio_channel_opened_ != nullptr) {
@@ -384,9 +456,21 @@ void NeRtcProtocol::CloseAudioChannel() {
     int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
     ESP_LOGI(TAG, "NeRtcProtocol CloseAudioChannel Free internal: %u minimal internal: %u", free_sram, min_free_sram);
 
-    nertc_stop_ai(engine_);
-
-    nertc_stop_asr_caption(engine_);
+    open_time_us_.store(0);
+#if CONFIG_NERTC_WARM_STANDBY
+    if (ai_started_.load() && join_.load()) {
+        // 保持 AI 会话，打断当前播报后进入待机，超出预算再停止
+        nertc_ai_manual_interrupt(engine_);
+        if (CONFIG_NERTC_WARM_STANDBY_BUDGET_SECONDS > 0) {
+            esp_timer_stop(standby_timer_);
+            esp_timer_start_once(standby_timer_, (uint64_t)CONFIG_NERTC_WARM_STANDBY_BUDGET_SECONDS * 1000 * 1000);
+        }
+    } else {
+        StopAi();
+    }
+#else
+    StopAi();
+#endif
 
     if (on_audio_channel_closed_ != nullptr) {
         on_audio_channel_closed_();
@@ -395,6 +479,52 @@ void NeRtcProtocol::CloseAudioChannel() {
     audio_channel_opened_.store(false);
 }
 
+bool NeRtcProtocol::StartAi(const std::string& wake_word) {
+    nertc_sdk_start_ai_config_t config;
+    nertc_sdk_start_ai_config_init(&config);
+    if (!wake_word.empty()) {
+        config.start_topic = wake_word.c_str();
+        config.start_topic_len = wake_word.length();
+    }
+    auto ret = nertc_start_ai_with_config(engine_, &config);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Start AI failed, error: %d", ret);
+        return false;
+    }
+    ai_started_.store(true);
+    if (asr_enabled_) {
+        nertc_sdk_asr_caption_config_t asr_config;
+        ret = nertc_start_asr_caption(engine_, &asr_config);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "Start ASR caption failed, error: %d", ret);
+            return false;
+        }
+    }
+    return true;
+}
+
+void NeRtcProtocol::StopAi() {
+    nertc_stop_ai(engine_);
+    nertc_stop_asr_caption(engine_);
+    ai_started_.store(false);
+}
+
+void NeRtcProtocol::RecordFirstAudio(int64_t latency_us) {
+    uint64_t average_us;
+    if (open_warm_) {
+        open_statistics_.warm_first_audio_us += latency_us;
+        open_statistics_.warm_samples++;
+        average_us = open_statistics_.warm_first_audio_us / open_statistics_.warm_samples;
+    } else {
+        open_statistics_.cold_first_audio_us += latency_us;
+        open_statistics_.cold_samples++;
+        average_us = open_statistics_.cold_first_audio_us / open_statistics_.cold_samples;
+    }
+    ESP_LOGI(TAG, "First audio %lld ms after open (%s, avg %llu ms), opens warm %lu cold %lu (warm restarts %lu)",
+        latency_us / 1000, open_warm_ ? "warm" : "cold", average_us / 1000,
+        open_statistics_.warm_opens, open_statistics_.cold_opens, open_statistics_.warm_restarts);
+}
+
 bool NeRtcProtocol::IsAudioChannelOpened() const {
     return join_.load() && audio_channel_opened_.load();
 }
@@ -416,35 +546,38 @@ bool NeRtcProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
             return false;
         }
 
+        // PCM 直通：数据直接引用包内缓冲区，SDK 内部完成编码
         nertc_sdk_audio_frame_t audio_frame;
+        nertc_sdk_audio_frame_init(&audio_frame);
         audio_frame.type = NERTC_SDK_AUDIO_PCM_16;
+        audio_frame.config.sample_rate = packet->sample_rate;
+        audio_frame.config.channels = 1;
+        audio_frame.config.frame_duration = packet->frame_duration;
+        audio_frame.config.samples_per_channel = packet->pcm_payload.size();
         audio_frame.data = const_cast<int16_t*>(packet->pcm_payload.data());
         audio_frame.length = packet->pcm_payload.size();
-        nertc_push_audio_frame(engine_, NERTC_SDK_MEDIA_MAIN_AUDIO, &audio_frame);
+        if (nertc_push_audio_frame(engine_, NERTC_SDK_MEDIA_MAIN_AUDIO, &audio_frame) != 0) {
+            ESP_LOGW(TAG, "Push PCM audio frame failed, samples: %d", audio_frame.length);
+        }
     }
 
     return true;
 }
 
-void NeRtcProtocol::SendAecReferenceAudio(std::unique_ptr<AudioStreamPacket> packet) {
-    if (!engine_ || !join_.load() || !packet)
-        return;
-
-    if (packet->sample_rate != server_sample_rate_) {
-        ESP_LOGE(TAG, "SendAecReferenceAudio sample rate mismatch: expected %d, got %d",
-                server_sample_rate_, packet->sample_rate);
+void NeRtcProtocol::SendAecReferenceAudio(const AudioStreamPacket& packet) {
+    if (!engine_ || !join_.load())
         return;
-    }
 
+    // 参考帧直接引用下行包的编码数据，SDK 在调用内完成消费
     nertc_sdk_audio_encoded_frame_t encoded_frame;
-    encoded_frame.data = const_cast<unsigned char*>(packet->payload.data());
-    encoded_frame.length = packet->payload.size();
-    encoded_frame.encoded_timestamp = packet->timestamp;
+    encoded_frame.data = const_cast<unsigned char*>(packet.payload.data());
+    encoded_frame.length = packet.payload.size();
+    encoded_frame.encoded_timestamp = packet.timestamp;
 
     nertc_sdk_audio_frame_t audio_frame;
     audio_frame.type = NERTC_SDK_AUDIO_PCM_16;
-    audio_frame.data = const_cast<int16_t*>(packet->pcm_payload.data());
-    audio_frame.length = packet->pcm_payload.size();
+    audio_frame.data = const_cast<int16_t*>(packet.pcm_payload.data());
+    audio_frame.length = packet.pcm_payload.size();
     nertc_push_audio_reference_frame(engine_, NERTC_SDK_MEDIA_MAIN_AUDIO, &encoded_frame, &audio_frame);
 }
 
@@ -477,13 +610,11 @@ void NeRtcProtocol::SendLlmImage(const char* img_url, const int32_t img_len, con
     nertc_ai_llm_image(engine_, request);
     delete request;
 
-    cJSON* data = cJSON_CreateObject();
-    cJSON_AddStringToObject(data, "type", "stt");
-    cJSON_AddStringToObject(data, "text", "llm image sent");
-    if (data) {
-        on_incoming_json_(data);
-        cJSON_Delete(data);
-    }
+    IncomingMessage message;
+    message.type = kIncomingMessageStt;
+    message.type_name = "stt";
+    message.text = "llm image sent";
+    DispatchIncomingMessage(message);
 }
 
 void NeRtcProtocol::SetAISleep() {
@@ -581,34 +712,33 @@ void NeRtcProtocol::ParseFunctionCall(cJSON* data, std::string& arguments, std::
     }
 }
 
-cJSON* NeRtcProtocol::BuildApplicationAsrProtocol(bool local_user ,const char* text) {
-    cJSON* data = cJSON_CreateObject();
+void NeRtcProtocol::DispatchAsrCaption(bool local_user, const char* text) {
+    IncomingMessage message;
     if (local_user) {
-        cJSON_AddStringToObject(data, "type", "stt");
-        cJSON_AddStringToObject(data, "text", text);
+        message.type = kIncomingMessageStt;
+        message.type_name = "stt";
     } else {
-        std::string type    = "tts";
-        std::string state   = "sentence_start";
-        cJSON_AddStringToObject(data, "type", type.c_str());
-        cJSON_AddStringToObject(data, "state", state.c_str());
-        cJSON_AddStringToObject(data, "text", text);
+        message.type = kIncomingMessageTts;
+        message.type_name = "tts";
+        message.state = "sentence_start";
     }
-
-    return data;
+    message.text = text;
+    DispatchIncomingMessage(message);
 }
 
-cJSON* NeRtcProtocol::BuildApplicationTtsStateProtocol(const std::string& event) {
-    cJSON* data = cJSON_CreateObject();
-    cJSON_AddStringToObject(data, "type", "tts");
-    std::string state;
-    if (event == "audio.agent.speech_started") {
-        state = "start";
-    } else if (event == "audio.agent.speech_stopped") {
-        state = "stop";
+void NeRtcProtocol::DispatchTtsState(const char* event, uint8_t json_parses) {
+    IncomingMessage message;
+    message.type = kIncomingMessageTts;
+    message.type_name = "tts";
+    message.json_parses = json_parses;
+    if (strcmp(event, "audio.agent.speech_started") == 0) {
+        message.state = "start";
+    } else if (strcmp(event, "audio.agent.speech_stopped") == 0) {
+        message.state = "stop";
+    } else {
+        return;
     }
-    cJSON_AddStringToObject(data, "state", state.c_str());
-
-    return data;
+    DispatchIncomingMessage(message);
 }
 
 cJSON* NeRtcProtocol::BuildApplicationIotVolumeProtocol(int volume) {
@@ -686,10 +816,12 @@ void NeRtcProtocol::OnError(const nertc_sdk_callback_context_t* ctx, nertc_sdk_e
 
     NeRtcProtocol* instance = static_cast<NeRtcProtocol*>(ctx->user_data);
     if (ctx->engine && instance) {
-        ESP_LOGE(TAG, "NERtc OnError: leave and rejoin room");
+        ESP_LOGE(TAG, "NERtc OnError: leave and resume session");
         nertc_leave(ctx->engine);
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        instance->Start();
+        instance->join_.store(false);
+        Application::GetInstance().Schedule([instance]() {
+            instance->BeginResume("error");
+        });
     }
 }
 
@@ -711,6 +843,15 @@ void NeRtcProtocol::OnJoin(const nertc_sdk_callback_context_t* ctx, uint64_t cid
     if (ctx->engine && instance) {
         if (code != NERTC_SDK_ERR_SUCCESS) {
             ESP_LOGE(TAG, "Failed to join room, error: %d", code);
+            if (instance->resuming_.load()) {
+                // 立即按退避间隔重试，不必等超时
+                Application::GetInstance().Schedule([instance]() {
+                    if (instance->resuming_.load() && !instance->join_.load()) {
+                        esp_timer_stop(instance->resume_timer_);
+                        instance->ScheduleResumeAttempt();
+                    }
+                });
+            }
             return;
         }
 
@@ -722,6 +863,12 @@ void NeRtcProtocol::OnJoin(const nertc_sdk_callback_context_t* ctx, uint64_t cid
         instance->server_frame_duration_ = recommended_config->recommended_audio_config.frame_duration;
         instance->samples_per_channel_ = recommended_config->recommended_audio_config.samples_per_channel;
         instance->recommended_audio_config_ = recommended_config->recommended_audio_config;
+
+        if (instance->resuming_.load()) {
+            Application::GetInstance().Schedule([instance]() {
+                instance->FinishResume();
+            });
+        }
     }
 
     xEventGroupSetBits(instance->event_group_, JOIN_EVENT);
@@ -734,8 +881,112 @@ void NeRtcProtocol::OnDisconnect(const nertc_sdk_callback_context_t* ctx, nertc_
     if (!instance)
         return;
 
-    instance->CloseAudioChannel();;
-    ESP_LOGI(TAG, "Stop for receive OnDisconnect, please restart later");
+    // 保持通道与 AI 状态，后台用原入会参数快速恢复，恢复失败后再关闭通道并完整重新入会
+    instance->join_.store(false);
+    Application::GetInstance().Schedule([instance]() {
+        instance->BeginResume("disconnect");
+    });
+}
+
+// 以下恢复流程都在主循环中执行
+void NeRtcProtocol::BeginResume(const char* reason) {
+    if (!engine_ || rejoining_.load() || resuming_.exchange(true)) {
+        return;
+    }
+    join_.store(false);
+    resume_ai_ = ai_started_.exchange(false);
+    resume_attempt_ = 0;
+    disconnect_time_us_ = esp_timer_get_time();
+    ESP_LOGW(TAG, "Session lost (%s), resume cname=%s ai=%d channel=%d", reason, cname_.c_str(),
+        resume_ai_, audio_channel_opened_.load());
+    ScheduleResumeAttempt();
+}
+
+void NeRtcProtocol::ScheduleResumeAttempt() {
+    int delay_ms = std::min(RESUME_BASE_DELAY_MS << resume_attempt_, RESUME_MAX_DELAY_MS);
+    esp_err_t err = esp_timer_start_once(resume_timer_, (uint64_t)delay_ms * 1000);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "start nertc_resume_timer fail err: %s", esp_err_to_name(err));
+    }
+}
+
+// 不阻塞：发起入会后由 OnJoin 或下一次定时器推进
+void NeRtcProtocol::TryResume() {
+    if (!resuming_.load() || join_.load()) {
+        return;
+    }
+    if (resume_attempt_ >= RESUME_MAX_ATTEMPTS) {
+        ESP_LOGE(TAG, "Resume failed after %d attempts, full rejoin", resume_attempt_);
+        // 先在主循环中关闭通道，之后通道保持关闭直到重新入会完成，用户再次唤醒时 OpenAudioChannel 因 join_ 为假直接失败
+        if (audio_channel_opened_.load()) {
+            CloseAudioChannel();
+        }
+        resuming_.store(false);
+        // 重新入会需要 HTTP 获取 checksum 并最长等待 10 秒入会结果，放在独立任务中，完成后回到主循环记录
+        rejoining_.store(true);
+        if (xTaskCreate([](void* arg) {
+                static_cast<NeRtcProtocol*>(arg)->FullRejoin();
+                vTaskDelete(NULL);
+            }, "nertc_rejoin", 4096, this, 3, nullptr) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create nertc_rejoin task");
+            rejoining_.store(false);
+        }
+        return;
+    }
+
+    resume_attempt_++;
+    resume_statistics_.resume_attempts++;
+    ESP_LOGI(TAG, "Resume attempt %d, cname=%s", resume_attempt_, cname_.c_str());
+    auto ret = nertc_join(engine_, cname_.c_str(), checksum_.c_str(), join_uid_);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Resume join failed, error: %d", ret);
+    }
+    // 同时作为本次入会的超时
+    ScheduleResumeAttempt();
+}
+
+void NeRtcProtocol::FinishResume() {
+    if (!resuming_.exchange(false)) {
+        return;
+    }
+    esp_timer_stop(resume_timer_);
+    if (resume_ai_ && !StartAi("")) {
+        ESP_LOGE(TAG, "Resume: restart AI failed");
+        if (audio_channel_opened_.load()) {
+            CloseAudioChannel();
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - disconnect_time_us_;
+    resume_statistics_.resume_count++;
+    resume_statistics_.resume_total_us += elapsed_us;
+    ESP_LOGI(TAG, "Session resumed in %lld ms after %d attempts (resume %lu avg %llu ms, full rejoin %lu)",
+        elapsed_us / 1000, resume_attempt_, resume_statistics_.resume_count,
+        resume_statistics_.resume_total_us / resume_statistics_.resume_count / 1000,
+        resume_statistics_.full_rejoin_count);
+}
+
+// 在 nertc_rejoin 任务中执行
+void NeRtcProtocol::FullRejoin() {
+    nertc_leave(engine_);
+    bool success = Start();
+    Application::GetInstance().Schedule([this, success]() {
+        rejoining_.store(false);
+        if (!success) {
+            ESP_LOGE(TAG, "Full rejoin failed, please restart later");
+            return;
+        }
+        int64_t elapsed_us = esp_timer_get_time() - disconnect_time_us_;
+        resume_statistics_.full_rejoin_count++;
+        resume_statistics_.full_rejoin_total_us += elapsed_us;
+        ESP_LOGI(TAG, "Full rejoin in %lld ms (full rejoin %lu avg %llu ms, resume %lu)",
+            elapsed_us / 1000, resume_statistics_.full_rejoin_count,
+            resume_statistics_.full_rejoin_total_us / resume_statistics_.full_rejoin_count / 1000,
+            resume_statistics_.resume_count);
+        // 入会后、回到主循环前又断线时，断线回调的恢复请求已被忽略，这里补上
+        if (!join_.load()) {
+            BeginResume("disconnect");
+        }
+    });
 }
 
 void NeRtcProtocol::OnUserJoined(const nertc_sdk_callback_context_t* ctx, const nertc_sdk_user_info* user) {
@@ -776,12 +1027,7 @@ void NeRtcProtocol::OnAsrCaptionResult(const nertc_sdk_callback_context_t* ctx,
         return;
 
     for (int i = 0; i < result_count; i++) {
-        auto result = results[i];
-        cJSON* caption_json = instance->BuildApplicationAsrProtocol(result.is_local_user, result.content);
-        if (caption_json) {
-            if (instance->on_incoming_json_) instance->on_incoming_json_(caption_json);
-            cJSON_Delete(caption_json);
-        }
+        instance->DispatchAsrCaption(results[i].is_local_user, results[i].content);
     }
 }
 
@@ -811,24 +1057,20 @@ void NeRtcProtocol::OnAiData(const nertc_sdk_callback_context_t* ctx, nertc_sdk_
             return;
         }
         cJSON* event = cJSON_GetObjectItem(data_json, "event");
-        if (!event) {
+        if (!cJSON_IsString(event)) {
             ESP_LOGE(TAG, "event is invalid");
             cJSON_Delete(data_json);
             return;
         }
 
-        std::string event_str = event->valuestring;
-        if (event_str.find("audio.agent.speech_") == 0) {
+        if (strncmp(event->valuestring, "audio.agent.speech_", strlen("audio.agent.speech_")) == 0) {
             if (instance->rtc_mode_) {
                 ESP_LOGW(TAG, "RTC mode, ignore audio.agent.speech_ event");
-                return;
+            } else {
+                instance->DispatchTtsState(event->valuestring, 1);
             }
-            cJSON* state_json = instance->BuildApplicationTtsStateProtocol(event_str);
-            if (instance->on_incoming_json_) instance->on_incoming_json_(state_json);
-            cJSON_Delete(state_json);
-            cJSON_Delete(data_json);
-            return;
         }
+        cJSON_Delete(data_json);
     } else if (strncmp(type_str, "tool", type_len) == 0) {
         cJSON* data_json = cJSON_Parse(data_str);
         if (!data_json) {
@@ -907,25 +1149,29 @@ void NeRtcProtocol::OnAiData(const nertc_sdk_callback_context_t* ctx, nertc_sdk_
             cJSON_Delete(data_json);
             return;
         }
-        std::string emotion = message->valuestring;
-        cJSON* emot_json = cJSON_CreateObject();
-        cJSON_AddStringToObject(emot_json, "type",    "llm");
-        cJSON_AddStringToObject(emot_json, "emotion", emotion.c_str());
-        if (instance->on_incoming_json_) instance->on_incoming_json_(emot_json);
-        cJSON_Delete(emot_json);
+        IncomingMessage emotion;
+        emotion.type = kIncomingMessageLlm;
+        emotion.type_name = "llm";
+        emotion.emotion = message->valuestring;
+        emotion.json_parses = 1;
+        instance->DispatchIncomingMessage(emotion);
         cJSON_Delete(data_json);
     } else if (strncmp(type_str, "mcp", type_len) == 0) {
+        // MCP 请求树在竞技场中分配，分发结束后一次回收
+        CJsonArenaScope arena;
         cJSON* payload_obj = cJSON_Parse(data_str);
         if (!payload_obj) {
             ESP_LOGE(TAG, "Failed to parse JSON data");
             return;
         }
 
-        cJSON* mcp_json = cJSON_CreateObject();
-        cJSON_AddStringToObject(mcp_json, "type", "mcp");
-        cJSON_AddItemToObject(mcp_json, "payload", payload_obj);
-        if (instance->on_incoming_json_) instance->on_incoming_json_(mcp_json);
-        cJSON_Delete(mcp_json);
+        IncomingMessage mcp;
+        mcp.type = kIncomingMessageMcp;
+        mcp.type_name = "mcp";
+        mcp.payload = payload_obj;
+        mcp.json_parses = 1;
+        instance->DispatchIncomingMessage(mcp);
+        cJSON_Delete(payload_obj);
 
     }else if(strncmp(type_str, "songSearch", type_len) == 0) {
         cJSON* data_json = cJSON_Parse(data_str);
@@ -959,23 +1205,48 @@ void NeRtcProtocol::OnAudioData(const nertc_sdk_callback_context_t* ctx, uint64_
     if (!instance)
         return;
 
-    std::vector<uint8_t> payload_vector;
-    if(encoded_frame->data) {
-        payload_vector.assign(encoded_frame->data, encoded_frame->data + encoded_frame->length);
-    }
-
     if (instance->on_incoming_audio_ != nullptr) {
-        auto packet = std::make_unique<AudioStreamPacket>();
-        packet->sample_rate = instance->recommended_audio_config_.out_sample_rate;
-        packet->frame_duration = instance->server_frame_duration_;
-        packet->timestamp = encoded_frame->encoded_timestamp;
-        packet->payload = std::move(payload_vector);
+        // SDK 的帧缓冲只在回调内有效，这里是下行链路唯一的一次拷贝
+        auto packet = CopyDownlinkFrame(encoded_frame->data, encoded_frame->length, encoded_frame->encoded_timestamp,
+            instance->recommended_audio_config_.out_sample_rate, instance->server_frame_duration_, [](size_t bytes) {
+                Application::GetInstance().GetAudioService().CountDownlinkBytesCopied(bytes);
+            });
         packet->muted = is_mute_packet;
 
+        int64_t open_time = instance->open_time_us_.load();
+        if (open_time > 0 && !is_mute_packet && instance->open_time_us_.compare_exchange_strong(open_time, 0)) {
+            instance->RecordFirstAudio(esp_timer_get_time() - open_time);
+        }
+
         instance->on_incoming_audio_(std::move(packet));
     }
 }
 
+// 控制消息直接调用 SDK 接口，不再拼接 JSON 后由 SendText 再解析
+void NeRtcProtocol::SendAbortSpeaking(AbortReason reason) {
+    if (!engine_)
+        return;
+    nertc_ai_manual_interrupt(engine_);
+    DispatchTtsState("audio.agent.speech_stopped");
+}
+
+void NeRtcProtocol::SendStartListening(ListeningMode mode) {
+    if (!engine_)
+        return;
+    nertc_ai_manual_start_listen(engine_);
+}
+
+void NeRtcProtocol::SendStopListening() {
+    if (!engine_)
+        return;
+    nertc_ai_manual_stop_listen(engine_);
+}
+
+void NeRtcProtocol::SendWakeWordDetected(const std::string& wake_word) {
+    // 唤醒词通过 OpenAudioChannel 的 start_topic 传递，这里无需再发送
+    ESP_LOGD(TAG, "SendWakeWordDetected: %s", wake_word.c_str());
+}
+
 bool NeRtcProtocol::SendText(const std::string& text) {
     ESP_LOGI(TAG, "SendText: %s", text.c_str());
     if (!engine_)
@@ -990,9 +1261,7 @@ bool NeRtcProtocol::SendText(const std::string& text) {
     std::string type = type_item->valuestring;
     if (type == "abort") {
         nertc_ai_manual_interrupt(engine_);
-        cJSON* state_json = BuildApplicationTtsStateProtocol("audio.agent.speech_stopped");
-        if (on_incoming_json_) on_incoming_json_(state_json);
-        cJSON_Delete(state_json);
+        DispatchTtsState("audio.agent.speech_stopped");
     } else if (type == "listen") {
         cJSON* state_item = cJSON_GetObjectItem(data_json, "state");
         if (state_item == nullptr || !cJSON_IsString(state_item)) {
@@ -1012,7 +1281,7 @@ bool NeRtcProtocol::SendText(const std::string& text) {
     return true;
 }
 
-void NeRtcProtocol::SendMcpMessage(const std::string& payload) {
+void NeRtcProtocol::SendMcpMessage(std::string payload) {
     ESP_LOGI(TAG, "mcp payload: %s", payload.c_str());
     nertc_sdk_mcp_tool_result_t result;
     nertc_sdk_mcp_tool_result_init(&result);
@@ -1118,3 +1387,89 @@ cJSON* NeRtcProtocol::ReadConfigJson() {
     return json;
 }
 #endif
+
+#if NERTC_ENABLE_CONFIG_FILE
+static void ParseLocalConfig(cJSON* json, const std::string& device_id, NeRtcLocalConfig& config) {
+    config = NeRtcLocalConfig();
+    if (!json) {
+        return;
+    }
+    config.valid = true;
+
+    cJSON* appkey = cJSON_GetObjectItem(json, "appkey");
+    if (cJSON_IsString(appkey)) {
+        config.appkey = appkey->valuestring;
+    }
+    cJSON* custom_config = cJSON_GetObjectItem(json, "custom_config");
+    if (cJSON_IsObject(custom_config)) {
+        char* str = cJSON_PrintUnformatted(custom_config);
+        if (str) {
+            config.custom_config = str;
+            cJSON_free(str);
+        }
+        // SDK 需要的版本在同一棵树上追加设备 ID 后输出，不再重新解析
+        if (cJSON_AddStringToObject(custom_config, "custom_license_key", device_id.c_str()) != nullptr) {
+            str = cJSON_PrintUnformatted(custom_config);
+            if (str) {
+                config.sdk_custom_config = str;
+                cJSON_free(str);
+            }
+        }
+        cJSON* item = cJSON_GetObjectItem(custom_config, "asr");
+        if (cJSON_IsBool(item)) {
+            config.asr = cJSON_IsTrue(item) ? 1 : 0;
+        }
+        item = cJSON_GetObjectItem(custom_config, "rtc_call");
+        if (cJSON_IsBool(item)) {
+            config.rtc_call = cJSON_IsTrue(item) ? 1 : 0;
+        }
+        item = cJSON_GetObjectItem(custom_config, "cname");
+        if (cJSON_IsString(item)) {
+            config.cname = item->valuestring;
+        }
+        item = cJSON_GetObjectItem(custom_config, "uid");
+        if (cJSON_IsNumber(item)) {
+            config.has_uid = true;
+            config.uid = item->valueint;
+        }
+    }
+    cJSON* audio_config = cJSON_GetObjectItem(json, "audio_config");
+    if (audio_config) {
+        cJSON* frame_size = cJSON_GetObjectItem(audio_config, "frame_size");
+        if (cJSON_IsNumber(frame_size)) {
+            config.frame_size = frame_size->valueint;
+        }
+    }
+    cJSON* license_config = cJSON_GetObjectItem(json, "license_config");
+    if (license_config) {
+        cJSON* license = cJSON_GetObjectItem(license_config, "license");
+        if (cJSON_IsString(license)) {
+            config.license = license->valuestring;
+        }
+    }
+}
+
+const NeRtcLocalConfig& NeRtcProtocol::GetLocalConfig() {
+    std::lock_guard<std::mutex> lock(local_config_mutex);
+    if (cached_local_config) {
+        config_cache_statistics.cache_hits++;
+        return *cached_local_config;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    auto config = std::make_unique<NeRtcLocalConfig>();
+    cJSON* json = ReadConfigJson();
+    ParseLocalConfig(json, Board::GetInstance().GetDeviceId(), *config);
+    cJSON_Delete(json);
+    cached_local_config = std::move(config);
+    config_cache_statistics.spiffs_reads++;
+    config_cache_statistics.last_load_time_us = esp_timer_get_time() - start_time;
+    ESP_LOGI(TAG, "Config loaded in %lld us, valid: %d", config_cache_statistics.last_load_time_us, cached_local_config->valid);
+    return *cached_local_config;
+}
+
+NeRtcConfigCacheStatistics NeRtcProtocol::GetConfigCacheStatistics() {
+    std::lock_guard<std::mutex> lock(local_config_mutex);
+    return config_cache_statistics;
+}
+#endif
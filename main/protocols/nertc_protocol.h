@@ -12,6 +12,50 @@
 
 #define NERTC_ENABLE_CONFIG_FILE 1
 
+#if NERTC_ENABLE_CONFIG_FILE
+// /spiffs/config.json 解析后的本地配置，首次使用时读取一次并缓存
+// 固件不会改写该文件，配置在启动后不再变化，GetLocalConfig 返回的引用在整个运行期间有效
+struct NeRtcLocalConfig {
+    bool valid = false;
+    std::string appkey;
+    std::string custom_config;      // custom_config 对象（未格式化 JSON），透传给唤醒词模型
+    std::string sdk_custom_config;  // custom_config 附加 custom_license_key（设备 ID），创建引擎时传给 SDK
+    int asr = -1;                   // custom_config.asr，-1 表示未配置
+    int rtc_call = -1;              // custom_config.rtc_call，-1 表示未配置
+    std::string cname;              // custom_config.cname
+    bool has_uid = false;
+    uint64_t uid = 0;               // custom_config.uid
+    int frame_size = 0;             // audio_config.frame_size，0 表示未配置
+    std::string license;            // license_config.license
+};
+
+struct NeRtcConfigCacheStatistics {
+    uint32_t spiffs_reads = 0;      // 实际读取并解析 config.json 的次数
+    uint32_t cache_hits = 0;
+    int64_t last_load_time_us = 0;  // 最近一次读取+解析的耗时
+};
+#endif
+
+// 唤醒到首帧下行音频的耗时，按 AI 会话是否已预热分开统计
+struct NeRtcOpenStatistics {
+    uint32_t warm_opens = 0;
+    uint32_t cold_opens = 0;        // 含 warm_restarts
+    uint32_t warm_restarts = 0;     // 预热的会话因唤醒词需要 start_topic 而重启的次数
+    uint64_t warm_first_audio_us = 0;
+    uint64_t cold_first_audio_us = 0;
+    uint32_t warm_samples = 0;
+    uint32_t cold_samples = 0;
+};
+
+// 断线恢复：沿用原房间 / token / AI 状态快速重连，失败后才走完整重新入会
+struct NeRtcResumeStatistics {
+    uint32_t resume_count = 0;
+    uint64_t resume_total_us = 0;
+    uint32_t resume_attempts = 0;
+    uint32_t full_rejoin_count = 0;
+    uint64_t full_rejoin_total_us = 0;
+};
+
 enum NERtcP2PCallState {
     kNERtcP2PCallStateIdle = 0,
     kNERtcP2PCallStatePreConnecting,
@@ -29,19 +73,34 @@ public:
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
     bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override;
-    void SendAecReferenceAudio(std::unique_ptr<AudioStreamPacket> packet) override;
-    void SendMcpMessage(const std::string& message) override;
+    void SendAecReferenceAudio(const AudioStreamPacket& packet) override;
+    void SendWakeWordDetected(const std::string& wake_word) override;
+    void SendStartListening(ListeningMode mode) override;
+    void SendStopListening() override;
+    void SendAbortSpeaking(AbortReason reason) override;
+    void SendMcpMessage(std::string message) override;
     void SetAISleep() override;
     void SendTTSText(const std::string& text, int interrupt_mode, bool add_context) override;
     void SendLlmText(const std::string& text) override;
     void SendLlmImage(const char* img_url, const int32_t img_len, const int compress_type, const std::string& text, int img_type) override;
 
+    const NeRtcOpenStatistics& open_statistics() const { return open_statistics_; }
+    const NeRtcResumeStatistics& resume_statistics() const { return resume_statistics_; }
+
 private:
     void RequestChecksum(std::string& checksum);
+    bool StartAi(const std::string& wake_word);
+    void StopAi();
+    void RecordFirstAudio(int64_t latency_us);
+    void BeginResume(const char* reason);
+    void ScheduleResumeAttempt();
+    void TryResume();
+    void FinishResume();
+    void FullRejoin();
     void ParseFunctionCall(cJSON* data, std::string& arguments, std::string& name);
 
-    cJSON* BuildApplicationAsrProtocol(bool local_user ,const char* text);
-    cJSON* BuildApplicationTtsStateProtocol(const std::string& action);
+    void DispatchAsrCaption(bool local_user, const char* text);
+    void DispatchTtsState(const char* event, uint8_t json_parses = 0);
     cJSON* BuildApplicationIotVolumeProtocol(int volume);
     cJSON* BuildApplicationIotStateProtocol(cJSON* commands);
     cJSON* BuildApplicationXiaoZhiIotProtocol(const std::string& name, cJSON* arguments);
@@ -72,6 +131,24 @@ private:
     nertc_sdk_audio_config_t recommended_audio_config_ { 0 };
     esp_timer_handle_t asr_timer_ { nullptr };
     esp_timer_handle_t close_timer_ { nullptr };
+    std::atomic<bool> ai_started_ {false};
+#if CONFIG_NERTC_WARM_STANDBY
+    esp_timer_handle_t standby_timer_ { nullptr };
+#endif
+    std::atomic<int64_t> open_time_us_ {0};  // 等待首帧下行音频时非 0
+    bool open_warm_ = false;
+    NeRtcOpenStatistics open_statistics_;
+    // 断线恢复，保留入会参数，仅在主循环中推进（SDK 回调只置 join_ 并投递到主循环）
+    // 完整重新入会期间 rejoining_ 为真，入会参数和 join_ 归 nertc_rejoin 任务所有，主循环不再发起恢复
+    std::string checksum_;
+    uint64_t join_uid_ { 0 };
+    esp_timer_handle_t resume_timer_ { nullptr };
+    std::atomic<bool> resuming_ {false};
+    std::atomic<bool> rejoining_ {false};
+    int resume_attempt_ = 0;
+    bool resume_ai_ = false;
+    int64_t disconnect_time_us_ = 0;
+    NeRtcResumeStatistics resume_statistics_;
 private:
     bool SendText(const std::string& text) override;
 
@@ -82,10 +159,18 @@ public:
 
     static std::string config_file_path_;
     static cJSON* ReadConfigJson();
+
+    // 返回缓存的配置副本，首次调用时加载
+    // 返回的引用在进程生命周期内有效
+    static const NeRtcLocalConfig& GetLocalConfig();
+    static NeRtcConfigCacheStatistics GetConfigCacheStatistics();
 #endif
 
 private:
     std::string local_config_appkey_;
+#if NERTC_ENABLE_CONFIG_FILE
+    uint32_t last_config_cache_hits_ = 0;
+#endif
     bool asr_enabled_ = true;
     bool rtc_mode_ = false; // donot start ai
     NERtcP2PCallState rtc_p2p_state_ = kNERtcP2PCallStateIdle;
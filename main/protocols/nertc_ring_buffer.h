@@ -0,0 +1,137 @@
+#ifndef _NERTC_RING_BUFFER_H_
+#define _NERTC_RING_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// 固定容量字节环形缓冲，读写均为至多两段 memcpy，不做搬移；非线程安全，由调用方加锁
+class ByteRingBuffer {
+public:
+    explicit ByteRingBuffer(size_t capacity) : buffer_(capacity) {}
+
+    size_t capacity() const { return buffer_.size(); }
+    size_t size() const { return size_; }
+    size_t free_space() const { return buffer_.size() - size_; }
+    bool empty() const { return size_ == 0; }
+
+    // 返回实际写入的字节数，放不下的部分不写入
+    size_t Write(const char* data, size_t length) {
+        size_t to_write = std::min(length, free_space());
+        size_t tail = (head_ + size_) % buffer_.size();
+        size_t first = std::min(to_write, buffer_.size() - tail);
+        memcpy(buffer_.data() + tail, data, first);
+        memcpy(buffer_.data(), data + first, to_write - first);
+        size_ += to_write;
+        return to_write;
+    }
+
+    size_t Read(char* data, size_t length) {
+        size_t to_read = std::min(length, size_);
+        size_t first = std::min(to_read, buffer_.size() - head_);
+        memcpy(data, buffer_.data() + head_, first);
+        memcpy(data + first, buffer_.data(), to_read - first);
+        head_ = (head_ + to_read) % buffer_.size();
+        size_ -= to_read;
+        if (size_ == 0) {
+            head_ = 0;
+        }
+        return to_read;
+    }
+
+    // 整段写入：空间不足时按倍数扩容（不超过 max_capacity），仍放不下则什么都不写并返回 false
+    bool WriteAll(const char* data, size_t length, size_t max_capacity) {
+        if (length > free_space()) {
+            size_t needed = size_ + length;
+            if (needed > max_capacity) {
+                return false;
+            }
+            size_t capacity = std::max<size_t>(buffer_.size(), 1);
+            while (capacity < needed) {
+                capacity *= 2;
+            }
+            Grow(std::min(capacity, max_capacity));
+        }
+        Write(data, length);
+        return true;
+    }
+
+    void Clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    uint32_t grow_count() const { return grow_count_; }
+
+private:
+    std::vector<char> buffer_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    uint32_t grow_count_ = 0;
+
+    // 扩容时把已有数据整理到新缓冲的开头
+    void Grow(size_t capacity) {
+        std::vector<char> buffer(capacity);
+        size_t size = size_;
+        Read(buffer.data(), size);
+        buffer_.swap(buffer);
+        head_ = 0;
+        size_ = size;
+        grow_count_++;
+    }
+};
+
+// 固定槽位数的数据报环形队列，槽位字符串复用容量，稳态下不再分配内存；满时丢弃最旧的数据报
+class DatagramRingBuffer {
+public:
+    explicit DatagramRingBuffer(size_t slots) : slots_(slots) {}
+
+    size_t capacity() const { return slots_.size(); }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    uint32_t dropped() const { return dropped_; }
+    uint32_t truncated() const { return truncated_; }
+
+    void Push(const char* data, size_t length) {
+        if (count_ == slots_.size()) {
+            head_ = (head_ + 1) % slots_.size();
+            count_--;
+            dropped_++;
+        }
+        slots_[(head_ + count_) % slots_.size()].assign(data, length);
+        count_++;
+    }
+
+    // 读出最旧的一个数据报，buffer 不足时截断（与 recv 语义一致）并计数；队列为空返回 -1
+    int Pop(char* buffer, size_t buffer_size) {
+        if (count_ == 0) {
+            return -1;
+        }
+        const std::string& data = slots_[head_];
+        size_t to_copy = std::min(buffer_size, data.size());
+        if (to_copy < data.size()) {
+            truncated_++;
+        }
+        memcpy(buffer, data.data(), to_copy);
+        head_ = (head_ + 1) % slots_.size();
+        count_--;
+        return static_cast<int>(to_copy);
+    }
+
+    void Clear() {
+        head_ = 0;
+        count_ = 0;
+    }
+
+private:
+    std::vector<std::string> slots_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    uint32_t dropped_ = 0;
+    uint32_t truncated_ = 0;
+};
+
+#endif
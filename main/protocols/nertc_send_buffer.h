@@ -0,0 +1,18 @@
+#ifndef _NERTC_SEND_BUFFER_H_
+#define _NERTC_SEND_BUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 复制到连接的发送缓冲，仅在容量不足时分配；Tcp/Udp::Send 只接受 const std::string&，拷贝这一次省不掉
+inline void FillSendBuffer(std::string& send_buffer, const char* data, size_t length,
+        std::atomic<uint32_t>& allocations) {
+    if (send_buffer.capacity() < length) {
+        allocations++;
+    }
+    send_buffer.assign(data, length);
+}
+
+#endif // _NERTC_SEND_BUFFER_H_
@@ -1,13 +1,133 @@
 #include "protocol.h"
+#include "cjson_arena.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <cstring>
 
 #define TAG "Protocol"
 
+static const struct {
+    const char* name;
+    IncomingMessageType type;
+} kIncomingMessageTypes[] = {
+    {"tts", kIncomingMessageTts},
+    {"stt", kIncomingMessageStt},
+    {"llm", kIncomingMessageLlm},
+    {"mcp", kIncomingMessageMcp},
+    {"system", kIncomingMessageSystem},
+    {"alert", kIncomingMessageAlert},
+    {"custom", kIncomingMessageCustom},
+};
+
+static const char* GetStringItem(const cJSON* root, const char* name) {
+    auto item = cJSON_GetObjectItem(root, name);
+    return cJSON_IsString(item) ? item->valuestring : nullptr;
+}
+
+static const char* GetStringItem(const JsonReader& reader, const char* name) {
+    return reader.GetString(name);
+}
+
 void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
     on_incoming_json_ = callback;
 }
 
+void Protocol::OnIncomingMessage(std::function<void(const IncomingMessage& message)> callback) {
+    on_incoming_message_ = callback;
+}
+
+void Protocol::DispatchIncomingMessage(IncomingMessage& message) {
+    if (message.received_time_us == 0) {
+        message.received_time_us = esp_timer_get_time();
+    }
+    if (on_incoming_message_ != nullptr) {
+        on_incoming_message_(message);
+    }
+}
+
+// 将 xiaozhi JSON 消息的公共字段转换为类型化消息，mcp / custom 的 payload 由调用方填写
+template <typename Root>
+static bool ParseMessageFields(const Root& root, IncomingMessage& message) {
+    auto type = GetStringItem(root, "type");
+    if (type == nullptr) {
+        return false;
+    }
+    message.type_name = type;
+    message.type = kIncomingMessageUnknown;
+    for (const auto& entry : kIncomingMessageTypes) {
+        if (strcmp(type, entry.name) == 0) {
+            message.type = entry.type;
+            break;
+        }
+    }
+
+    switch (message.type) {
+    case kIncomingMessageTts:
+        message.state = GetStringItem(root, "state");
+        message.text = GetStringItem(root, "text");
+        break;
+    case kIncomingMessageStt:
+        message.text = GetStringItem(root, "text");
+        break;
+    case kIncomingMessageLlm:
+        message.emotion = GetStringItem(root, "emotion");
+        break;
+    case kIncomingMessageSystem:
+        message.command = GetStringItem(root, "command");
+        break;
+    case kIncomingMessageAlert:
+        message.status = GetStringItem(root, "status");
+        message.message = GetStringItem(root, "message");
+        message.emotion = GetStringItem(root, "emotion");
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+// root 需要在消息使用期间保持有效
+bool Protocol::ParseIncomingMessage(const cJSON* root, IncomingMessage& message) {
+    if (!ParseMessageFields(root, message)) {
+        return false;
+    }
+    if (message.type == kIncomingMessageMcp || message.type == kIncomingMessageCustom) {
+        auto payload = cJSON_GetObjectItem(root, "payload");
+        message.payload = cJSON_IsObject(payload) ? payload : nullptr;
+    }
+    return true;
+}
+
+// 字符串直接指向 reader 的缓冲区，payload 不在此处解析
+bool Protocol::ParseIncomingMessage(const JsonReader& reader, IncomingMessage& message) {
+    return ParseMessageFields(reader, message);
+}
+
+// 原地解析的消息直接分发，只有 mcp / custom 的 payload 子对象交给 cJSON
+void Protocol::DispatchIncomingMessage(const JsonReader& reader) {
+    IncomingMessage message;
+    message.received_time_us = esp_timer_get_time();
+    if (!ParseIncomingMessage(reader, message)) {
+        ESP_LOGW(TAG, "Invalid message: missing type");
+        return;
+    }
+
+    // payload 树与分发过程中的临时 cJSON 对象都在竞技场中分配，分发结束后一次回收
+    CJsonArenaScope arena;
+    cJSON* payload = nullptr;
+    const char* raw = nullptr;
+    size_t raw_length = 0;
+    if ((message.type == kIncomingMessageMcp || message.type == kIncomingMessageCustom) &&
+        reader.GetRaw("payload", kJsonObject, raw, raw_length)) {
+        payload = cJSON_ParseWithLength(raw, raw_length);
+        message.payload = payload;
+        message.json_parses = 1;
+    }
+    DispatchIncomingMessage(message);
+    cJSON_Delete(payload);
+}
+
 void Protocol::OnIncomingAudio(std::function<void(std::unique_ptr<AudioStreamPacket> packet)> callback) {
     on_incoming_audio_ = callback;
 }
@@ -73,9 +193,12 @@ void Protocol::SendStopListening() {
     SendText(message);
 }
 
-void Protocol::SendMcpMessage(const std::string& payload) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"mcp\",\"payload\":" + payload + "}";
-    SendText(message);
+void Protocol::SendMcpMessage(std::string payload) {
+    // 会话包头原地插到 payload 前面，调用方预留了容量时只移动一次、不再分配新缓冲
+    std::string header = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"mcp\",\"payload\":";
+    payload.insert(0, header);
+    payload += "}";
+    SendText(payload);
 }
 
 bool Protocol::IsTimeout() const {
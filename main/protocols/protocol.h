@@ -2,8 +2,10 @@
 #define PROTOCOL_H
 
 #include <cJSON.h>
+#include "json_reader.h"
 #include <string>
 #include <functional>
+#include <memory>
 #include <chrono>
 #include <vector>
 
@@ -45,6 +47,43 @@ enum ListeningMode {
     kListeningModeRealtime // 需要 AEC 支持
 };
 
+enum IncomingMessageType {
+    kIncomingMessageUnknown = 0,
+    kIncomingMessageTts,
+    kIncomingMessageStt,
+    kIncomingMessageLlm,
+    kIncomingMessageMcp,
+    kIncomingMessageSystem,
+    kIncomingMessageAlert,
+    kIncomingMessageCustom,
+    kIncomingMessageTypeCount
+};
+
+// 上行链路质量，丢包率为上次查询以来的区间值
+struct LinkStatistics {
+    float loss_rate = 0;
+    uint32_t packets = 0;               // 区间内应到达的包数，样本太少时丢包率不可信
+    float jitter_ms = 0;
+    int rtt_ms = -1;                    // 上次查询以来的新 RTT 样本，没有新样本为 -1
+    int max_uplink_frame_duration = 0;  // 服务端声明可解码的最长上行帧长，0 表示只支持 hello 中的固定帧长
+};
+
+// 入站控制消息，每条消息只解析一次，由 Application 按 type 查表分发
+// 字符串和 payload 只在分发回调期间有效
+struct IncomingMessage {
+    IncomingMessageType type = kIncomingMessageUnknown;
+    const char* type_name = "";
+    const char* state = nullptr;    // tts: start / stop / sentence_start
+    const char* text = nullptr;     // tts sentence_start / stt
+    const char* emotion = nullptr;  // llm / alert
+    const char* command = nullptr;  // system
+    const char* status = nullptr;   // alert
+    const char* message = nullptr;  // alert
+    const cJSON* payload = nullptr; // mcp / custom
+    uint8_t json_parses = 0;        // 生成该消息所用的 cJSON_Parse 次数
+    int64_t received_time_us = 0;
+};
+
 class Protocol {
 public:
     virtual ~Protocol() = default;
@@ -66,6 +105,7 @@ public:
 
     void OnIncomingAudio(std::function<void(std::unique_ptr<AudioStreamPacket> packet)> callback);
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
+    void OnIncomingMessage(std::function<void(const IncomingMessage& message)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
     void OnNetworkError(std::function<void(const std::string& message)> callback);
@@ -77,19 +117,26 @@ public:
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) = 0;
-    virtual void SendAecReferenceAudio(std::unique_ptr<AudioStreamPacket> packet) {}
+    // 参考帧在调用内同步消费，调用方保留包的所有权（随后仍可送入解码队列），避免额外拷贝
+    virtual void SendAecReferenceAudio(const AudioStreamPacket& packet) {}
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
     virtual void SendAbortSpeaking(AbortReason reason);
-    virtual void SendMcpMessage(const std::string& message);
+    virtual void SendMcpMessage(std::string message);
     virtual void SetAISleep() {}
     virtual void SendTTSText(const std::string& text, int interrupt_mode, bool add_context) {}
     virtual void SendLlmText(const std::string& text) {}
     virtual void SendLlmImage(const char* img_url, const int32_t img_len, const int compress_type, const std::string& text, int img_type) {}
+    // 不提供链路统计的协议返回 false
+    virtual bool GetLinkStatistics(LinkStatistics& statistics) { return false; }
+
+    static bool ParseIncomingMessage(const cJSON* root, IncomingMessage& message);
+    static bool ParseIncomingMessage(const JsonReader& reader, IncomingMessage& message);
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
+    std::function<void(const IncomingMessage& message)> on_incoming_message_;
     std::function<void(std::unique_ptr<AudioStreamPacket> packet)> on_incoming_audio_;
     std::function<void()> on_audio_channel_opened_;
     std::function<void()> on_audio_channel_closed_;
@@ -107,6 +154,8 @@ protected:
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
 
     virtual bool SendText(const std::string& text) = 0;
+    void DispatchIncomingMessage(IncomingMessage& message);
+    void DispatchIncomingMessage(const JsonReader& reader);
     virtual void SetError(const std::string& message);
     virtual bool IsTimeout() const;
 };
@@ -0,0 +1,42 @@
+#ifndef UDP_AUDIO_PACKET_H
+#define UDP_AUDIO_PACKET_H
+
+#include <arpa/inet.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * MQTT UDP 音频包：16 字节包头同时作为 AES-CTR 的 nonce，后接密文
+ * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
+ * |payload payload_len|
+ */
+#define UDP_AUDIO_PACKET_HEADER_SIZE 16
+
+// 包头与密文直接写入 buffer，buffer 的容量跨包复用，稳态下不分配内存
+// encrypt(length, nonce_counter, input, output) 返回 0 表示成功；nonce_counter 是包头的栈上副本，可被改写
+template <typename Encrypt>
+inline bool PackUdpAudioPacket(std::string& buffer, const std::string& nonce, const std::vector<uint8_t>& payload,
+    uint32_t timestamp, uint32_t sequence, Encrypt&& encrypt) {
+    if (nonce.size() != UDP_AUDIO_PACKET_HEADER_SIZE) {
+        return false;
+    }
+    buffer.resize(UDP_AUDIO_PACKET_HEADER_SIZE + payload.size());
+    uint8_t* header = (uint8_t*)buffer.data();
+    memcpy(header, nonce.data(), UDP_AUDIO_PACKET_HEADER_SIZE);
+    uint16_t payload_size = htons(payload.size());
+    uint32_t timestamp_be = htonl(timestamp);
+    uint32_t sequence_be = htonl(sequence);
+    memcpy(&header[2], &payload_size, sizeof(payload_size));
+    memcpy(&header[8], &timestamp_be, sizeof(timestamp_be));
+    memcpy(&header[12], &sequence_be, sizeof(sequence_be));
+
+    uint8_t nonce_counter[UDP_AUDIO_PACKET_HEADER_SIZE];
+    memcpy(nonce_counter, header, sizeof(nonce_counter));
+    return encrypt(payload.size(), nonce_counter, payload.data(), header + UDP_AUDIO_PACKET_HEADER_SIZE) == 0;
+}
+
+#endif // UDP_AUDIO_PACKET_H
@@ -0,0 +1,186 @@
+#ifndef UDP_REORDER_WINDOW_H
+#define UDP_REORDER_WINDOW_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <utility>
+
+// UDP 音频包重排窗口：按序号缓存最多 kSize 个包，按序输出；窗口满时跳过缺失的序号并计为丢包
+// 缺口之后的包最多等待 max_hold_ms（按到达时间计），超时由 Expire 跳过缺口输出，避免流末尾的包一直滞留
+// 非线程安全，调用方加锁
+template <typename T, size_t kSize>
+class UdpReorderWindow {
+public:
+    static_assert(kSize > 0, "Reorder window size must be positive");
+
+    struct Statistics {
+        uint32_t received = 0;
+        uint32_t lost = 0;       // 窗口推进时仍未到达的序号
+        uint32_t reordered = 0;  // 晚于更大序号到达，但仍在窗口内被补上的包
+        uint32_t late = 0;       // 已经越过窗口或重复的包，直接丢弃
+        uint32_t expired = 0;    // 等待缺口超时而跳过缺口的次数
+    };
+
+    explicit UdpReorderWindow(int64_t max_hold_ms) : max_hold_ms_(max_hold_ms) {}
+
+    template <typename Output>
+    void Push(uint32_t sequence, T&& item, int64_t arrival_ms, Output&& output) {
+        statistics_.received++;
+        if (!started_) {
+            started_ = true;
+            next_sequence_ = sequence;
+            highest_sequence_ = sequence;
+        }
+
+        int32_t offset = (int32_t)(sequence - next_sequence_);
+        if (offset < 0) {
+            statistics_.late++;
+            return;
+        }
+        if ((size_t)offset >= kSize) {
+            if ((size_t)offset >= kSize * 2) {
+                // 序号大跳变（服务端重启等），输出已缓存的包后直接对齐到新序号
+                Flush(output);
+                offset = (int32_t)(sequence - next_sequence_);
+                statistics_.lost += (uint32_t)offset - (kSize - 1);
+                next_sequence_ = sequence - (kSize - 1);
+            }
+            while ((size_t)(int32_t)(sequence - next_sequence_) >= kSize) {
+                Advance(output);
+            }
+        }
+
+        if ((int32_t)(sequence - highest_sequence_) < 0) {
+            statistics_.reordered++;
+        } else {
+            highest_sequence_ = sequence;
+        }
+
+        auto& slot = slots_[sequence % kSize];
+        if (slot.has_value()) {
+            statistics_.late++;
+            return;
+        }
+        slot.emplace(Entry{std::move(item), arrival_ms});
+        buffered_++;
+
+        Drain(output);
+    }
+
+    // 缺口之后最早到达的包已等待 max_hold_ms 时跳过缺口并输出
+    // 返回距下一次需要检查的毫秒数，没有等待中的包返回 -1
+    template <typename Output>
+    int64_t Expire(int64_t now_ms, Output&& output) {
+        while (buffered_ > 0) {
+            int64_t oldest_ms = now_ms;
+            for (auto& slot : slots_) {
+                if (slot.has_value() && slot->arrival_ms < oldest_ms) {
+                    oldest_ms = slot->arrival_ms;
+                }
+            }
+            int64_t waited_ms = now_ms - oldest_ms;
+            if (waited_ms < max_hold_ms_) {
+                return max_hold_ms_ - waited_ms;
+            }
+            statistics_.expired++;
+            while (!slots_[next_sequence_ % kSize].has_value()) {
+                Advance(output);
+            }
+            Drain(output);
+        }
+        return -1;
+    }
+
+    // 按序输出窗口内剩余的包，缺失的序号计为丢包
+    template <typename Output>
+    void Flush(Output&& output) {
+        if (!started_) {
+            return;
+        }
+        while ((int32_t)(highest_sequence_ - next_sequence_) >= 0) {
+            Advance(output);
+        }
+    }
+
+    // 丢弃缓存的包并重新对齐序号，统计保留
+    void Discard() {
+        for (auto& slot : slots_) {
+            slot.reset();
+        }
+        buffered_ = 0;
+        started_ = false;
+    }
+
+    void Reset() {
+        Discard();
+        statistics_ = Statistics();
+    }
+
+    size_t buffered() const { return buffered_; }
+    const Statistics& statistics() const { return statistics_; }
+
+private:
+    struct Entry {
+        T item;
+        int64_t arrival_ms;
+    };
+
+    std::array<std::optional<Entry>, kSize> slots_;
+    int64_t max_hold_ms_;
+    size_t buffered_ = 0;
+    bool started_ = false;
+    uint32_t next_sequence_ = 0;
+    uint32_t highest_sequence_ = 0;
+    Statistics statistics_;
+
+    template <typename Output>
+    void Drain(Output& output) {
+        while (slots_[next_sequence_ % kSize].has_value()) {
+            Advance(output);
+        }
+    }
+
+    template <typename Output>
+    void Advance(Output& output) {
+        auto& slot = slots_[next_sequence_ % kSize];
+        if (slot.has_value()) {
+            output(std::move(slot->item));
+            slot.reset();
+            buffered_--;
+        } else {
+            statistics_.lost++;
+        }
+        next_sequence_++;
+    }
+};
+
+// RFC 3550 到达间隔抖动估计，时间戳与到达时间均为毫秒
+class UdpJitterEstimator {
+public:
+    void Update(uint32_t timestamp_ms, int64_t arrival_ms) {
+        int64_t transit = arrival_ms - (int64_t)timestamp_ms;
+        if (has_transit_) {
+            int64_t d = std::llabs(transit - last_transit_);
+            jitter_ += ((double)d - jitter_) / 16.0;
+        }
+        last_transit_ = transit;
+        has_transit_ = true;
+    }
+
+    void Reset() {
+        has_transit_ = false;
+        jitter_ = 0;
+    }
+
+    double jitter_ms() const { return jitter_; }
+
+private:
+    bool has_transit_ = false;
+    int64_t last_transit_ = 0;
+    double jitter_ = 0;
+};
+
+#endif // UDP_REORDER_WINDOW_H
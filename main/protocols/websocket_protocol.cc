@@ -1,4 +1,5 @@
 #include "websocket_protocol.h"
+#include "binary_protocol_frame.h"
 #include "board.h"
 #include "system_info.h"
 #include "application.h"
@@ -30,31 +31,11 @@ bool WebsocketProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
         return false;
     }
 
-    if (version_ == 2) {
-        std::string serialized;
-        serialized.resize(sizeof(BinaryProtocol2) + packet->payload.size());
-        auto bp2 = (BinaryProtocol2*)serialized.data();
-        bp2->version = htons(version_);
-        bp2->type = 0;
-        bp2->reserved = 0;
-        bp2->timestamp = htonl(packet->timestamp);
-        bp2->payload_size = htonl(packet->payload.size());
-        memcpy(bp2->payload, packet->payload.data(), packet->payload.size());
-
-        return websocket_->Send(serialized.data(), serialized.size(), true);
-    } else if (version_ == 3) {
-        std::string serialized;
-        serialized.resize(sizeof(BinaryProtocol3) + packet->payload.size());
-        auto bp3 = (BinaryProtocol3*)serialized.data();
-        bp3->type = 0;
-        bp3->reserved = 0;
-        bp3->payload_size = htons(packet->payload.size());
-        memcpy(bp3->payload, packet->payload.data(), packet->payload.size());
-
-        return websocket_->Send(serialized.data(), serialized.size(), true);
-    } else {
+    if (!FrameBinaryAudio(audio_send_buffer_, version_, *packet)) {
+        // 版本 1 没有包头，payload 直接发送
         return websocket_->Send(packet->payload.data(), packet->payload.size(), true);
     }
+    return websocket_->Send(audio_send_buffer_.data(), audio_send_buffer_.size(), true);
 }
 
 bool WebsocketProtocol::SendText(const std::string& text) {
@@ -118,6 +99,7 @@ bool WebsocketProtocol::OpenAudioChannel(const std::string&) {
                     bp2->timestamp = ntohl(bp2->timestamp);
                     bp2->payload_size = ntohl(bp2->payload_size);
                     auto payload = (uint8_t*)bp2->payload;
+                    Application::GetInstance().GetAudioService().CountDownlinkBytesCopied(bp2->payload_size);
                     on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
                         .sample_rate = server_sample_rate_,
                         .frame_duration = server_frame_duration_,
@@ -129,6 +111,7 @@ bool WebsocketProtocol::OpenAudioChannel(const std::string&) {
                     bp3->type = bp3->type;
                     bp3->payload_size = ntohs(bp3->payload_size);
                     auto payload = (uint8_t*)bp3->payload;
+                    Application::GetInstance().GetAudioService().CountDownlinkBytesCopied(bp3->payload_size);
                     on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
                         .sample_rate = server_sample_rate_,
                         .frame_duration = server_frame_duration_,
@@ -136,6 +119,7 @@ bool WebsocketProtocol::OpenAudioChannel(const std::string&) {
                         .payload = std::vector<uint8_t>(payload, payload + bp3->payload_size)
                     }));
                 } else {
+                    Application::GetInstance().GetAudioService().CountDownlinkBytesCopied(len);
                     on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
                         .sample_rate = server_sample_rate_,
                         .frame_duration = server_frame_duration_,
@@ -145,21 +129,21 @@ bool WebsocketProtocol::OpenAudioChannel(const std::string&) {
                 }
             }
         } else {
-            // Parse JSON data
-            auto root = cJSON_Parse(data);
-            auto type = cJSON_GetObjectItem(root, "type");
-            if (cJSON_IsString(type)) {
-                if (strcmp(type->valuestring, "hello") == 0) {
+            // 拷贝到复用缓冲后原地解析，只有 hello 仍走 cJSON
+            incoming_text_.assign(data, len);
+            JsonReader reader(incoming_text_.data(), incoming_text_.size());
+            auto type = reader.Parse() ? reader.GetString("type") : nullptr;
+            if (type == nullptr) {
+                ESP_LOGE(TAG, "Missing message type, data: %.*s", (int)len, data);
+            } else if (strcmp(type, "hello") == 0) {
+                auto root = cJSON_ParseWithLength(data, len);
+                if (root != nullptr) {
                     ParseServerHello(root);
-                } else {
-                    if (on_incoming_json_ != nullptr) {
-                        on_incoming_json_(root);
-                    }
+                    cJSON_Delete(root);
                 }
             } else {
-                ESP_LOGE(TAG, "Missing message type, data: %s", data);
+                DispatchIncomingMessage(reader);
             }
-            cJSON_Delete(root);
         }
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
@@ -25,6 +25,10 @@ private:
     EventGroupHandle_t event_group_handle_;
     std::unique_ptr<WebSocket> websocket_;
     int version_ = 1;
+    // BP2/BP3 音频帧发送缓冲，容量随最大帧增长后复用
+    std::vector<uint8_t> audio_send_buffer_;
+    // 入站文本消息的原地解析缓冲
+    std::string incoming_text_;
 
     void ParseServerHello(const cJSON* root);
     bool SendText(const std::string& text) override;
@@ -0,0 +1,315 @@
+#ifndef SCHEDULE_QUEUE_H
+#define SCHEDULE_QUEUE_H
+
+#include <esp_timer.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 主循环任务：小闭包直接放在内联缓冲中，超出 kInlineSize 的闭包才在堆上分配
+class ScheduledTask {
+public:
+    static constexpr size_t kInlineSize = 32;
+
+    template <typename F>
+    static constexpr bool fits_inline = sizeof(F) <= kInlineSize &&
+        alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+    ScheduledTask() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, ScheduledTask>>>
+    ScheduledTask(F&& callback) {
+        using Callable = std::decay_t<F>;
+        if constexpr (fits_inline<Callable>) {
+            new (storage_) Callable(std::forward<F>(callback));
+            invoke_ = [](void* storage) { (*static_cast<Callable*>(storage))(); };
+            manage_ = [](void* dst, void* src) {
+                auto callable = static_cast<Callable*>(src);
+                if (dst != nullptr) {
+                    new (dst) Callable(std::move(*callable));
+                }
+                callable->~Callable();
+            };
+        } else {
+            *reinterpret_cast<Callable**>(storage_) = new Callable(std::forward<F>(callback));
+            invoke_ = [](void* storage) { (**static_cast<Callable**>(storage))(); };
+            manage_ = [](void* dst, void* src) {
+                auto callable = static_cast<Callable**>(src);
+                if (dst != nullptr) {
+                    *static_cast<Callable**>(dst) = *callable;
+                } else {
+                    delete *callable;
+                }
+            };
+            heap_allocated_ = true;
+        }
+    }
+
+    ScheduledTask(ScheduledTask&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    ScheduledTask& operator=(ScheduledTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    ScheduledTask(const ScheduledTask&) = delete;
+    ScheduledTask& operator=(const ScheduledTask&) = delete;
+
+    ~ScheduledTask() {
+        Reset();
+    }
+
+    void operator()() {
+        invoke_(storage_);
+    }
+
+    explicit operator bool() const { return invoke_ != nullptr; }
+    bool heap_allocated() const { return heap_allocated_; }
+
+    void Reset() {
+        if (manage_ != nullptr) {
+            manage_(nullptr, storage_);
+        }
+        invoke_ = nullptr;
+        manage_ = nullptr;
+        heap_allocated_ = false;
+    }
+
+    int64_t enqueue_time_us = 0;
+
+private:
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    void (*invoke_)(void* storage) = nullptr;
+    // dst 为空时销毁 src，否则把 src 移动到 dst 并销毁 src
+    void (*manage_)(void* dst, void* src) = nullptr;
+    bool heap_allocated_ = false;
+
+    void MoveFrom(ScheduledTask& other) {
+        if (other.manage_ != nullptr) {
+            other.manage_(storage_, other.storage_);
+        }
+        invoke_ = other.invoke_;
+        manage_ = other.manage_;
+        heap_allocated_ = other.heap_allocated_;
+        enqueue_time_us = other.enqueue_time_us;
+        other.invoke_ = nullptr;
+        other.manage_ = nullptr;
+        other.heap_allocated_ = false;
+    }
+};
+
+// 有界多生产者单消费者无锁队列（按序号标记槽位），入队不加锁、不分配内存，可在中断和定时器回调中使用
+// 只有主循环一个消费者；队列满时 TryPush 返回 false，由调用方决定如何处理
+template <typename T, size_t kCapacity>
+class MpscRingQueue {
+public:
+    static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0, "Capacity must be a power of two");
+
+    MpscRingQueue() {
+        for (size_t i = 0; i < kCapacity; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 只在成功时移走 item
+    bool TryPush(T& item) {
+        size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & (kCapacity - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+            if (diff == 0) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(item);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 仅消费者调用
+    bool TryPop(T& item) {
+        size_t position = dequeue_position_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[position & (kCapacity - 1)];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if ((intptr_t)sequence - (intptr_t)(position + 1) < 0) {
+            return false;
+        }
+        item = std::move(cell.data);
+        cell.sequence.store(position + kCapacity, std::memory_order_release);
+        dequeue_position_.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 近似深度，包含已占位但尚未写完的槽位
+    size_t size() const {
+        size_t enqueue = enqueue_position_.load(std::memory_order_relaxed);
+        size_t dequeue = dequeue_position_.load(std::memory_order_relaxed);
+        return enqueue - dequeue;
+    }
+
+    static constexpr size_t capacity() { return kCapacity; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    Cell cells_[kCapacity];
+    std::atomic<size_t> enqueue_position_ {0};
+    std::atomic<size_t> dequeue_position_ {0};
+};
+
+enum SchedulePriority {
+    kSchedulePriorityNormal,
+    // 打断播放等不依赖先后顺序的任务，会越过已排队的普通任务先执行；状态切换不要放在这里
+    kSchedulePriorityHigh,
+    kSchedulePriorityCount
+};
+
+// 仅由消费者更新
+struct ScheduleLaneStatistics {
+    uint32_t count = 0;
+    uint32_t max_depth = 0;
+    uint64_t total_wait_us = 0;
+    uint32_t max_wait_us = 0;
+};
+
+// 主循环的任务通道：每个优先级一条无锁环形队列，同一通道内严格按投递顺序执行
+// 任务中投递时通道满则退回到加锁的溢出队列，溢出队列非空期间新任务也进入溢出队列以保持顺序；
+// 中断和定时器中投递只用环形队列，不加锁、不分配，通道满（或溢出队列非空）时失败
+template <size_t kLaneCapacity = 32>
+class ScheduleLanes {
+public:
+    void Push(ScheduledTask&& task, SchedulePriority priority) {
+        auto& lane = lanes_[priority];
+        task.enqueue_time_us = esp_timer_get_time();
+        if (task.heap_allocated()) {
+            heap_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (lane.overflow_pending.load(std::memory_order_acquire) || !lane.queue.TryPush(task)) {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            lane.overflow.push_back(std::move(task));
+            lane.overflow_pending.store(true, std::memory_order_release);
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 失败时 task 保持不变
+    bool PushFromISR(ScheduledTask& task, SchedulePriority priority) {
+        auto& lane = lanes_[priority];
+        if (task.heap_allocated() || lane.overflow_pending.load(std::memory_order_acquire)) {
+            isr_drops_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        task.enqueue_time_us = esp_timer_get_time();
+        if (!lane.queue.TryPush(task)) {
+            isr_drops_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // 仅消费者调用。每个普通任务之前先清空高优先级通道；普通任务只执行进入时已排队的数量，
+    // 执行期间新投递的留到下一轮。返回 true 表示还有普通任务待执行
+    bool RunPending() {
+        auto& normal_lane = lanes_[kSchedulePriorityNormal];
+        size_t budget = normal_lane.queue.size();
+        if (normal_lane.overflow_pending.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            budget += normal_lane.overflow.size();
+        }
+
+        ScheduledTask task;
+        while (true) {
+            while (Pop(kSchedulePriorityHigh, task)) {
+                Run(kSchedulePriorityHigh, task);
+            }
+            if (budget == 0 || !Pop(kSchedulePriorityNormal, task)) {
+                break;
+            }
+            budget--;
+            Run(kSchedulePriorityNormal, task);
+        }
+        return normal_lane.queue.size() > 0 || normal_lane.overflow_pending.load(std::memory_order_acquire);
+    }
+
+    const ScheduleLaneStatistics& statistics(SchedulePriority priority) const { return lanes_[priority].statistics; }
+    uint32_t heap_fallbacks() const { return heap_fallbacks_.load(std::memory_order_relaxed); }
+    uint32_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+    uint32_t isr_drops() const { return isr_drops_.load(std::memory_order_relaxed); }
+
+private:
+    struct Lane {
+        MpscRingQueue<ScheduledTask, kLaneCapacity> queue;
+        std::deque<ScheduledTask> overflow;
+        std::atomic<bool> overflow_pending {false};
+        ScheduleLaneStatistics statistics;
+    };
+
+    Lane lanes_[kSchedulePriorityCount];
+    std::mutex overflow_mutex_;
+    std::atomic<uint32_t> heap_fallbacks_ {0};
+    std::atomic<uint32_t> overflows_ {0};
+    std::atomic<uint32_t> isr_drops_ {0};
+
+    bool Pop(SchedulePriority priority, ScheduledTask& task) {
+        auto& lane = lanes_[priority];
+        size_t depth = lane.queue.size();
+        if (lane.queue.TryPop(task)) {
+            if (depth > lane.statistics.max_depth) {
+                lane.statistics.max_depth = depth;
+            }
+            return true;
+        }
+        if (!lane.overflow_pending.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        if (lane.overflow.empty()) {
+            lane.overflow_pending.store(false, std::memory_order_release);
+            return false;
+        }
+        depth = lane.overflow.size() + lane.queue.capacity();
+        if (depth > lane.statistics.max_depth) {
+            lane.statistics.max_depth = depth;
+        }
+        task = std::move(lane.overflow.front());
+        lane.overflow.pop_front();
+        if (lane.overflow.empty()) {
+            lane.overflow_pending.store(false, std::memory_order_release);
+        }
+        return true;
+    }
+
+    void Run(SchedulePriority priority, ScheduledTask& task) {
+        auto& stats = lanes_[priority].statistics;
+        uint32_t wait_us = (uint32_t)(esp_timer_get_time() - task.enqueue_time_us);
+        stats.count++;
+        stats.total_wait_us += wait_us;
+        if (wait_us > stats.max_wait_us) {
+            stats.max_wait_us = wait_us;
+        }
+        task();
+        task.Reset();
+    }
+};
+
+#endif // SCHEDULE_QUEUE_H
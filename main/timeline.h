@@ -0,0 +1,101 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <cJSON.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 记录一次多步骤流程（唤醒、启动等）中各步骤相对起点的起止时间
+// Begin/End 可在不同任务中并发调用，每个步骤只由开始它的任务结束；Print 在所有步骤汇合之后调用
+template <size_t kMaxSteps>
+class Timeline {
+public:
+    void Start() {
+        start_time_us_ = esp_timer_get_time();
+        count_.store(0, std::memory_order_relaxed);
+    }
+
+    // 超过 kMaxSteps 的步骤不记录，返回 -1
+    int Begin(const char* name) {
+        size_t index = count_.fetch_add(1, std::memory_order_relaxed);
+        if (index >= kMaxSteps) {
+            return -1;
+        }
+        steps_[index].name = name;
+        steps_[index].begin_us = esp_timer_get_time() - start_time_us_;
+        steps_[index].end_us = -1;
+        return (int)index;
+    }
+
+    void End(int index) {
+        if (index >= 0 && (size_t)index < kMaxSteps) {
+            steps_[index].end_us = esp_timer_get_time() - start_time_us_;
+        }
+    }
+
+    // 瞬时事件
+    void Mark(const char* name) {
+        End(Begin(name));
+    }
+
+    int64_t elapsed_us() const {
+        return esp_timer_get_time() - start_time_us_;
+    }
+
+    void Print(const char* tag, const char* title) const {
+        size_t count = count_.load(std::memory_order_relaxed);
+        if (count > kMaxSteps) {
+            count = kMaxSteps;
+        }
+        ESP_LOGI(tag, "%s timeline, %u steps, %lu ms total", title, count, (uint32_t)(elapsed_us() / 1000));
+        for (size_t i = 0; i < count; i++) {
+            auto& step = steps_[i];
+            if (step.end_us < 0) {
+                ESP_LOGI(tag, "  %-20s %6lu ms .. (unfinished)", step.name, (uint32_t)(step.begin_us / 1000));
+            } else {
+                ESP_LOGI(tag, "  %-20s %6lu ms .. %6lu ms (%lu ms)", step.name, (uint32_t)(step.begin_us / 1000),
+                    (uint32_t)(step.end_us / 1000), (uint32_t)((step.end_us - step.begin_us) / 1000));
+            }
+        }
+    }
+
+    // [{"name":"...","begin_ms":0,"end_ms":12}, ...]，未结束的步骤 end_ms 为 -1
+    std::string ToJson() const {
+        size_t count = count_.load(std::memory_order_relaxed);
+        if (count > kMaxSteps) {
+            count = kMaxSteps;
+        }
+        cJSON* json = cJSON_CreateArray();
+        for (size_t i = 0; i < count; i++) {
+            auto& step = steps_[i];
+            cJSON* item = cJSON_CreateObject();
+            cJSON_AddStringToObject(item, "name", step.name);
+            cJSON_AddNumberToObject(item, "begin_ms", (double)(step.begin_us / 1000));
+            cJSON_AddNumberToObject(item, "end_ms", step.end_us < 0 ? -1 : (double)(step.end_us / 1000));
+            cJSON_AddItemToArray(json, item);
+        }
+        char* text = cJSON_PrintUnformatted(json);
+        std::string result = text != nullptr ? text : "[]";
+        cJSON_free(text);
+        cJSON_Delete(json);
+        return result;
+    }
+
+private:
+    struct Step {
+        const char* name = "";
+        int64_t begin_us = 0;
+        int64_t end_us = -1;
+    };
+
+    int64_t start_time_us_ = 0;
+    std::atomic<size_t> count_ {0};
+    Step steps_[kMaxSteps];
+};
+
+#endif // TIMELINE_H
@@ -0,0 +1,175 @@
+#include "binary_protocol_frame.h"
+#include "host_test.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static AudioStreamPacket MakePacket(size_t size, uint32_t timestamp) {
+    AudioStreamPacket packet;
+    packet.sample_rate = 16000;
+    packet.frame_duration = 60;
+    packet.timestamp = timestamp;
+    packet.payload.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        packet.payload[i] = (uint8_t)(i * 13 + timestamp);
+    }
+    return packet;
+}
+
+// 改动前 WebsocketProtocol::SendAudio 的写法：每帧新建一个 string
+static std::string FrameLegacy(int version, const AudioStreamPacket& packet) {
+    std::string serialized;
+    if (version == 2) {
+        serialized.resize(sizeof(BinaryProtocol2) + packet.payload.size());
+        auto bp2 = (BinaryProtocol2*)serialized.data();
+        bp2->version = htons(version);
+        bp2->type = 0;
+        bp2->reserved = 0;
+        bp2->timestamp = htonl(packet.timestamp);
+        bp2->payload_size = htonl(packet.payload.size());
+        if (!packet.payload.empty()) {
+            memcpy(bp2->payload, packet.payload.data(), packet.payload.size());
+        }
+    } else {
+        serialized.resize(sizeof(BinaryProtocol3) + packet.payload.size());
+        auto bp3 = (BinaryProtocol3*)serialized.data();
+        bp3->type = 0;
+        bp3->reserved = 0;
+        bp3->payload_size = htons(packet.payload.size());
+        if (!packet.payload.empty()) {
+            memcpy(bp3->payload, packet.payload.data(), packet.payload.size());
+        }
+    }
+    return serialized;
+}
+
+static void TestBp2Layout() {
+    CHECK(sizeof(BinaryProtocol2) == 16);
+    auto packet = MakePacket(300, 0x01020304);
+    std::vector<uint8_t> buffer;
+    CHECK(FrameBinaryAudio(buffer, 2, packet));
+    CHECK(buffer.size() == 16 + 300);
+
+    const uint8_t* p = buffer.data();
+    CHECK(p[0] == 0x00 && p[1] == 0x02);                    // version
+    CHECK(p[2] == 0x00 && p[3] == 0x00);                    // type: OPUS
+    CHECK(p[4] == 0 && p[5] == 0 && p[6] == 0 && p[7] == 0);  // reserved
+    CHECK(p[8] == 0x01 && p[9] == 0x02 && p[10] == 0x03 && p[11] == 0x04);
+    CHECK(p[12] == 0x00 && p[13] == 0x00 && p[14] == 0x01 && p[15] == 0x2c);  // 300
+    CHECK(memcmp(p + 16, packet.payload.data(), 300) == 0);
+}
+
+static void TestBp3Layout() {
+    CHECK(sizeof(BinaryProtocol3) == 4);
+    auto packet = MakePacket(0x1234, 7);
+    std::vector<uint8_t> buffer;
+    CHECK(FrameBinaryAudio(buffer, 3, packet));
+    CHECK(buffer.size() == 4 + 0x1234);
+
+    const uint8_t* p = buffer.data();
+    CHECK(p[0] == 0x00 && p[1] == 0x00);
+    CHECK(p[2] == 0x12 && p[3] == 0x34);
+    CHECK(memcmp(p + 4, packet.payload.data(), 0x1234) == 0);
+}
+
+static void TestVersion1Unframed() {
+    auto packet = MakePacket(10, 0);
+    std::vector<uint8_t> buffer;
+    CHECK(!FrameBinaryAudio(buffer, 1, packet));
+    CHECK(buffer.empty());
+}
+
+// 复用缓冲后帧长变大变小，payload_size 和总长始终与当前帧一致，且与旧写法逐字节相同
+static void TestReusedBufferResizes() {
+    const size_t sizes[] = {120, 40, 0, 512, 1, 200, 120};
+    for (int version : {2, 3}) {
+        std::vector<uint8_t> buffer;
+        uint32_t timestamp = 0;
+        for (size_t size : sizes) {
+            auto packet = MakePacket(size, timestamp += 60);
+            CHECK(FrameBinaryAudio(buffer, version, packet));
+            std::string legacy = FrameLegacy(version, packet);
+            CHECK(buffer.size() == legacy.size());
+            CHECK(memcmp(buffer.data(), legacy.data(), legacy.size()) == 0);
+            if (version == 2) {
+                CHECK(ntohl(((const BinaryProtocol2*)buffer.data())->payload_size) == size);
+            } else {
+                CHECK(ntohs(((const BinaryProtocol3*)buffer.data())->payload_size) == size);
+            }
+        }
+    }
+}
+
+static void TestNoSteadyStateAllocation() {
+    auto packet = MakePacket(120, 0);
+    for (int version : {2, 3}) {
+        std::vector<uint8_t> buffer;
+        CHECK(FrameBinaryAudio(buffer, version, packet));
+        size_t before = g_allocations;
+        for (int i = 0; i < 100; i++) {
+            CHECK(FrameBinaryAudio(buffer, version, packet));
+        }
+        CHECK(g_allocations == before);
+    }
+}
+
+// 60ms Opus 帧约 120 字节；只打印结果，不做断言
+static void Benchmark() {
+    const int kFrames = 500000;
+    auto packet = MakePacket(120, 0);
+    for (int version : {2, 3}) {
+        size_t checksum = 0;
+        std::vector<uint8_t> buffer;
+        size_t before = g_allocations;
+        int64_t start = HostTimeUs();
+        for (int i = 0; i < kFrames; i++) {
+            packet.timestamp = i;
+            FrameBinaryAudio(buffer, version, packet);
+            checksum += buffer[buffer.size() / 2];
+        }
+        int64_t reused_us = HostTimeUs() - start;
+        size_t reused_allocations = g_allocations - before;
+
+        before = g_allocations;
+        start = HostTimeUs();
+        for (int i = 0; i < kFrames; i++) {
+            packet.timestamp = i;
+            std::string legacy = FrameLegacy(version, packet);
+            checksum += (uint8_t)legacy[legacy.size() / 2];
+        }
+        int64_t legacy_us = HostTimeUs() - start;
+        size_t legacy_allocations = g_allocations - before;
+
+        printf("BP%d %d frames: reused %.2f Mfps (%zu allocs), legacy %.2f Mfps (%zu allocs) (checksum %zu)\n",
+            version, kFrames, kFrames / (double)reused_us, reused_allocations,
+            kFrames / (double)legacy_us, legacy_allocations, checksum);
+    }
+}
+
+int main() {
+    TestBp2Layout();
+    TestBp3Layout();
+    TestVersion1Unframed();
+    TestReusedBufferResizes();
+    TestNoSteadyStateAllocation();
+    Benchmark();
+    printf("binary_protocol_frame_test passed\n");
+    return 0;
+}
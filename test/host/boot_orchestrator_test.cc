@@ -0,0 +1,142 @@
+#include "boot_orchestrator.h"
+#include "host_test.h"
+
+#include <freertos/task.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 每个步骤记录开始和结束时的全局序号，用于检查依赖的先后
+struct StepTrace {
+    std::atomic<int> begin {-1};
+    std::atomic<int> end {-1};
+};
+
+static std::atomic<int> sequence {0};
+
+static std::function<void()> Traced(StepTrace& trace, int sleep_us = 0) {
+    return [&trace, sleep_us]() {
+        trace.begin = sequence++;
+        if (sleep_us > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+        }
+        trace.end = sequence++;
+    };
+}
+
+static void CheckAfter(const StepTrace& step, const StepTrace& dependency) {
+    CHECK(dependency.end >= 0 && step.begin > dependency.end);
+}
+
+// 与 Application::Start 相同的依赖图，步骤耗时随机
+static void TestApplicationGraph() {
+    std::mt19937 rng(20240620);
+    for (int round = 0; round < 50; round++) {
+        BootTimeline timeline;
+        timeline.Start();
+        BootOrchestrator boot(timeline);
+        enum { kBoard, kAssetsVerify, kAssetsApply, kStarting, kAudio, kMcp, kNetwork, kAssetsVersion, kOtaCheck, kActivation, kProtocol, kCount };
+        StepTrace traces[kCount];
+        auto delay = [&rng]() { return (int)(rng() % 300); };
+
+        int board = boot.AddStep("board", Traced(traces[kBoard], delay()));
+        int assets_verify = boot.AddStep("assets_verify", Traced(traces[kAssetsVerify], delay()));
+        int assets_apply = boot.AddStep("assets_apply", Traced(traces[kAssetsApply], delay()), {board, assets_verify});
+        int starting = boot.AddStep("starting_state", Traced(traces[kStarting], delay()), {assets_apply});
+        int audio = boot.AddStep("audio", Traced(traces[kAudio], delay()), {starting});
+        int mcp = boot.AddStep("mcp_tools", Traced(traces[kMcp], delay()), {assets_apply});
+        int network = boot.AddStep("network", Traced(traces[kNetwork], delay()), {audio});
+        int assets_version = boot.AddStep("assets_version", Traced(traces[kAssetsVersion], delay()), {network});
+        int ota_check = boot.AddStep("ota_check", Traced(traces[kOtaCheck], delay()), {network});
+        int activation = boot.AddStep("activation", Traced(traces[kActivation], delay()), {ota_check, assets_version});
+        boot.AddStep("protocol", Traced(traces[kProtocol], delay()), {activation, audio, mcp});
+        boot.Run();
+
+        CheckAfter(traces[kAssetsApply], traces[kBoard]);
+        CheckAfter(traces[kAssetsApply], traces[kAssetsVerify]);
+        CheckAfter(traces[kStarting], traces[kAssetsApply]);
+        CheckAfter(traces[kAudio], traces[kStarting]);
+        CheckAfter(traces[kMcp], traces[kAssetsApply]);
+        CheckAfter(traces[kNetwork], traces[kAudio]);
+        CheckAfter(traces[kAssetsVersion], traces[kNetwork]);
+        CheckAfter(traces[kOtaCheck], traces[kNetwork]);
+        CheckAfter(traces[kActivation], traces[kOtaCheck]);
+        CheckAfter(traces[kActivation], traces[kAssetsVersion]);
+        CheckAfter(traces[kProtocol], traces[kActivation]);
+        CheckAfter(traces[kProtocol], traces[kAudio]);
+        CheckAfter(traces[kProtocol], traces[kMcp]);
+    }
+}
+
+// 没有依赖的步骤由调用任务和 BOOT_WORKER_COUNT 个临时任务同时执行
+static void TestParallelism() {
+    BootTimeline timeline;
+    timeline.Start();
+    BootOrchestrator boot(timeline);
+    const int parallel = BOOT_WORKER_COUNT + 1;
+    std::atomic<int> running {0};
+    std::atomic<int> max_running {0};
+    std::atomic<int> arrived {0};
+    for (int i = 0; i < parallel; i++) {
+        boot.AddStep("parallel", [&]() {
+            int now = ++running;
+            int previous = max_running.load();
+            while (now > previous && !max_running.compare_exchange_weak(previous, now)) {
+            }
+            // 等所有步骤都已开始，最多等 5 秒
+            arrived++;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (arrived < parallel && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+            running--;
+        });
+    }
+    boot.Run();
+    CHECK(max_running == parallel);
+}
+
+// 创建临时任务失败时由调用任务执行全部步骤
+static void TestWorkerCreateFailure() {
+    host_task_create_fail = true;
+    BootTimeline timeline;
+    timeline.Start();
+    BootOrchestrator boot(timeline);
+    StepTrace first;
+    StepTrace second;
+    int step = boot.AddStep("first", Traced(first));
+    boot.AddStep("second", Traced(second), {step});
+    boot.Run();
+    host_task_create_fail = false;
+    CheckAfter(second, first);
+}
+
+// 无效依赖被忽略；超过 BOOT_MAX_STEPS 的步骤不添加
+static void TestInvalidDependenciesAndLimit() {
+    BootTimeline timeline;
+    timeline.Start();
+    BootOrchestrator boot(timeline);
+    std::atomic<int> runs {0};
+    auto count = [&runs]() { runs++; };
+    CHECK(boot.AddStep("self", count, {0}) == 0);
+    CHECK(boot.AddStep("forward", count, {5, -1}) == 1);
+    for (int i = 2; i < BOOT_MAX_STEPS; i++) {
+        CHECK(boot.AddStep("filler", count, {i - 1}) == i);
+    }
+    CHECK(boot.AddStep("overflow", count) == -1);
+    boot.Run();
+    CHECK(runs == BOOT_MAX_STEPS);
+}
+
+int main() {
+    TestApplicationGraph();
+    TestParallelism();
+    TestWorkerCreateFailure();
+    TestInvalidDependenciesAndLimit();
+    printf("boot_orchestrator_test passed\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "cjson_arena.h"
+#include "host_test.h"
+
+#include <cJSON.h>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// 典型的 MCP tools/call 请求和回复
+static const char* const kRequest =
+    R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"self.audio_speaker.set_volume",)"
+    R"("arguments":{"volume":50,"fade":[1,2,3],"note":"你好"}},"id":42})";
+
+static std::string BuildReply(const cJSON* request) {
+    cJSON* reply = cJSON_CreateObject();
+    cJSON_AddStringToObject(reply, "jsonrpc", "2.0");
+    cJSON_AddNumberToObject(reply, "id", cJSON_GetObjectItem(request, "id")->valuedouble);
+    cJSON* result = cJSON_AddObjectToObject(reply, "result");
+    cJSON* content = cJSON_AddArrayToObject(result, "content");
+    cJSON* text = cJSON_CreateObject();
+    cJSON_AddStringToObject(text, "type", "text");
+    cJSON_AddStringToObject(text, "text", "true");
+    cJSON_AddItemToArray(content, text);
+    cJSON_AddBoolToObject(result, "isError", false);
+    char* printed = cJSON_PrintUnformatted(reply);
+    std::string output = printed;
+    cJSON_free(printed);
+    cJSON_Delete(reply);
+    return output;
+}
+
+static std::string HandleRequest() {
+    cJSON* request = cJSON_Parse(kRequest);
+    CHECK(request != nullptr);
+    std::string reply = BuildReply(request);
+    cJSON_Delete(request);
+    return reply;
+}
+
+// 内层作用域创建的对象带到外层后，外层继续分配也不会覆盖它
+static void TestNestedScopeEscape() {
+    auto before = CJsonArena::GetStatistics();
+    CJsonArenaScope outer;
+    cJSON* outer_object = cJSON_CreateObject();
+    cJSON* escaped = nullptr;
+    {
+        CJsonArenaScope inner;
+        escaped = cJSON_CreateString("escaped from the inner scope");
+        CHECK(CJsonArena::GetStatistics().arena_allocations == before.arena_allocations + 1);
+    }
+    cJSON_AddItemToObject(outer_object, "escaped", escaped);
+    for (int i = 0; i < 50; i++) {
+        cJSON_AddStringToObject(outer_object, ("filler" + std::to_string(i)).c_str(), "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+    }
+    CHECK(strcmp(cJSON_GetObjectItem(outer_object, "escaped")->valuestring, "escaped from the inner scope") == 0);
+    cJSON_Delete(outer_object);
+
+    auto after = CJsonArena::GetStatistics();
+    CHECK(after.scopes == before.scopes + 1);
+    CHECK(after.nested_scopes == before.nested_scopes + 1);
+    // 外层的分配仍在竞技场中
+    CHECK(after.arena_allocations > before.arena_allocations + 50);
+}
+
+// 多层嵌套：只有最外层结束时恢复竞技场，内层之间不互相恢复
+static void TestDeepNesting() {
+    CJsonArenaScope outer;
+    auto base = CJsonArena::GetStatistics();
+    {
+        CJsonArenaScope inner;
+        {
+            CJsonArenaScope innermost;
+            cJSON_Delete(cJSON_CreateObject());
+        }
+        cJSON_Delete(cJSON_CreateObject());
+        CHECK(CJsonArena::GetStatistics().arena_allocations == base.arena_allocations);
+    }
+    cJSON_Delete(cJSON_CreateObject());
+    CHECK(CJsonArena::GetStatistics().arena_allocations == base.arena_allocations + 1);
+}
+
+// 其他任务持有竞技场时本任务走堆；统计在并发更新时读取
+static void TestOtherTask() {
+    std::string reply;
+    {
+        CJsonArenaScope scope;
+        std::thread other([&reply]() {
+            CJsonArenaScope other_scope;
+            reply = HandleRequest();
+            auto stats = CJsonArena::GetStatistics();
+            CHECK(stats.scopes > 0);
+        });
+        other.join();
+    }
+    CHECK(reply == HandleRequest());
+}
+
+static void Benchmark() {
+    const int kMessages = 20000;
+    std::string expected = HandleRequest();
+
+    int64_t start = HostTimeUs();
+    for (int i = 0; i < kMessages; i++) {
+        CHECK(HandleRequest().size() == expected.size());
+    }
+    int64_t heap_us = HostTimeUs() - start;
+
+    auto before = CJsonArena::GetStatistics();
+    start = HostTimeUs();
+    for (int i = 0; i < kMessages; i++) {
+        CJsonArenaScope arena;
+        CHECK(HandleRequest().size() == expected.size());
+    }
+    int64_t arena_us = HostTimeUs() - start;
+    auto after = CJsonArena::GetStatistics();
+
+    printf("parse + reply of an MCP tools/call, %d messages:\n", kMessages);
+    printf("  heap  %.2f us/message\n", (double)heap_us / kMessages);
+    printf("  arena %.2f us/message, %.1f arena allocations/message, peak %zu bytes, heap fallbacks %u\n",
+        (double)arena_us / kMessages, (double)(after.arena_allocations - before.arena_allocations) / kMessages,
+        after.peak_used, after.heap_fallbacks - before.heap_fallbacks);
+    CHECK(after.heap_fallbacks == before.heap_fallbacks);
+}
+
+int main() {
+    CJsonArena::Initialize();
+    TestNestedScopeEscape();
+    TestDeepNesting();
+    TestOtherTask();
+    Benchmark();
+    CJsonArena::PrintStatistics();
+    printf("cjson_arena_test passed\n");
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "deferred_work.h"
+#include "host_test.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// 简单的门闩，工作函数在里面阻塞直到测试放行
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return open; });
+    }
+    void Open() {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+        cv.notify_all();
+    }
+};
+
+static void WaitFor(const std::atomic<int>& value, int expected) {
+    while (value.load() < expected) {
+        std::this_thread::yield();
+    }
+}
+
+struct Counter {
+    std::atomic<int> entered {0};
+    std::atomic<int> finished {0};
+    Gate* gate = nullptr;
+};
+
+static void CountWork(void* arg) {
+    auto counter = static_cast<Counter*>(arg);
+    counter->entered++;
+    if (counter->gate != nullptr) {
+        counter->gate->Wait();
+    }
+    counter->finished++;
+}
+
+static void TestRunAndCoalesce() {
+    Gate gate;
+    Counter counter;
+    counter.gate = &gate;
+    DeferredWork work("count", CountWork, &counter);
+    CHECK(work.Post());
+    WaitFor(counter.entered, 1);
+    // 执行中再次投递：第一次排队，之后的合并
+    CHECK(work.Post());
+    CHECK(work.Post());
+    CHECK(work.Post());
+    // 工作执行时不持有全局锁，统计打印不被阻塞
+    DeferredWork::PrintStatistics();
+    gate.Open();
+    WaitFor(counter.finished, 2);
+    CHECK(counter.entered.load() == 2);
+}
+
+// 其他任务析构正在执行的工作项时，等待执行结束后才返回
+static void TestDestroyWaitsForRunning() {
+    Gate gate;
+    Counter counter;
+    counter.gate = &gate;
+    auto work = new DeferredWork("slow", CountWork, &counter);
+    CHECK(work->Post());
+    WaitFor(counter.entered, 1);
+
+    std::atomic<bool> destroyed {false};
+    std::thread destroyer([&]() {
+        delete work;
+        destroyed = true;
+    });
+    for (int i = 0; i < 1000; i++) {
+        std::this_thread::yield();
+    }
+    CHECK(!destroyed.load());
+    gate.Open();
+    destroyer.join();
+    CHECK(destroyed.load() && counter.finished.load() == 1);
+}
+
+// 工作函数中创建和析构其他工作项（以前在持锁执行时会死锁）
+struct Nested {
+    Counter inner_counter;
+    std::atomic<int> done {0};
+};
+
+static void NestedWork(void* arg) {
+    auto nested = static_cast<Nested*>(arg);
+    {
+        DeferredWork inner("inner", CountWork, &nested->inner_counter);
+        inner.Post();
+        // inner 排在本工作项之后，析构时从队列中滤掉，不会执行
+    }
+    nested->done++;
+}
+
+static void TestCreateAndDestroyInsideWork() {
+    Nested nested;
+    DeferredWork outer("outer", NestedWork, &nested);
+    for (int i = 1; i <= 5; i++) {
+        CHECK(outer.Post());
+        WaitFor(nested.done, i);
+    }
+    CHECK(nested.inner_counter.entered.load() == 0);
+}
+
+// 工作函数中析构自身，执行结束后不再访问该对象（ASan 检查）
+struct SelfDestroy {
+    DeferredWork* work = nullptr;
+    std::atomic<int> done {0};
+};
+
+static void SelfDestroyWork(void* arg) {
+    auto self = static_cast<SelfDestroy*>(arg);
+    delete self->work;
+    self->work = nullptr;
+    self->done++;
+}
+
+static void TestDestroySelfInsideWork() {
+    SelfDestroy self;
+    self.work = new DeferredWork("self", SelfDestroyWork, &self);
+    CHECK(self.work->Post());
+    WaitFor(self.done, 1);
+
+    // 工作线程仍然正常处理之后的工作
+    Counter counter;
+    DeferredWork after("after", CountWork, &counter);
+    CHECK(after.Post());
+    WaitFor(counter.finished, 1);
+}
+
+// 排队中析构的工作项不会被执行
+static void TestDestroyQueued() {
+    Gate gate;
+    Counter blocker;
+    blocker.gate = &gate;
+    DeferredWork blocking("blocking", CountWork, &blocker);
+    CHECK(blocking.Post());
+    WaitFor(blocker.entered, 1);
+
+    Counter queued_counter;
+    Counter kept_counter;
+    auto queued = new DeferredWork("queued", CountWork, &queued_counter);
+    DeferredWork kept("kept", CountWork, &kept_counter);
+    CHECK(queued->Post());
+    CHECK(kept.Post());
+    delete queued;
+    gate.Open();
+    WaitFor(kept_counter.finished, 1);
+    CHECK(queued_counter.entered.load() == 0);
+}
+
+int main() {
+    TestRunAndCoalesce();
+    TestDestroyWaitsForRunning();
+    TestCreateAndDestroyInsideWork();
+    TestDestroySelfInsideWork();
+    TestDestroyQueued();
+    printf("deferred_work_test passed\n");
+    return 0;
+}
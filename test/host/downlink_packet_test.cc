@@ -0,0 +1,149 @@
+// 按 NeRTC 的配置编译，AudioStreamPacket 带 muted / pcm_payload
+#define CONFIG_CONNECTION_TYPE_NERTC 1
+
+#include "downlink_packet.h"
+#include "host_test.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+static uint8_t FrameByte(uint32_t frame, size_t offset) {
+    return (uint8_t)(frame * 37 + offset * 11);
+}
+
+static uint32_t Checksum(const uint8_t* data, size_t length) {
+    uint32_t sum = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        sum = (sum ^ data[i]) * 16777619u;
+    }
+    return sum;
+}
+
+// 模拟 SDK：帧缓冲在回调之间复用，参考帧接口在调用内把数据拷进自己的缓冲
+struct FakeSdk {
+    std::vector<uint8_t> frame_buffer = std::vector<uint8_t>(1500);
+    std::vector<uint8_t> reference_buffer;
+    uint32_t reference_frames = 0;
+    uint32_t reference_checksum = 0;
+    const uint8_t* last_reference_payload = nullptr;
+
+    void PushReferenceFrame(const AudioStreamPacket& packet) {
+        reference_buffer.assign(packet.payload.begin(), packet.payload.end());
+        reference_checksum = Checksum(reference_buffer.data(), reference_buffer.size());
+        last_reference_payload = packet.payload.data();
+        reference_frames++;
+    }
+};
+
+struct DecodeItem {
+    std::unique_ptr<AudioStreamPacket> packet;
+    uint32_t frame;
+    const uint8_t* reference_payload;
+    uint32_t reference_checksum;
+};
+
+// 与 Application::OnIncomingAudio 相同的移交顺序，解码队列在另一个线程中消费并释放包
+static void TestHandOffLifetime() {
+    FakeSdk sdk;
+    std::atomic<uint32_t> bytes_copied {0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<DecodeItem> decode_queue;
+    bool done = false;
+    uint32_t decoded = 0;
+    uint64_t expected_bytes = 0;
+
+    std::thread decoder([&]() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return done || !decode_queue.empty(); });
+            if (decode_queue.empty()) {
+                break;
+            }
+            auto item = std::move(decode_queue.front());
+            decode_queue.pop_front();
+            lock.unlock();
+
+            // 回调返回后 SDK 缓冲已被改写，解码队列里的包必须是独立的副本，且就是参考帧借用的那一个
+            auto& packet = *item.packet;
+            CHECK(packet.payload.data() == item.reference_payload);
+            CHECK(Checksum(packet.payload.data(), packet.payload.size()) == item.reference_checksum);
+            for (size_t i = 0; i < packet.payload.size(); i++) {
+                CHECK(packet.payload[i] == FrameByte(item.frame, i));
+            }
+            CHECK(packet.timestamp == item.frame * 60);
+            decoded++;
+        }
+    });
+
+    std::mt19937 rng(28);
+    const uint32_t kFrames = 2000;
+    for (uint32_t frame = 0; frame < kFrames; frame++) {
+        size_t length = 20 + rng() % 300;
+        for (size_t i = 0; i < length; i++) {
+            sdk.frame_buffer[i] = FrameByte(frame, i);
+        }
+        expected_bytes += length;
+
+        // OnAudioData 回调
+        uint32_t copies_before = bytes_copied.load();
+        auto packet = CopyDownlinkFrame(sdk.frame_buffer.data(), length, frame * 60, 24000, 60, [&](size_t bytes) {
+            bytes_copied.fetch_add(bytes);
+        });
+        CHECK(bytes_copied.load() - copies_before == length);
+        CHECK(packet->sample_rate == 24000 && packet->frame_duration == 60);
+
+        bool reference_consumed = false;
+        HandOffDownlinkPacket(std::move(packet), [&](const AudioStreamPacket& reference) {
+            sdk.PushReferenceFrame(reference);
+            reference_consumed = true;
+        }, [&](std::unique_ptr<AudioStreamPacket> decode_packet) {
+            // 参考帧在移交解码队列之前已经同步消费完
+            CHECK(reference_consumed);
+            CHECK(sdk.last_reference_payload == decode_packet->payload.data());
+            std::lock_guard<std::mutex> lock(mutex);
+            decode_queue.push_back({std::move(decode_packet), frame, sdk.last_reference_payload, sdk.reference_checksum});
+            cv.notify_one();
+        });
+        CHECK(reference_consumed);
+
+        // 回调返回，SDK 复用帧缓冲
+        memset(sdk.frame_buffer.data(), 0xEE, sdk.frame_buffer.size());
+        if (frame % 64 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    cv.notify_one();
+    decoder.join();
+
+    CHECK(decoded == kFrames);
+    CHECK(sdk.reference_frames == kFrames);
+    // 每帧恰好一次拷贝
+    CHECK(bytes_copied.load() == expected_bytes);
+    printf("hand off: %u frames, %u bytes copied\n", kFrames, bytes_copied.load());
+}
+
+// 没有数据的帧（静音包）不拷贝也不计数
+static void TestEmptyFrame() {
+    uint32_t bytes_copied = 0;
+    auto packet = CopyDownlinkFrame(nullptr, 0, 7, 16000, 20, [&](size_t bytes) { bytes_copied += bytes; });
+    CHECK(packet->payload.empty() && packet->timestamp == 7);
+    CHECK(bytes_copied == 0);
+}
+
+int main() {
+    TestHandOffLifetime();
+    TestEmptyFrame();
+    printf("downlink_packet_test passed\n");
+    return 0;
+}
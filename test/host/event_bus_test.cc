@@ -0,0 +1,142 @@
+#include "event_bus.h"
+#include "host_test.h"
+
+#include <thread>
+#include <vector>
+
+struct TestEvent {
+    int value;
+};
+
+using TestBus = EventBus<TestEvent, 4, 2>;
+
+struct Recorder {
+    int id = 0;
+    std::vector<int> log;
+};
+
+// 记录 value * 10 + 订阅者编号
+static void Record(const TestEvent& event, void* context) {
+    auto recorder = static_cast<Recorder*>(context);
+    recorder->log.push_back(event.value * 10 + recorder->id);
+}
+
+static std::vector<int> shared_log;
+
+static void RecordShared(const TestEvent& event, void* context) {
+    shared_log.push_back(event.value * 10 + (int)(intptr_t)context);
+}
+
+// 收到 1 时再发布 2 和 3：应排在本轮之后分发，而不是递归
+static void Republish(const TestEvent& event, void* context) {
+    RecordShared(event, (void*)1);
+    if (event.value == 1) {
+        auto bus = static_cast<TestBus*>(context);
+        bus->Publish(TestEvent {2});
+        bus->Publish(TestEvent {3});
+    }
+}
+
+static void TestOrderingAndReentrancy() {
+    TestBus bus;
+    shared_log.clear();
+    CHECK(bus.Subscribe(Republish, &bus) == 0);
+    CHECK(bus.Subscribe(RecordShared, (void*)2) == 1);
+    bus.Publish(TestEvent {1});
+    CHECK((shared_log == std::vector<int> {11, 12, 21, 22, 31, 32}));
+
+    auto statistics = bus.GetStatistics();
+    CHECK(statistics.published == 3);
+    CHECK(statistics.deferred == 2);
+    CHECK(statistics.dropped == 0);
+    CHECK(statistics.max_fan_out == 2);
+}
+
+// 回调中连续发布超过 kMaxDeferred 个事件时，多出的被丢弃
+static void FloodFromCallback(const TestEvent& event, void* context) {
+    RecordShared(event, (void*)0);
+    if (event.value == 0) {
+        auto bus = static_cast<TestBus*>(context);
+        for (int i = 1; i <= 4; i++) {
+            bus->Publish(TestEvent {i});
+        }
+    }
+}
+
+static void TestDeferredOverflow() {
+    TestBus bus;
+    shared_log.clear();
+    bus.Subscribe(FloodFromCallback, &bus);
+    bus.Publish(TestEvent {0});
+    CHECK((shared_log == std::vector<int> {0, 10, 20}));
+    auto statistics = bus.GetStatistics();
+    CHECK(statistics.deferred == 2);
+    CHECK(statistics.dropped == 2);
+}
+
+static void TestSubscribeLimitAndUnsubscribe() {
+    TestBus bus;
+    Recorder recorders[5];
+    for (int i = 0; i < 4; i++) {
+        recorders[i].id = i;
+        CHECK(bus.Subscribe(Record, &recorders[i]) == i);
+    }
+    CHECK(bus.Subscribe(Record, &recorders[4]) == -1);
+
+    bus.Unsubscribe(1);
+    bus.Unsubscribe(-1);
+    bus.Unsubscribe(4);
+    bus.Publish(TestEvent {5});
+    CHECK(recorders[1].log.empty());
+    CHECK((recorders[0].log == std::vector<int> {50}));
+    CHECK((recorders[3].log == std::vector<int> {53}));
+
+    // 空出的槽位被重新使用
+    recorders[4].id = 4;
+    CHECK(bus.Subscribe(Record, &recorders[4]) == 1);
+    bus.Publish(TestEvent {6});
+    CHECK((recorders[4].log == std::vector<int> {64}));
+}
+
+// 多个任务同时发布：分发互斥，不丢事件，每个订阅者看到的顺序一致
+static void TestConcurrentPublishers() {
+    TestBus bus;
+    Recorder first;
+    Recorder second;
+    first.id = 1;
+    second.id = 2;
+    bus.Subscribe(Record, &first);
+    bus.Subscribe(Record, &second);
+
+    const int publishers = 4;
+    const int per_publisher = 5000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < publishers; p++) {
+        threads.emplace_back([&bus, p]() {
+            for (int i = 0; i < per_publisher; i++) {
+                bus.Publish(TestEvent {p});
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(first.log.size() == (size_t)publishers * per_publisher);
+    CHECK(second.log.size() == first.log.size());
+    for (size_t i = 0; i < first.log.size(); i++) {
+        CHECK(first.log[i] / 10 == second.log[i] / 10);
+    }
+    auto statistics = bus.GetStatistics();
+    CHECK(statistics.published == (uint32_t)(publishers * per_publisher));
+    CHECK(statistics.deferred == 0 && statistics.dropped == 0);
+}
+
+int main() {
+    TestOrderingAndReentrancy();
+    TestDeferredOverflow();
+    TestSubscribeLimitAndUnsubscribe();
+    TestConcurrentPublishers();
+    printf("event_bus_test passed\n");
+    return 0;
+}
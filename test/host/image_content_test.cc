@@ -0,0 +1,135 @@
+#include "image_content.h"
+#include "host_test.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+// 独立的参考实现：逐位拼 6-bit 组编码 base64
+static std::string ReferenceBase64(const std::string& data) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    unsigned int bits = 0;
+    int bit_count = 0;
+    for (unsigned char c : data) {
+        bits = (bits << 8) | c;
+        bit_count += 8;
+        while (bit_count >= 6) {
+            bit_count -= 6;
+            out += table[(bits >> bit_count) & 63];
+        }
+    }
+    if (bit_count > 0) {
+        out += table[(bits << (6 - bit_count)) & 63];
+    }
+    while (out.size() % 4 != 0) {
+        out += '=';
+    }
+    return out;
+}
+
+// 参考转义：cJSON_PrintUnformatted 的规则
+static std::string ReferenceEscape(const std::string& text) {
+    std::string out;
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c == '\b') {
+            out += "\\b";
+        } else if (c == '\f') {
+            out += "\\f";
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if (c < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        } else {
+            out += (char)c;
+        }
+    }
+    return out;
+}
+
+static std::string ReferenceJson(const std::string& mime_type, const std::string& data) {
+    return "{\"type\":\"image\",\"mimeType\":\"" + ReferenceEscape(mime_type) + "\",\"data\":\"" + ReferenceBase64(data) + "\"}";
+}
+
+static void CheckImage(const std::string& mime_type, const std::string& data) {
+    ImageContent image(mime_type, data);
+    std::string expected = ReferenceJson(mime_type, data);
+    CHECK(image.to_json() == expected);
+
+    // 追加到已有内容之后，前缀保持不变
+    std::string out = "{\"content\":[{\"type\":\"text\",\"text\":\"";
+    std::string prefix = out;
+    image.AppendAsJsonString(out);
+    CHECK(out.compare(0, prefix.size(), prefix) == 0);
+    std::string appended = out.substr(prefix.size());
+    CHECK(appended == ReferenceEscape(expected));
+    CHECK(appended.size() <= image.json_string_size());
+}
+
+static void TestKnownVectors() {
+    // RFC 4648 测试向量
+    static const char* const kVectors[][2] = {
+        {"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"},
+        {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"},
+    };
+    for (auto& vector : kVectors) {
+        CHECK(ReferenceBase64(vector[0]) == vector[1]);
+        ImageContent image("image/jpeg", vector[0]);
+        CHECK(image.to_json() == std::string("{\"type\":\"image\",\"mimeType\":\"image/jpeg\",\"data\":\"") + vector[1] + "\"}");
+    }
+}
+
+// 覆盖 3 KB 分块边界附近的长度以及典型照片大小
+static void TestSizes() {
+    std::mt19937 rng(20240615);
+    const size_t chunk = 3 * 1024;
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < 16; i++) {
+        sizes.push_back(i);
+    }
+    for (size_t base : {chunk, 2 * chunk, 7 * chunk}) {
+        for (size_t delta = 0; delta < 5; delta++) {
+            sizes.push_back(base + delta);
+            sizes.push_back(base - delta - 1);
+        }
+    }
+    for (int i = 0; i < 40; i++) {
+        sizes.push_back(rng() % (64 * 1024));
+    }
+    sizes.push_back(120 * 1024 + 17);
+
+    for (size_t size : sizes) {
+        std::string data(size, '\0');
+        for (auto& c : data) {
+            c = (char)rng();
+        }
+        CheckImage("image/jpeg", data);
+    }
+}
+
+// mimeType 中需要转义的字符在外层字符串中被转义两次
+static void TestMimeTypeEscaping() {
+    std::string mime_type = "image/\"x\"\\y\n\t\b\f\r";
+    mime_type += '\x01';
+    mime_type += '\x1f';
+    mime_type += "\xe5\x9b\xbe";
+    CheckImage(mime_type, "abc");
+    CheckImage(std::string(200, '"'), "abcd");
+}
+
+int main() {
+    TestKnownVectors();
+    TestSizes();
+    TestMimeTypeEscaping();
+    printf("image_content_test passed\n");
+    return 0;
+}
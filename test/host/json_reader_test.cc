@@ -0,0 +1,222 @@
+#include "json_reader.h"
+#include "host_test.h"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_CJSON
+#include <cJSON.h>
+#endif
+
+// 录制的典型入站控制消息
+static const char* const kRecordedMessages[] = {
+    R"({"type":"hello","transport":"websocket","session_id":"e1a2f3","audio_params":{"format":"opus","sample_rate":24000,"channels":1,"frame_duration":60}})",
+    R"({"type":"tts","state":"start","sample_rate":24000,"session_id":"e1a2f3"})",
+    R"({"type":"tts","state":"sentence_start","text":"\u4f60\u597d\uff0c\"\u5c0f\u667a\"\n\ud83d\ude00","session_id":"e1a2f3"})",
+    R"({"type":"stt","text":"今天天气怎么样","session_id":"e1a2f3"})",
+    R"({"type":"llm","text":"😊","emotion":"happy","session_id":"e1a2f3"})",
+    R"({"session_id":"e1a2f3","type":"mcp","payload":{"jsonrpc":"2.0","method":"tools/call","params":{"name":"self.audio_speaker.set_volume","arguments":{"volume":[1,2,{"b":"}]\""}]}},"id":3}})",
+    R"({"type":"alert","status":"error","message":"a\\b\/c\tz","emotion":"sad","n":-12,"t":true,"f":false,"z":null})",
+    " { \"type\" : \"system\" , \"command\" : \"reboot\" } ",
+    "{}",
+};
+
+static bool Parse(std::string& buffer, JsonReader& reader) {
+    reader = JsonReader(buffer.data(), buffer.size());
+    return reader.Parse();
+}
+
+static void TestRecordedMessages() {
+    std::string buffer = kRecordedMessages[2];
+    JsonReader reader(buffer.data(), buffer.size());
+    CHECK(reader.Parse());
+    CHECK(reader.field_count() == 4);
+    CHECK(strcmp(reader.GetString("type"), "tts") == 0);
+    CHECK(strcmp(reader.GetString("state"), "sentence_start") == 0);
+    CHECK(strcmp(reader.GetString("text"), "你好，\"小智\"\n😀") == 0);
+    CHECK(reader.GetString("missing") == nullptr);
+
+    buffer = kRecordedMessages[5];
+    CHECK(Parse(buffer, reader));
+    const char* raw = nullptr;
+    size_t length = 0;
+    CHECK(reader.GetRaw("payload", kJsonObject, raw, length));
+    CHECK(std::string(raw, length) ==
+        R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"self.audio_speaker.set_volume","arguments":{"volume":[1,2,{"b":"}]\""}]}},"id":3})");
+    CHECK(!reader.GetRaw("payload", kJsonArray, raw, length));
+    CHECK(reader.GetString("payload") == nullptr);
+
+    buffer = kRecordedMessages[6];
+    CHECK(Parse(buffer, reader));
+    CHECK(strcmp(reader.GetString("message"), "a\\b/c\tz") == 0);
+    int number = 0;
+    CHECK(reader.GetInt("n", number) && number == -12);
+    bool flag = false;
+    CHECK(reader.GetBool("t", flag) && flag);
+    CHECK(reader.GetBool("f", flag) && !flag);
+    CHECK(reader.GetType("z") == kJsonNull);
+    CHECK(!reader.GetInt("type", number));
+
+    buffer = kRecordedMessages[7];
+    CHECK(Parse(buffer, reader));
+    CHECK(strcmp(reader.GetString("command"), "reboot") == 0);
+
+    buffer = kRecordedMessages[8];
+    CHECK(Parse(buffer, reader));
+    CHECK(reader.field_count() == 0);
+}
+
+static void TestMalformed() {
+    static const char* const kMalformed[] = {
+        "", "   ", "[]", "\"type\"", "{", "{\"type\"", "{\"type\":", "{\"type\":\"tts\"",
+        "{\"type\":\"tts\",}", "{\"type\" \"tts\"}", "{\"type\":\"tts}", "{\"type\":\"\\x\"}",
+        "{\"type\":\"\\u12\"}", "{\"type\":tru}", "{\"payload\":{\"a\":[1,2}", "{\"n\":}", "{type:1}",
+    };
+    for (auto text : kMalformed) {
+        std::string buffer = text;
+        JsonReader reader(buffer.data(), buffer.size());
+        if (reader.Parse()) {
+            fprintf(stderr, "accepted malformed input: %s\n", text);
+            CHECK(false);
+        }
+    }
+}
+
+static void TestFieldLimit() {
+    std::string buffer = "{";
+    for (size_t i = 0; i < JsonReader::kMaxFields + 4; i++) {
+        buffer += (i > 0 ? ",\"k" : "\"k") + std::to_string(i) + "\":" + std::to_string(i);
+    }
+    buffer += "}";
+    JsonReader reader(buffer.data(), buffer.size());
+    CHECK(reader.Parse());
+    CHECK(reader.field_count() == JsonReader::kMaxFields);
+    int value = 0;
+    CHECK(reader.GetInt("k0", value) && value == 0);
+    CHECK(!reader.GetInt("k19", value));
+}
+
+// 随机变异录制消息：缓冲区按实际长度分配，越界读写由 ASan 报告；解析成功时字符串值必须在缓冲区内结束
+static void TestFuzz() {
+    std::mt19937 rng(20240601);
+    const size_t message_count = sizeof(kRecordedMessages) / sizeof(kRecordedMessages[0]);
+    static const char kAlphabet[] = "\"\\{}[]:,u0aD-e.tn \x01\xff";
+    size_t parsed = 0;
+    for (int iteration = 0; iteration < 300000; iteration++) {
+        std::string text = kRecordedMessages[rng() % message_count];
+        int mutations = rng() % 6;
+        for (int i = 0; i < mutations && !text.empty(); i++) {
+            size_t position = rng() % text.size();
+            switch (rng() % 3) {
+            case 0:
+                text[position] = kAlphabet[rng() % (sizeof(kAlphabet) - 1)];
+                break;
+            case 1:
+                text.erase(position, 1 + rng() % 4);
+                break;
+            default:
+                text.insert(position, 1, (char)(rng() % 256));
+                break;
+            }
+        }
+        if (rng() % 4 == 0 && !text.empty()) {
+            text.resize(rng() % text.size());
+        }
+
+        std::vector<char> buffer(text.begin(), text.end());
+        char* begin = buffer.empty() ? nullptr : buffer.data();
+        JsonReader reader(begin, buffer.size());
+        if (!reader.Parse()) {
+            continue;
+        }
+        parsed++;
+        for (const char* name : {"type", "text", "state", "session_id", "message"}) {
+            const char* value = reader.GetString(name);
+            if (value != nullptr) {
+                CHECK(value >= begin && value < begin + buffer.size());
+                CHECK(memchr(value, '\0', begin + buffer.size() - value) != nullptr);
+            }
+        }
+    }
+    printf("fuzz: %zu of 300000 mutated messages parsed\n", parsed);
+}
+
+#ifdef HAVE_CJSON
+// 两种解析都接受的消息，顶层字符串、数字、布尔和嵌套原文必须与 cJSON 一致
+static void CompareWithCJson(const char* text) {
+    cJSON* root = cJSON_Parse(text);
+    CHECK(root != nullptr);
+    std::string buffer = text;
+    JsonReader reader(buffer.data(), buffer.size());
+    CHECK(reader.Parse());
+    for (cJSON* item = root->child; item != nullptr; item = item->next) {
+        if (cJSON_IsString(item)) {
+            CHECK(reader.GetString(item->string) != nullptr);
+            CHECK(strcmp(reader.GetString(item->string), item->valuestring) == 0);
+        } else if (cJSON_IsNumber(item)) {
+            int value = 0;
+            CHECK(reader.GetInt(item->string, value) && value == item->valueint);
+        } else if (cJSON_IsBool(item)) {
+            bool value = false;
+            CHECK(reader.GetBool(item->string, value) && value == (bool)cJSON_IsTrue(item));
+        } else if (cJSON_IsObject(item) || cJSON_IsArray(item)) {
+            const char* raw = nullptr;
+            size_t length = 0;
+            CHECK(reader.GetRaw(item->string, cJSON_IsObject(item) ? kJsonObject : kJsonArray, raw, length));
+            cJSON* nested = cJSON_ParseWithLength(raw, length);
+            CHECK(nested != nullptr);
+            char* expected = cJSON_PrintUnformatted(item);
+            char* actual = cJSON_PrintUnformatted(nested);
+            CHECK(strcmp(expected, actual) == 0);
+            cJSON_free(expected);
+            cJSON_free(actual);
+            cJSON_Delete(nested);
+        }
+    }
+    cJSON_Delete(root);
+}
+
+static void BenchmarkAgainstCJson() {
+    const int rounds = 20000;
+    int64_t start = HostTimeUs();
+    size_t found = 0;
+    for (int i = 0; i < rounds; i++) {
+        for (auto text : kRecordedMessages) {
+            cJSON* root = cJSON_Parse(text);
+            found += cJSON_GetObjectItem(root, "type") != nullptr;
+            cJSON_Delete(root);
+        }
+    }
+    int64_t cjson_us = HostTimeUs() - start;
+
+    start = HostTimeUs();
+    std::string buffer;
+    for (int i = 0; i < rounds; i++) {
+        for (auto text : kRecordedMessages) {
+            buffer.assign(text);
+            JsonReader reader(buffer.data(), buffer.size());
+            found += reader.Parse() && reader.GetString("type") != nullptr;
+        }
+    }
+    int64_t reader_us = HostTimeUs() - start;
+    printf("benchmark: %d rounds of recorded messages, cJSON %lld us, JsonReader %lld us (%zu)\n",
+        rounds, (long long)cjson_us, (long long)reader_us, found);
+}
+#endif
+
+int main() {
+    TestRecordedMessages();
+    TestMalformed();
+    TestFieldLimit();
+    TestFuzz();
+#ifdef HAVE_CJSON
+    for (auto text : kRecordedMessages) {
+        CompareWithCJson(text);
+    }
+    BenchmarkAgainstCJson();
+#endif
+    printf("json_reader_test passed\n");
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "nertc_open_path.h"
+#include "host_test.h"
+
+#include <string>
+#include <vector>
+
+static void TestChoosePath() {
+    CHECK(ChooseNeRtcOpenPath(false, false, false) == kNeRtcOpenCold);
+    CHECK(ChooseNeRtcOpenPath(false, true, false) == kNeRtcOpenCold);
+    CHECK(ChooseNeRtcOpenPath(false, true, true) == kNeRtcOpenCold);
+    CHECK(ChooseNeRtcOpenPath(true, false, false) == kNeRtcOpenWarm);
+    CHECK(ChooseNeRtcOpenPath(true, false, true) == kNeRtcOpenWarm);
+    CHECK(ChooseNeRtcOpenPath(true, true, false) == kNeRtcOpenRestart);
+    CHECK(ChooseNeRtcOpenPath(true, true, true) == kNeRtcOpenWarmPrompt);
+}
+
+// SDK 的本地替身：按虚拟时钟累计各接口的往返时延，并记录服务端看到的开场话题和用户输入
+// 时延取自设备日志的典型值，只用于比较各条路径的相对开销
+struct StandInEngine {
+    static constexpr int64_t kStartAiUs = 180000;      // nertc_start_ai_with_config（含字幕启动）
+    static constexpr int64_t kStopAiUs = 60000;        // nertc_stop_ai
+    static constexpr int64_t kPromptUs = 15000;        // nertc_ai_llm_prompt 送达
+    static constexpr int64_t kFirstResponseUs = 450000; // 收到话题/文本到首帧 TTS
+
+    int64_t now_us = 0;
+    bool ai_started = false;
+    std::string start_topic;
+    std::vector<std::string> user_turns;
+
+    void StartAi(const std::string& topic) {
+        now_us += kStartAiUs;
+        ai_started = true;
+        start_topic = topic;
+        user_turns.clear();
+    }
+    void StopAi() {
+        now_us += kStopAiUs;
+        ai_started = false;
+    }
+    void Prompt(const std::string& text) {
+        now_us += kPromptUs;
+        user_turns.push_back(text);
+    }
+};
+
+struct OpenResult {
+    int64_t open_us;         // OpenAudioChannel 阻塞时间
+    int64_t first_audio_us;  // 唤醒到首帧下行音频，没有唤醒词时为 -1
+};
+
+// 与 NeRtcProtocol::OpenAudioChannel 相同的分支
+static OpenResult Open(StandInEngine& engine, const std::string& wake_word, bool wake_word_as_prompt) {
+    int64_t start = engine.now_us;
+    auto path = ChooseNeRtcOpenPath(engine.ai_started, !wake_word.empty(), wake_word_as_prompt);
+    switch (path) {
+    case kNeRtcOpenWarm:
+        break;
+    case kNeRtcOpenWarmPrompt:
+        engine.Prompt(wake_word);
+        break;
+    case kNeRtcOpenRestart:
+        engine.StopAi();
+        engine.StartAi(wake_word);
+        break;
+    case kNeRtcOpenCold:
+        engine.StartAi(wake_word);
+        break;
+    }
+    int64_t open_us = engine.now_us - start;
+    int64_t first_audio_us = wake_word.empty() ? -1 : open_us + StandInEngine::kFirstResponseUs;
+    return {open_us, first_audio_us};
+}
+
+static void TestStartTopicSemantics() {
+    // 冷启动：唤醒词作为开场话题
+    StandInEngine cold;
+    Open(cold, "你好小智", false);
+    CHECK(cold.start_topic == "你好小智" && cold.user_turns.empty());
+
+    // 预热 + 默认配置：重启后与冷启动语义一致
+    StandInEngine restart;
+    restart.StartAi("");
+    Open(restart, "你好小智", false);
+    CHECK(restart.ai_started);
+    CHECK(restart.start_topic == cold.start_topic && restart.user_turns == cold.user_turns);
+
+    // 预热 + NERTC_WARM_WAKE_WORD_AS_PROMPT：唤醒词变成一轮用户输入（记录的行为变化）
+    StandInEngine prompt;
+    prompt.StartAi("");
+    Open(prompt, "你好小智", true);
+    CHECK(prompt.start_topic.empty());
+    CHECK(prompt.user_turns.size() == 1 && prompt.user_turns[0] == "你好小智");
+
+    // 预热且没有唤醒词（按键唤醒）：不触碰 AI 会话
+    StandInEngine warm;
+    warm.StartAi("topic");
+    int64_t before = warm.now_us;
+    Open(warm, "", false);
+    CHECK(warm.now_us == before && warm.start_topic == "topic");
+}
+
+static void BenchmarkOpenPaths() {
+    struct Case {
+        const char* name;
+        bool warm;
+        const char* wake_word;
+        bool wake_word_as_prompt;
+    } cases[] = {
+        {"cold, wake word", false, "你好小智", false},
+        {"cold, button", false, "", false},
+        {"warm, button", true, "", false},
+        {"warm, wake word, restart (default)", true, "你好小智", false},
+        {"warm, wake word, as prompt", true, "你好小智", true},
+    };
+    OpenResult results[sizeof(cases) / sizeof(cases[0])];
+    printf("stand-in open paths (virtual clock):\n");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        StandInEngine engine;
+        if (cases[i].warm) {
+            engine.StartAi("");
+        }
+        results[i] = Open(engine, cases[i].wake_word, cases[i].wake_word_as_prompt);
+        if (results[i].first_audio_us < 0) {
+            printf("  %-36s open %4lld ms\n", cases[i].name, (long long)results[i].open_us / 1000);
+        } else {
+            printf("  %-36s open %4lld ms, first audio %4lld ms\n", cases[i].name,
+                (long long)results[i].open_us / 1000, (long long)results[i].first_audio_us / 1000);
+        }
+    }
+    // 预热只对按键唤醒和文本请求模式省时；默认的重启路径比冷启动多一次 stop_ai
+    CHECK(results[2].open_us < results[1].open_us);
+    CHECK(results[3].first_audio_us == results[0].first_audio_us + StandInEngine::kStopAiUs);
+    CHECK(results[4].first_audio_us < results[0].first_audio_us);
+}
+
+int main() {
+    TestChoosePath();
+    TestStartTopicSemantics();
+    BenchmarkOpenPaths();
+    printf("nertc_open_path_test passed\n");
+    return 0;
+}
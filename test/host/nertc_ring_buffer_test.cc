@@ -0,0 +1,180 @@
+#include "nertc_ring_buffer.h"
+#include "host_test.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static char StreamByte(size_t position) {
+    return (char)((position * 131 + (position >> 8)) & 0xFF);
+}
+
+static void TestByteWraparound() {
+    ByteRingBuffer ring(8);
+    char buffer[16];
+    CHECK(ring.empty() && ring.free_space() == 8);
+    CHECK(ring.Read(buffer, sizeof(buffer)) == 0);
+
+    CHECK(ring.Write("abcdef", 6) == 6);
+    CHECK(ring.Read(buffer, 4) == 4 && memcmp(buffer, "abcd", 4) == 0);
+    // 尾部跨越缓冲末尾
+    CHECK(ring.Write("ghijkl", 6) == 6);
+    CHECK(ring.size() == 8 && ring.free_space() == 0);
+    // 满时不写入
+    CHECK(ring.Write("x", 1) == 0);
+    CHECK(ring.Read(buffer, sizeof(buffer)) == 8 && memcmp(buffer, "efghijkl", 8) == 0);
+    CHECK(ring.empty());
+
+    // 扩容时整理跨越末尾的数据
+    CHECK(ring.Write("0123456", 7) == 7);
+    CHECK(ring.Read(buffer, 5) == 5);
+    CHECK(ring.Write("789abc", 6) == 6);
+    CHECK(ring.WriteAll("defghijk", 8, 32));
+    CHECK(ring.capacity() == 16 && ring.grow_count() == 1);
+    CHECK(ring.Read(buffer, sizeof(buffer)) == 16 && memcmp(buffer, "56789abcdefghijk", 16) == 0);
+
+    // 超过上限不写入任何字节
+    std::string large(40, 'z');
+    CHECK(!ring.WriteAll(large.data(), large.size(), 32));
+    CHECK(ring.empty() && ring.capacity() == 16);
+    CHECK(ring.WriteAll(large.data(), 32, 32));
+    CHECK(ring.capacity() == 32 && ring.free_space() == 0);
+    ring.Clear();
+    CHECK(ring.empty() && ring.free_space() == 32);
+}
+
+static void TestDatagrams() {
+    DatagramRingBuffer queue(4);
+    char buffer[8];
+    CHECK(queue.Pop(buffer, sizeof(buffer)) == -1);
+    for (int i = 0; i < 6; i++) {
+        std::string datagram = "d" + std::to_string(i);
+        queue.Push(datagram.data(), datagram.size());
+    }
+    // 槽位满时丢弃最旧的
+    CHECK(queue.size() == 4 && queue.dropped() == 2);
+    CHECK(queue.Pop(buffer, sizeof(buffer)) == 2 && memcmp(buffer, "d2", 2) == 0);
+
+    // 缓冲不足时截断并计数，数据报整体出队
+    queue.Push("0123456789", 10);
+    CHECK(queue.Pop(buffer, sizeof(buffer)) == 2 && memcmp(buffer, "d3", 2) == 0);
+    CHECK(queue.Pop(buffer, sizeof(buffer)) == 2);
+    CHECK(queue.Pop(buffer, sizeof(buffer)) == 2);
+    CHECK(queue.Pop(buffer, 4) == 4 && memcmp(buffer, "0123", 4) == 0);
+    CHECK(queue.truncated() == 1);
+    CHECK(queue.empty() && queue.Pop(buffer, sizeof(buffer)) == -1);
+
+    // 槽位复用后数据不受之前更长内容影响
+    queue.Push("", 0);
+    queue.Push("ab", 2);
+    CHECK(queue.Pop(buffer, sizeof(buffer)) == 0);
+    CHECK(queue.Pop(buffer, sizeof(buffer)) == 2 && memcmp(buffer, "ab", 2) == 0);
+}
+
+// 与 NeRtcExternalNetwork 的 TCP 连接相同的收发逻辑：传输层回调只写缓冲不阻塞，SDK 线程分段读取
+struct FakeTcpConnection {
+    std::mutex mutex;
+    std::condition_variable cv;
+    ByteRingBuffer recv_buffer;
+    size_t max_size;
+    bool closed = false;
+    bool failed = false;
+    size_t dropped_bytes = 0;
+
+    FakeTcpConnection(size_t size, size_t max) : recv_buffer(size), max_size(max) {}
+
+    void OnStream(const std::string& data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (failed || closed) {
+            dropped_bytes += data.size();
+            return;
+        }
+        if (!recv_buffer.WriteAll(data.data(), data.size(), max_size)) {
+            dropped_bytes += data.size();
+            failed = true;
+        }
+        cv.notify_one();
+    }
+
+    int Recv(char* buffer, size_t buffer_size) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return !recv_buffer.empty() || closed || failed; });
+        if (failed) {
+            return -1;
+        }
+        return (int)recv_buffer.Read(buffer, buffer_size);
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        cv.notify_all();
+    }
+};
+
+// 随机大小的分段写入、随机大小的部分读取，读出的字节流必须完整且有序
+static void TestFakeTransportStream() {
+    const size_t total = 2 * 1024 * 1024;
+    FakeTcpConnection connection(4096, 2 * total);
+    std::thread transport([&connection, total]() {
+        std::mt19937 rng(7);
+        size_t position = 0;
+        while (position < total) {
+            size_t length = std::min<size_t>(1 + rng() % 3000, total - position);
+            std::string chunk(length, '\0');
+            for (size_t i = 0; i < length; i++) {
+                chunk[i] = StreamByte(position + i);
+            }
+            connection.OnStream(chunk);
+            position += length;
+        }
+        connection.Close();
+    });
+
+    std::mt19937 rng(11);
+    std::vector<char> buffer(2048);
+    size_t received = 0;
+    while (true) {
+        int read = connection.Recv(buffer.data(), 1 + rng() % buffer.size());
+        CHECK(read >= 0);
+        if (read == 0) {
+            break;
+        }
+        for (int i = 0; i < read; i++) {
+            CHECK(buffer[i] == StreamByte(received + i));
+        }
+        received += read;
+    }
+    transport.join();
+    CHECK(received == total);
+    CHECK(!connection.failed && connection.dropped_bytes == 0);
+}
+
+// 读取方停止读取时回调不阻塞：先扩容到上限，然后丢弃并让 recv 返回错误
+static void TestFakeTransportOverflow() {
+    FakeTcpConnection connection(1024, 4096);
+    std::string chunk(1000, 'x');
+    for (int i = 0; i < 4; i++) {
+        connection.OnStream(chunk);
+    }
+    CHECK(!connection.failed);
+    CHECK(connection.recv_buffer.capacity() == 4096 && connection.recv_buffer.grow_count() == 2);
+    connection.OnStream(chunk);
+    CHECK(connection.failed && connection.dropped_bytes == 1000);
+    connection.OnStream(chunk);
+    CHECK(connection.dropped_bytes == 2000);
+    char buffer[16];
+    CHECK(connection.Recv(buffer, sizeof(buffer)) == -1);
+}
+
+int main() {
+    TestByteWraparound();
+    TestDatagrams();
+    TestFakeTransportStream();
+    TestFakeTransportOverflow();
+    printf("nertc_ring_buffer_test passed\n");
+    return 0;
+}
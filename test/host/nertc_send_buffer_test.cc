@@ -0,0 +1,216 @@
+#include "nertc_send_buffer.h"
+#include "host_test.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// 与 esp-ml307 的 Tcp/Udp 一样只接受 const std::string& 的发送端，底下是回环 socket
+class LoopbackSender {
+public:
+    explicit LoopbackSender(int fd) : fd_(fd) {}
+    int Send(const std::string& data) { return (int)send(fd_, data.data(), data.size(), 0); }
+
+private:
+    int fd_;
+};
+
+// 设备上 SDK 交给 SendTcp/SendUdp 的连接状态：发送锁 + 复用的发送缓冲
+struct Connection {
+    LoopbackSender* sender = nullptr;
+    std::mutex send_mutex;
+    std::string send_buffer;
+};
+
+static std::atomic<uint32_t> g_tx_allocations{0};
+
+static int SendReused(Connection& connection, const char* data, size_t length) {
+    std::lock_guard<std::mutex> lock(connection.send_mutex);
+    FillSendBuffer(connection.send_buffer, data, length, g_tx_allocations);
+    return connection.sender->Send(connection.send_buffer);
+}
+
+// 改动前的写法：每包临时构造一个 string
+static int SendTemporary(Connection& connection, const char* data, size_t length) {
+    std::lock_guard<std::mutex> lock(connection.send_mutex);
+    return connection.sender->Send(std::string(data, length));
+}
+
+static void TestFillSendBuffer() {
+    std::atomic<uint32_t> allocations{0};
+    std::string buffer;
+    std::string payload(300, 'a');
+    FillSendBuffer(buffer, payload.data(), 100, allocations);
+    CHECK(allocations == 1 && buffer == payload.substr(0, 100));
+    FillSendBuffer(buffer, payload.data(), 50, allocations);
+    CHECK(allocations == 1 && buffer.size() == 50);
+    FillSendBuffer(buffer, payload.data(), 100, allocations);
+    CHECK(allocations == 1);
+    FillSendBuffer(buffer, payload.data(), 300, allocations);
+    CHECK(allocations == 2 && buffer == payload);
+    FillSendBuffer(buffer, payload.data(), 0, allocations);
+    CHECK(allocations == 2 && buffer.empty());
+}
+
+static void MakeUdpPair(int& tx, int& rx) {
+    rx = socket(AF_INET, SOCK_DGRAM, 0);
+    tx = socket(AF_INET, SOCK_DGRAM, 0);
+    CHECK(rx >= 0 && tx >= 0);
+    int size = 4 * 1024 * 1024;
+    setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(bind(rx, (sockaddr*)&addr, sizeof(addr)) == 0);
+    socklen_t len = sizeof(addr);
+    CHECK(getsockname(rx, (sockaddr*)&addr, &len) == 0);
+    CHECK(connect(tx, (sockaddr*)&addr, sizeof(addr)) == 0);
+}
+
+static void MakeTcpPair(int& tx, int& rx) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(listener >= 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(bind(listener, (sockaddr*)&addr, sizeof(addr)) == 0);
+    CHECK(listen(listener, 1) == 0);
+    socklen_t len = sizeof(addr);
+    CHECK(getsockname(listener, (sockaddr*)&addr, &len) == 0);
+    tx = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(connect(tx, (sockaddr*)&addr, sizeof(addr)) == 0);
+    rx = accept(listener, nullptr, nullptr);
+    CHECK(rx >= 0);
+    close(listener);
+    int one = 1;
+    setsockopt(tx, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static std::vector<char> MakePacket(size_t size, int seed) {
+    std::vector<char> packet(size);
+    for (size_t i = 0; i < size; i++) {
+        packet[i] = (char)(i * 7 + seed);
+    }
+    return packet;
+}
+
+// 回环 UDP 上收到的数据报与发出的逐字节一致，包长变化时缓冲不残留旧数据
+static void TestUdpLoopbackContent() {
+    int tx, rx;
+    MakeUdpPair(tx, rx);
+    LoopbackSender sender(tx);
+    Connection connection;
+    connection.sender = &sender;
+    const size_t sizes[] = {200, 20, 1200, 1, 600};
+    char received[2048];
+    for (size_t size : sizes) {
+        auto packet = MakePacket(size, (int)size);
+        CHECK(SendReused(connection, packet.data(), packet.size()) == (int)size);
+        CHECK(recv(rx, received, sizeof(received), 0) == (ssize_t)size);
+        CHECK(memcmp(received, packet.data(), size) == 0);
+    }
+    close(tx);
+    close(rx);
+}
+
+// 回环 TCP 上多包拼接后的字节流与发出的一致
+static void TestTcpLoopbackContent() {
+    int tx, rx;
+    MakeTcpPair(tx, rx);
+    LoopbackSender sender(tx);
+    Connection connection;
+    connection.sender = &sender;
+    std::string expected;
+    for (int i = 0; i < 50; i++) {
+        auto packet = MakePacket(100 + i * 37, i);
+        CHECK(SendReused(connection, packet.data(), packet.size()) == (int)packet.size());
+        expected.append(packet.data(), packet.size());
+    }
+    shutdown(tx, SHUT_WR);
+    std::string received;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(rx, buffer, sizeof(buffer), 0)) > 0) {
+        received.append(buffer, n);
+    }
+    CHECK(received == expected);
+    close(tx);
+    close(rx);
+}
+
+// 只打印结果，不做断言；包长取 SDK 音视频包的典型值
+template <typename SendFunction>
+static void RunUdpBenchmark(const char* name, size_t packet_size, int packets, SendFunction send_function) {
+    int tx, rx;
+    MakeUdpPair(tx, rx);
+    LoopbackSender sender(tx);
+    Connection connection;
+    connection.sender = &sender;
+    auto packet = MakePacket(packet_size, 1);
+
+    std::atomic<bool> done{false};
+    std::thread reader([&]() {
+        char buffer[2048];
+        while (!done) {
+            recv(rx, buffer, sizeof(buffer), MSG_DONTWAIT);
+        }
+    });
+
+    size_t before = g_allocations;
+    int64_t start = HostTimeUs();
+    for (int i = 0; i < packets; i++) {
+        send_function(connection, packet.data(), packet.size());
+    }
+    int64_t elapsed_us = HostTimeUs() - start;
+    size_t allocations = g_allocations - before;
+    done = true;
+    reader.join();
+    close(tx);
+    close(rx);
+
+    printf("udp loopback %-9s %4zu B x %d: %.2f us/packet, %.2f MB/s, %zu allocations\n", name, packet_size,
+        packets, elapsed_us / (double)packets, packet_size * (double)packets / elapsed_us, allocations);
+}
+
+static void Benchmark() {
+    const int kPackets = 20000;
+    for (size_t size : {160, 1200}) {
+        RunUdpBenchmark("temporary", size, kPackets, SendTemporary);
+        RunUdpBenchmark("reused", size, kPackets, SendReused);
+    }
+}
+
+int main() {
+    TestFillSendBuffer();
+    TestUdpLoopbackContent();
+    TestTcpLoopbackContent();
+    Benchmark();
+    printf("nertc_send_buffer_test passed\n");
+    return 0;
+}
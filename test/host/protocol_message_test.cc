@@ -0,0 +1,283 @@
+#include "protocol.h"
+#include "cjson_arena.h"
+#include "image_content.h"
+#include "host_test.h"
+
+#include <cJSON.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 只实现纯虚接口，入站消息走与 WebSocket / MQTT 相同的 DispatchIncomingMessage(JsonReader)
+class FakeProtocol : public Protocol {
+public:
+    bool Start() override { return true; }
+    bool OpenAudioChannel(const std::string& wake_word) override { return true; }
+    void CloseAudioChannel() override {}
+    bool IsAudioChannelOpened() const override { return true; }
+    bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override { return true; }
+
+    using Protocol::DispatchIncomingMessage;
+    void set_session_id(const std::string& session_id) { session_id_ = session_id; }
+
+    // 最近一次发出的文本及其缓冲地址，用于确认发送路径没有换缓冲
+    std::string sent_text;
+    const char* sent_data = nullptr;
+
+protected:
+    bool SendText(const std::string& text) override {
+        sent_text = text;
+        sent_data = text.data();
+        return true;
+    }
+};
+
+// 分发回调期间的字符串只在回调内有效，这里拷贝出来比较
+struct Received {
+    IncomingMessageType type = kIncomingMessageUnknown;
+    std::string type_name;
+    std::string state, text, emotion, command, status, message;
+    std::string payload;  // PrintUnformatted 结果，没有 payload 为空
+    int json_parses = -1;
+    int count = 0;
+};
+
+static std::string Copy(const char* value) {
+    return value != nullptr ? value : "<null>";
+}
+
+static void Capture(const IncomingMessage& message, Received& received) {
+    received.type = message.type;
+    received.type_name = message.type_name;
+    received.state = Copy(message.state);
+    received.text = Copy(message.text);
+    received.emotion = Copy(message.emotion);
+    received.command = Copy(message.command);
+    received.status = Copy(message.status);
+    received.message = Copy(message.message);
+    if (message.payload != nullptr) {
+        char* printed = cJSON_PrintUnformatted(message.payload);
+        received.payload = printed;
+        cJSON_free(printed);
+    }
+    received.json_parses = message.json_parses;
+    received.count++;
+}
+
+struct RecordedMessage {
+    const char* json;
+    IncomingMessageType type;
+    const char* field;     // 该类型的主要字段名
+    const char* expected;  // 主要字段的值
+};
+
+// 录制的服务端消息，每种类型至少一条
+static const RecordedMessage kCorpus[] = {
+    {R"({"type":"tts","state":"start","sample_rate":24000,"session_id":"e1a2f3"})", kIncomingMessageTts, "state", "start"},
+    {R"({"type":"tts","state":"sentence_start","text":"你好，\"小智\"\n😀","session_id":"e1a2f3"})", kIncomingMessageTts, "text", "你好，\"小智\"\n😀"},
+    {R"({"type":"tts","state":"stop","session_id":"e1a2f3"})", kIncomingMessageTts, "state", "stop"},
+    {R"({"type":"stt","text":"今天天气怎么样","session_id":"e1a2f3"})", kIncomingMessageStt, "text", "今天天气怎么样"},
+    {R"({"type":"llm","text":"😊","emotion":"happy","session_id":"e1a2f3"})", kIncomingMessageLlm, "emotion", "happy"},
+    {R"({"session_id":"e1a2f3","type":"mcp","payload":{"jsonrpc":"2.0","method":"tools/call","params":{"name":"self.audio_speaker.set_volume","arguments":{"volume":50}},"id":3}})", kIncomingMessageMcp, nullptr, nullptr},
+    {R"({"type":"mcp","payload":{"jsonrpc":"2.0","method":"tools/list","params":{"cursor":"a\"}b"},"id":1}})", kIncomingMessageMcp, nullptr, nullptr},
+    {" { \"type\" : \"system\" , \"command\" : \"reboot\" } ", kIncomingMessageSystem, "command", "reboot"},
+    {R"({"type":"alert","status":"error","message":"a\\b\/c\tz","emotion":"sad"})", kIncomingMessageAlert, "message", "a\\b/c\tz"},
+    {R"({"type":"custom","payload":{"action":"blink","times":[1,2,3]}})", kIncomingMessageCustom, nullptr, nullptr},
+    {R"({"type":"goodbye","session_id":"e1a2f3"})", kIncomingMessageUnknown, nullptr, nullptr},
+    {R"({"type":"hello","transport":"websocket","audio_params":{"sample_rate":24000}})", kIncomingMessageUnknown, nullptr, nullptr},
+};
+
+static const std::string& Field(const Received& received, const char* name) {
+    if (strcmp(name, "state") == 0) return received.state;
+    if (strcmp(name, "text") == 0) return received.text;
+    if (strcmp(name, "emotion") == 0) return received.emotion;
+    if (strcmp(name, "command") == 0) return received.command;
+    return received.message;
+}
+
+static bool HasPayload(IncomingMessageType type) {
+    return type == kIncomingMessageMcp || type == kIncomingMessageCustom;
+}
+
+// cJSON 分配计数，用来确认 json_parses 与实际的解析次数一致
+static size_t cjson_allocations = 0;
+
+static void* CountingMalloc(size_t size) {
+    cjson_allocations++;
+    return malloc(size);
+}
+
+// 原地解析路径（WebSocket / MQTT）：只有 mcp / custom 的 payload 经过一次 cJSON_Parse，其他消息不触碰 cJSON
+static Received DispatchWithReader(FakeProtocol& protocol, const char* json, size_t& allocations) {
+    Received received;
+    protocol.OnIncomingMessage([&received](const IncomingMessage& message) {
+        Capture(message, received);
+    });
+    std::string buffer = json;
+    JsonReader reader(buffer.data(), buffer.size());
+    CHECK(reader.Parse());
+    size_t before = cjson_allocations;
+    protocol.DispatchIncomingMessage(reader);
+    allocations = cjson_allocations - before;
+    return received;
+}
+
+// cJSON 路径（与 Application 的 OnIncomingJson 相同）：整条消息解析一次
+static Received DispatchWithCJson(const char* json) {
+    Received received;
+    cJSON* root = cJSON_Parse(json);
+    CHECK(root != nullptr);
+    IncomingMessage message;
+    message.json_parses = 1;
+    if (Protocol::ParseIncomingMessage(root, message)) {
+        Capture(message, received);
+    }
+    cJSON_Delete(root);
+    return received;
+}
+
+static void TestCorpus() {
+    FakeProtocol protocol;
+    for (auto& recorded : kCorpus) {
+        size_t allocations = 0;
+        Received reader = DispatchWithReader(protocol, recorded.json, allocations);
+        Received cjson = DispatchWithCJson(recorded.json);
+
+        CHECK(reader.count == 1 && cjson.count == 1);
+        CHECK(reader.type == recorded.type && cjson.type == recorded.type);
+        CHECK(reader.type_name == cjson.type_name);
+        if (recorded.field != nullptr) {
+            CHECK(Field(reader, recorded.field) == recorded.expected);
+        }
+        // 两条路径得到的字段完全一致
+        CHECK(reader.state == cjson.state && reader.text == cjson.text && reader.emotion == cjson.emotion);
+        CHECK(reader.command == cjson.command && reader.status == cjson.status && reader.message == cjson.message);
+        CHECK(reader.payload == cjson.payload);
+
+        CHECK(cjson.json_parses == 1);
+        if (HasPayload(recorded.type)) {
+            CHECK(!reader.payload.empty());
+            CHECK(reader.json_parses == 1 && allocations > 0);
+        } else {
+            CHECK(reader.payload.empty());
+            CHECK(reader.json_parses == 0 && allocations == 0);
+        }
+    }
+
+    // 分发前填写接收时间
+    Received received;
+    protocol.OnIncomingMessage([&received](const IncomingMessage& message) {
+        CHECK(message.received_time_us > 0);
+        Capture(message, received);
+    });
+    IncomingMessage direct;
+    direct.type = kIncomingMessageTts;
+    direct.state = "stop";
+    direct.json_parses = 1;
+    protocol.DispatchIncomingMessage(direct);
+    CHECK(received.count == 1 && received.state == "stop" && received.json_parses == 1);
+}
+
+static void TestAlertFields() {
+    FakeProtocol protocol;
+    size_t allocations = 0;
+    Received alert = DispatchWithReader(protocol, kCorpus[8].json, allocations);
+    CHECK(alert.status == "error" && alert.emotion == "sad");
+    Received tts = DispatchWithReader(protocol, kCorpus[1].json, allocations);
+    CHECK(tts.state == "sentence_start");
+    Received llm = DispatchWithReader(protocol, kCorpus[4].json, allocations);
+    CHECK(llm.text == "<null>");
+}
+
+static void TestInvalidMessages() {
+    FakeProtocol protocol;
+    const char* const invalid[] = {
+        R"({"session_id":"e1a2f3"})",
+        R"({"type":3})",
+        R"({"type":null,"state":"start"})",
+    };
+    for (auto json : invalid) {
+        size_t allocations = 0;
+        Received reader = DispatchWithReader(protocol, json, allocations);
+        CHECK(reader.count == 0 && allocations == 0);
+        Received cjson = DispatchWithCJson(json);
+        CHECK(cjson.count == 0);
+    }
+
+    // mcp 的 payload 不是对象时不解析
+    size_t allocations = 0;
+    Received mcp = DispatchWithReader(protocol, R"({"type":"mcp","payload":"text"})", allocations);
+    CHECK(mcp.count == 1 && mcp.type == kIncomingMessageMcp && mcp.payload.empty());
+    CHECK(mcp.json_parses == 0 && allocations == 0);
+}
+
+// 启用竞技场后 payload 树在竞技场中分配，每条消息一个作用域
+static void TestArenaDispatch() {
+    CJsonArena::Initialize();
+    auto before = CJsonArena::GetStatistics();
+    FakeProtocol protocol;
+    for (auto& recorded : kCorpus) {
+        size_t allocations = 0;
+        Received received = DispatchWithReader(protocol, recorded.json, allocations);
+        CHECK(received.type == recorded.type);
+    }
+    auto after = CJsonArena::GetStatistics();
+    CHECK(after.scopes - before.scopes == sizeof(kCorpus) / sizeof(kCorpus[0]));
+    CHECK(after.arena_allocations > before.arena_allocations);
+    CHECK(after.heap_fallbacks == before.heap_fallbacks);
+}
+
+// 按 McpServer 图片回复的方式拼装：JSON-RPC 包头、结果、收尾都在同一个缓冲里，
+// Protocol::SendMcpMessage 原地插入会话包头，发出的文本仍是这个缓冲
+static void TestMcpImageReplyInPlace() {
+    std::string image(200 * 1024, '\0');
+    for (size_t i = 0; i < image.size(); i++) {
+        image[i] = (char)(i * 31 + (i >> 9));
+    }
+    ImageContent content("image/jpeg", image);
+    std::string expected_image = content.to_json();
+
+    FakeProtocol protocol;
+    protocol.set_session_id("0b6e3f1c-8d2a-4c55-9a41-2f7d0e6b9c13");
+    std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":";
+    payload.reserve(payload.size() + content.json_string_size() + 192);
+    payload += "{\"content\":[{\"type\":\"image\",\"image\":\"";
+    content.AppendAsJsonString(payload);
+    payload += "\"}],\"isError\":false}";
+    payload += "}";
+    const char* buffer = payload.data();
+
+    protocol.SendMcpMessage(std::move(payload));
+    CHECK(protocol.sent_data == buffer);
+
+    cJSON* root = cJSON_Parse(protocol.sent_text.c_str());
+    CHECK(root != nullptr);
+    CHECK(strcmp(cJSON_GetObjectItem(root, "session_id")->valuestring, "0b6e3f1c-8d2a-4c55-9a41-2f7d0e6b9c13") == 0);
+    CHECK(strcmp(cJSON_GetObjectItem(root, "type")->valuestring, "mcp") == 0);
+    cJSON* rpc = cJSON_GetObjectItem(root, "payload");
+    CHECK(cJSON_GetObjectItem(rpc, "id")->valueint == 7);
+    cJSON* result = cJSON_GetObjectItem(rpc, "result");
+    CHECK(cJSON_IsFalse(cJSON_GetObjectItem(result, "isError")));
+    cJSON* item = cJSON_GetArrayItem(cJSON_GetObjectItem(result, "content"), 0);
+    CHECK(strcmp(cJSON_GetObjectItem(item, "type")->valuestring, "image") == 0);
+    CHECK(cJSON_GetObjectItem(item, "image")->valuestring == expected_image);
+    cJSON_Delete(root);
+
+    // 没有预留容量时结果相同，只是多一次扩容
+    protocol.SendMcpMessage("{\"jsonrpc\":\"2.0\",\"id\":8,\"result\":{}}");
+    CHECK(protocol.sent_text == "{\"session_id\":\"0b6e3f1c-8d2a-4c55-9a41-2f7d0e6b9c13\",\"type\":\"mcp\","
+        "\"payload\":{\"jsonrpc\":\"2.0\",\"id\":8,\"result\":{}}}");
+}
+
+int main() {
+    cJSON_Hooks hooks = {CountingMalloc, free};
+    cJSON_InitHooks(&hooks);
+
+    TestCorpus();
+    TestAlertFields();
+    TestInvalidMessages();
+    TestArenaDispatch();
+    TestMcpImageReplyInPlace();
+    printf("protocol_message_test passed\n");
+    return 0;
+}
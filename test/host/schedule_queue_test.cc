@@ -0,0 +1,296 @@
+#include "schedule_queue.h"
+#include "host_test.h"
+
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+// 统计当前线程的堆分配次数，用于确认 ISR 投递路径不分配内存
+static thread_local int thread_allocations = 0;
+
+void* operator new(size_t size) {
+    thread_allocations++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static void TestInlineAndHeap() {
+    int calls = 0;
+    ScheduledTask small([&calls]() { calls++; });
+    CHECK(small && !small.heap_allocated());
+
+    auto shared = std::make_shared<int>(7);
+    std::array<char, ScheduledTask::kInlineSize + 8> padding {};
+    ScheduledTask large([&calls, shared, padding]() { calls += *shared + padding[0]; });
+    CHECK(large && large.heap_allocated());
+    CHECK(shared.use_count() == 2);
+
+    // 移动后源对象为空，闭包只执行、只析构一次
+    ScheduledTask moved(std::move(large));
+    CHECK(!large && moved.heap_allocated());
+    small();
+    moved();
+    CHECK(calls == 8);
+    moved.Reset();
+    CHECK(!moved && shared.use_count() == 1);
+
+    ScheduledTask assigned;
+    assigned = ScheduledTask([shared]() {});
+    CHECK(!assigned.heap_allocated() && shared.use_count() == 2);
+    assigned = ScheduledTask([&calls]() { calls++; });
+    CHECK(shared.use_count() == 1);
+}
+
+static void TestFull() {
+    MpscRingQueue<ScheduledTask, 4> queue;
+    int calls = 0;
+    for (int i = 0; i < 4; i++) {
+        ScheduledTask task([&calls, i]() { CHECK(calls == i); calls++; });
+        CHECK(queue.TryPush(task));
+        CHECK(!task);
+    }
+    // 队列满时不移走 item
+    ScheduledTask rejected([&calls]() { calls = 100; });
+    CHECK(!queue.TryPush(rejected));
+    CHECK(rejected);
+    CHECK(queue.size() == 4);
+
+    ScheduledTask task;
+    for (int i = 0; i < 4; i++) {
+        CHECK(queue.TryPop(task));
+        task();
+    }
+    CHECK(!queue.TryPop(task));
+    CHECK(calls == 4);
+    CHECK(queue.TryPush(rejected));
+    CHECK(queue.TryPop(task));
+    task();
+    CHECK(calls == 100);
+}
+
+// 多生产者并发入队，单消费者检查每个生产者内部保持 FIFO 且没有丢失或重复
+static void TestConcurrentProducers() {
+    const int producers = 6;
+    const int per_producer = 20000;
+    MpscRingQueue<ScheduledTask, 32> queue;
+    std::vector<int> last(producers, -1);
+    long long sum = 0;
+    long long popped = 0;
+    std::atomic<int> done {0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < per_producer; i++) {
+                ScheduledTask task;
+                if (i % 2) {
+                    task = ScheduledTask([&, p, i]() {
+                        CHECK(last[p] < i);
+                        last[p] = i;
+                        sum += i;
+                    });
+                } else {
+                    auto value = std::make_shared<int>(i);
+                    task = ScheduledTask([&, p, i, value, padding = std::array<char, 40> {}]() {
+                        CHECK(last[p] < i);
+                        last[p] = i;
+                        sum += *value + padding[0];
+                    });
+                }
+                while (!queue.TryPush(task)) {
+                    std::this_thread::yield();
+                }
+            }
+            done++;
+        });
+    }
+
+    ScheduledTask task;
+    while (done < producers || queue.size() > 0) {
+        if (queue.TryPop(task)) {
+            task();
+            task.Reset();
+            popped++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(!queue.TryPop(task));
+    CHECK(popped == (long long)producers * per_producer);
+    CHECK(sum == (long long)producers * per_producer * (per_producer - 1) / 2);
+    for (int p = 0; p < producers; p++) {
+        CHECK(last[p] == per_producer - 1);
+    }
+}
+
+// 高优先级任务越过已排队的普通任务，各通道内部保持投递顺序
+static void TestLanePriority() {
+    ScheduleLanes<8> lanes;
+    std::vector<int> order;
+    lanes.Push(ScheduledTask([&order]() { order.push_back(1); }), kSchedulePriorityNormal);
+    lanes.Push(ScheduledTask([&order]() { order.push_back(2); }), kSchedulePriorityNormal);
+    lanes.Push(ScheduledTask([&order]() { order.push_back(10); }), kSchedulePriorityHigh);
+    lanes.Push(ScheduledTask([&order]() { order.push_back(11); }), kSchedulePriorityHigh);
+    CHECK(!lanes.RunPending());
+    CHECK((order == std::vector<int> {10, 11, 1, 2}));
+
+    // 普通任务执行期间投递的高优先级任务在下一个普通任务之前执行
+    order.clear();
+    lanes.Push(ScheduledTask([&]() {
+        order.push_back(1);
+        lanes.Push(ScheduledTask([&order]() { order.push_back(10); }), kSchedulePriorityHigh);
+    }), kSchedulePriorityNormal);
+    lanes.Push(ScheduledTask([&order]() { order.push_back(2); }), kSchedulePriorityNormal);
+    CHECK(!lanes.RunPending());
+    CHECK((order == std::vector<int> {1, 10, 2}));
+
+    CHECK(lanes.statistics(kSchedulePriorityHigh).count == 3);
+    CHECK(lanes.statistics(kSchedulePriorityNormal).count == 4);
+}
+
+// 普通任务只执行进入时已排队的数量，执行期间新投递的留到下一轮
+static void TestNormalBudget() {
+    ScheduleLanes<8> lanes;
+    std::vector<int> order;
+    lanes.Push(ScheduledTask([&]() {
+        order.push_back(1);
+        lanes.Push(ScheduledTask([&order]() { order.push_back(3); }), kSchedulePriorityNormal);
+    }), kSchedulePriorityNormal);
+    lanes.Push(ScheduledTask([&order]() { order.push_back(2); }), kSchedulePriorityNormal);
+    CHECK(lanes.RunPending());
+    CHECK((order == std::vector<int> {1, 2}));
+    CHECK(!lanes.RunPending());
+    CHECK((order == std::vector<int> {1, 2, 3}));
+}
+
+// 环形队列满后进入溢出队列，顺序不变；溢出期间 ISR 投递失败，保证不越过溢出队列中的任务
+static void TestOverflowOrder() {
+    ScheduleLanes<4> lanes;
+    std::vector<int> order;
+    for (int i = 0; i < 10; i++) {
+        lanes.Push(ScheduledTask([&order, i]() { order.push_back(i); }), kSchedulePriorityNormal);
+    }
+    CHECK(lanes.overflows() == 6);
+    ScheduledTask isr_task([&order]() { order.push_back(100); });
+    CHECK(!lanes.PushFromISR(isr_task, kSchedulePriorityNormal));
+    CHECK(isr_task);
+    CHECK(lanes.isr_drops() == 1);
+    // 高优先级通道不受普通通道溢出影响
+    CHECK(lanes.PushFromISR(isr_task, kSchedulePriorityHigh));
+    CHECK(!isr_task);
+
+    CHECK(!lanes.RunPending());
+    CHECK(order.size() == 11);
+    CHECK(order[0] == 100);
+    for (int i = 0; i < 10; i++) {
+        CHECK(order[i + 1] == i);
+    }
+    CHECK(lanes.statistics(kSchedulePriorityNormal).max_depth >= 4);
+}
+
+// ISR 投递：不分配内存，堆上的闭包被拒绝，通道满时失败且不移走任务
+static void TestPushFromISR() {
+    ScheduleLanes<4> lanes;
+    int calls = 0;
+    int sum = 0;
+    for (int i = 0; i < 4; i++) {
+        ScheduledTask task([&sum, i]() { sum += i; });
+        thread_allocations = 0;
+        CHECK(lanes.PushFromISR(task, kSchedulePriorityNormal));
+        CHECK(thread_allocations == 0);
+    }
+    ScheduledTask full([&calls]() { calls++; });
+    CHECK(!lanes.PushFromISR(full, kSchedulePriorityNormal));
+    CHECK(full);
+
+    std::array<char, ScheduledTask::kInlineSize + 8> padding {};
+    ScheduledTask large([&calls, padding]() { calls += 1 + padding[0]; });
+    CHECK(large.heap_allocated());
+    CHECK(!lanes.PushFromISR(large, kSchedulePriorityHigh));
+    CHECK(large);
+    CHECK(lanes.isr_drops() == 2);
+
+    CHECK(!lanes.RunPending());
+    CHECK(sum == 0 + 1 + 2 + 3);
+    CHECK(calls == 0);
+    CHECK(lanes.PushFromISR(full, kSchedulePriorityNormal));
+    CHECK(!lanes.RunPending());
+    CHECK(calls == 1);
+}
+
+// 任务线程（可能溢出）与"ISR"线程（失败重试）同时投递两条通道，消费者检查每个生产者在各自通道内的顺序
+static void TestConcurrentLanes() {
+    const int producers = 4;
+    const int per_producer = 5000;
+    ScheduleLanes<16> lanes;
+    std::vector<int> last(producers, -1);
+    std::atomic<int> executed {0};
+    std::atomic<int> done {0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            auto priority = p % 2 ? kSchedulePriorityHigh : kSchedulePriorityNormal;
+            for (int i = 0; i < per_producer; i++) {
+                ScheduledTask task([&last, &executed, p, i]() {
+                    CHECK(last[p] < i);
+                    last[p] = i;
+                    executed++;
+                });
+                if (p < 2) {
+                    lanes.Push(std::move(task), priority);
+                } else {
+                    while (!lanes.PushFromISR(task, priority)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            done++;
+        });
+    }
+    while (done < producers) {
+        if (!lanes.RunPending()) {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    while (lanes.RunPending()) {
+    }
+    lanes.RunPending();
+    CHECK(executed == producers * per_producer);
+    for (int p = 0; p < producers; p++) {
+        CHECK(last[p] == per_producer - 1);
+    }
+}
+
+int main() {
+    TestInlineAndHeap();
+    TestFull();
+    TestConcurrentProducers();
+    TestLanePriority();
+    TestNormalBudget();
+    TestOverflowOrder();
+    TestPushFromISR();
+    TestConcurrentLanes();
+    printf("schedule_queue_test passed\n");
+    return 0;
+}
@@ -0,0 +1,698 @@
+// 主机测试用的 cJSON 替身，行为对齐 cJSON 1.7：对象按插入顺序保存，查找键不区分大小写，
+// 数字按 %1.15g / %1.17g 输出，字符串转义规则相同；所有分配都经过 cJSON_InitHooks 设置的钩子
+#include "cJSON.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static cJSON_Hooks hooks = {malloc, free};
+
+void cJSON_InitHooks(cJSON_Hooks* new_hooks) {
+    if (new_hooks == NULL) {
+        hooks.malloc_fn = malloc;
+        hooks.free_fn = free;
+        return;
+    }
+    hooks.malloc_fn = new_hooks->malloc_fn != NULL ? new_hooks->malloc_fn : malloc;
+    hooks.free_fn = new_hooks->free_fn != NULL ? new_hooks->free_fn : free;
+}
+
+void* cJSON_malloc(size_t size) {
+    return hooks.malloc_fn(size);
+}
+
+void cJSON_free(void* object) {
+    hooks.free_fn(object);
+}
+
+static cJSON* NewItem(void) {
+    cJSON* item = (cJSON*)hooks.malloc_fn(sizeof(cJSON));
+    if (item != NULL) {
+        memset(item, 0, sizeof(cJSON));
+    }
+    return item;
+}
+
+static char* Strdup(const char* string) {
+    size_t length = strlen(string) + 1;
+    char* copy = (char*)hooks.malloc_fn(length);
+    if (copy != NULL) {
+        memcpy(copy, string, length);
+    }
+    return copy;
+}
+
+void cJSON_Delete(cJSON* item) {
+    while (item != NULL) {
+        cJSON* next = item->next;
+        if (!(item->type & cJSON_IsReference) && item->child != NULL) {
+            cJSON_Delete(item->child);
+        }
+        if (!(item->type & cJSON_IsReference) && item->valuestring != NULL) {
+            hooks.free_fn(item->valuestring);
+        }
+        if (!(item->type & cJSON_StringIsConst) && item->string != NULL) {
+            hooks.free_fn(item->string);
+        }
+        hooks.free_fn(item);
+        item = next;
+    }
+}
+
+// ---- 解析 ----
+
+typedef struct {
+    const char* content;
+    size_t length;
+    size_t offset;
+} ParseBuffer;
+
+static int CanRead(const ParseBuffer* buffer, size_t size) {
+    return buffer->offset + size <= buffer->length;
+}
+
+static const char* Current(const ParseBuffer* buffer) {
+    return buffer->content + buffer->offset;
+}
+
+static void SkipSpace(ParseBuffer* buffer) {
+    while (CanRead(buffer, 1) && (unsigned char)*Current(buffer) <= 32) {
+        buffer->offset++;
+    }
+}
+
+static int ParseValue(cJSON* item, ParseBuffer* buffer);
+
+static int ParseHex4(const char* input, unsigned* value) {
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = input[i];
+        *value <<= 4;
+        if (c >= '0' && c <= '9') {
+            *value |= (unsigned)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            *value |= (unsigned)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            *value |= (unsigned)(c - 'A' + 10);
+        } else {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static size_t EncodeUtf8(unsigned codepoint, char* output) {
+    if (codepoint < 0x80) {
+        output[0] = (char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        output[0] = (char)(0xC0 | (codepoint >> 6));
+        output[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        output[0] = (char)(0xE0 | (codepoint >> 12));
+        output[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        output[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    output[0] = (char)(0xF0 | (codepoint >> 18));
+    output[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    output[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    output[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+// 解析带引号的字符串，返回新分配的反转义结果
+static char* ParseStringValue(ParseBuffer* buffer) {
+    if (!CanRead(buffer, 1) || *Current(buffer) != '"') {
+        return NULL;
+    }
+    size_t start = buffer->offset + 1;
+    size_t end = start;
+    while (end < buffer->length && buffer->content[end] != '"') {
+        if (buffer->content[end] == '\\') {
+            end++;
+        }
+        end++;
+    }
+    if (end >= buffer->length) {
+        return NULL;
+    }
+
+    // 反转义后不会变长
+    char* output = (char*)hooks.malloc_fn(end - start + 1);
+    if (output == NULL) {
+        return NULL;
+    }
+    char* out = output;
+    const char* p = buffer->content + start;
+    const char* limit = buffer->content + end;
+    while (p < limit) {
+        if (*p != '\\') {
+            *out++ = *p++;
+            continue;
+        }
+        p++;
+        switch (*p) {
+        case 'b': *out++ = '\b'; p++; break;
+        case 'f': *out++ = '\f'; p++; break;
+        case 'n': *out++ = '\n'; p++; break;
+        case 'r': *out++ = '\r'; p++; break;
+        case 't': *out++ = '\t'; p++; break;
+        case '"':
+        case '\\':
+        case '/':
+            *out++ = *p++;
+            break;
+        case 'u': {
+            unsigned codepoint;
+            if (limit - p < 5 || !ParseHex4(p + 1, &codepoint)) {
+                goto fail;
+            }
+            p += 5;
+            if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+                goto fail;
+            }
+            if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                unsigned low;
+                if (limit - p < 6 || p[0] != '\\' || p[1] != 'u' || !ParseHex4(p + 2, &low) ||
+                    low < 0xDC00 || low > 0xDFFF) {
+                    goto fail;
+                }
+                p += 6;
+                codepoint = 0x10000 + (((codepoint & 0x3FF) << 10) | (low & 0x3FF));
+            }
+            out += EncodeUtf8(codepoint, out);
+            break;
+        }
+        default:
+            goto fail;
+        }
+    }
+    *out = '\0';
+    buffer->offset = end + 1;
+    return output;
+
+fail:
+    hooks.free_fn(output);
+    return NULL;
+}
+
+static int ParseNumber(cJSON* item, ParseBuffer* buffer) {
+    char number[64];
+    size_t length = 0;
+    while (CanRead(buffer, length + 1) && length + 1 < sizeof(number)) {
+        char c = buffer->content[buffer->offset + length];
+        if (!(isdigit((unsigned char)c) || c == '+' || c == '-' || c == 'e' || c == 'E' || c == '.')) {
+            break;
+        }
+        number[length++] = c;
+    }
+    number[length] = '\0';
+    char* end = NULL;
+    double value = strtod(number, &end);
+    if (end == number) {
+        return 0;
+    }
+    item->type = cJSON_Number;
+    item->valuedouble = value;
+    if (value >= 2147483647.0) {
+        item->valueint = 2147483647;
+    } else if (value <= -2147483648.0) {
+        item->valueint = -2147483647 - 1;
+    } else {
+        item->valueint = (int)value;
+    }
+    buffer->offset += (size_t)(end - number);
+    return 1;
+}
+
+static int ParseArray(cJSON* item, ParseBuffer* buffer) {
+    cJSON* tail = NULL;
+    buffer->offset++;
+    SkipSpace(buffer);
+    item->type = cJSON_Array;
+    if (CanRead(buffer, 1) && *Current(buffer) == ']') {
+        buffer->offset++;
+        return 1;
+    }
+    while (1) {
+        cJSON* child = NewItem();
+        if (child == NULL) {
+            return 0;
+        }
+        if (tail == NULL) {
+            item->child = child;
+        } else {
+            tail->next = child;
+            child->prev = tail;
+        }
+        tail = child;
+        item->child->prev = tail;
+
+        SkipSpace(buffer);
+        if (!ParseValue(child, buffer)) {
+            return 0;
+        }
+        SkipSpace(buffer);
+        if (!CanRead(buffer, 1)) {
+            return 0;
+        }
+        if (*Current(buffer) == ',') {
+            buffer->offset++;
+            continue;
+        }
+        if (*Current(buffer) == ']') {
+            buffer->offset++;
+            return 1;
+        }
+        return 0;
+    }
+}
+
+static int ParseObject(cJSON* item, ParseBuffer* buffer) {
+    cJSON* tail = NULL;
+    buffer->offset++;
+    SkipSpace(buffer);
+    item->type = cJSON_Object;
+    if (CanRead(buffer, 1) && *Current(buffer) == '}') {
+        buffer->offset++;
+        return 1;
+    }
+    while (1) {
+        cJSON* child = NewItem();
+        if (child == NULL) {
+            return 0;
+        }
+        if (tail == NULL) {
+            item->child = child;
+        } else {
+            tail->next = child;
+            child->prev = tail;
+        }
+        tail = child;
+        item->child->prev = tail;
+
+        SkipSpace(buffer);
+        child->string = ParseStringValue(buffer);
+        if (child->string == NULL) {
+            return 0;
+        }
+        SkipSpace(buffer);
+        if (!CanRead(buffer, 1) || *Current(buffer) != ':') {
+            return 0;
+        }
+        buffer->offset++;
+        SkipSpace(buffer);
+        if (!ParseValue(child, buffer)) {
+            return 0;
+        }
+        SkipSpace(buffer);
+        if (!CanRead(buffer, 1)) {
+            return 0;
+        }
+        if (*Current(buffer) == ',') {
+            buffer->offset++;
+            continue;
+        }
+        if (*Current(buffer) == '}') {
+            buffer->offset++;
+            return 1;
+        }
+        return 0;
+    }
+}
+
+static int ParseValue(cJSON* item, ParseBuffer* buffer) {
+    if (!CanRead(buffer, 1)) {
+        return 0;
+    }
+    const char* p = Current(buffer);
+    size_t remaining = buffer->length - buffer->offset;
+    if (remaining >= 4 && strncmp(p, "null", 4) == 0) {
+        item->type = cJSON_NULL;
+        buffer->offset += 4;
+        return 1;
+    }
+    if (remaining >= 5 && strncmp(p, "false", 5) == 0) {
+        item->type = cJSON_False;
+        buffer->offset += 5;
+        return 1;
+    }
+    if (remaining >= 4 && strncmp(p, "true", 4) == 0) {
+        item->type = cJSON_True;
+        item->valueint = 1;
+        buffer->offset += 4;
+        return 1;
+    }
+    if (*p == '"') {
+        item->valuestring = ParseStringValue(buffer);
+        if (item->valuestring == NULL) {
+            return 0;
+        }
+        item->type = cJSON_String;
+        return 1;
+    }
+    if (*p == '-' || isdigit((unsigned char)*p)) {
+        return ParseNumber(item, buffer);
+    }
+    if (*p == '[') {
+        return ParseArray(item, buffer);
+    }
+    if (*p == '{') {
+        return ParseObject(item, buffer);
+    }
+    return 0;
+}
+
+cJSON* cJSON_ParseWithLength(const char* value, size_t buffer_length) {
+    if (value == NULL || buffer_length == 0) {
+        return NULL;
+    }
+    ParseBuffer buffer = {value, buffer_length, 0};
+    cJSON* item = NewItem();
+    if (item == NULL) {
+        return NULL;
+    }
+    SkipSpace(&buffer);
+    if (!ParseValue(item, &buffer)) {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    return item;
+}
+
+cJSON* cJSON_Parse(const char* value) {
+    if (value == NULL) {
+        return NULL;
+    }
+    return cJSON_ParseWithLength(value, strlen(value) + 1);
+}
+
+// ---- 输出 ----
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} PrintBuffer;
+
+static int Reserve(PrintBuffer* buffer, size_t size) {
+    if (buffer->length + size + 1 <= buffer->capacity) {
+        return 1;
+    }
+    size_t capacity = buffer->capacity * 2;
+    while (capacity < buffer->length + size + 1) {
+        capacity *= 2;
+    }
+    char* data = (char*)hooks.malloc_fn(capacity);
+    if (data == NULL) {
+        return 0;
+    }
+    memcpy(data, buffer->data, buffer->length);
+    hooks.free_fn(buffer->data);
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+static int Append(PrintBuffer* buffer, const char* data, size_t length) {
+    if (!Reserve(buffer, length)) {
+        return 0;
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    return 1;
+}
+
+static int PrintString(PrintBuffer* buffer, const char* string) {
+    if (string == NULL) {
+        return Append(buffer, "\"\"", 2);
+    }
+    if (!Append(buffer, "\"", 1)) {
+        return 0;
+    }
+    for (const unsigned char* p = (const unsigned char*)string; *p != '\0'; p++) {
+        char escaped[8];
+        size_t length = 2;
+        escaped[0] = '\\';
+        switch (*p) {
+        case '"': escaped[1] = '"'; break;
+        case '\\': escaped[1] = '\\'; break;
+        case '\b': escaped[1] = 'b'; break;
+        case '\f': escaped[1] = 'f'; break;
+        case '\n': escaped[1] = 'n'; break;
+        case '\r': escaped[1] = 'r'; break;
+        case '\t': escaped[1] = 't'; break;
+        default:
+            if (*p < 32) {
+                snprintf(escaped, sizeof(escaped), "\\u%04x", *p);
+                length = 6;
+            } else {
+                escaped[0] = (char)*p;
+                length = 1;
+            }
+            break;
+        }
+        if (!Append(buffer, escaped, length)) {
+            return 0;
+        }
+    }
+    return Append(buffer, "\"", 1);
+}
+
+static int PrintNumber(PrintBuffer* buffer, double value) {
+    char number[32];
+    int length;
+    if (isnan(value) || isinf(value)) {
+        length = snprintf(number, sizeof(number), "null");
+    } else if (value == (double)(int)value) {
+        length = snprintf(number, sizeof(number), "%d", (int)value);
+    } else {
+        length = snprintf(number, sizeof(number), "%1.15g", value);
+        double check;
+        if (sscanf(number, "%lg", &check) != 1 || check != value) {
+            length = snprintf(number, sizeof(number), "%1.17g", value);
+        }
+    }
+    return Append(buffer, number, (size_t)length);
+}
+
+static int PrintValue(PrintBuffer* buffer, const cJSON* item) {
+    switch (item->type & 0xFF) {
+    case cJSON_NULL:
+        return Append(buffer, "null", 4);
+    case cJSON_False:
+        return Append(buffer, "false", 5);
+    case cJSON_True:
+        return Append(buffer, "true", 4);
+    case cJSON_Number:
+        return PrintNumber(buffer, item->valuedouble);
+    case cJSON_Raw:
+        return item->valuestring != NULL && Append(buffer, item->valuestring, strlen(item->valuestring));
+    case cJSON_String:
+        return PrintString(buffer, item->valuestring);
+    case cJSON_Array:
+    case cJSON_Object: {
+        int object = (item->type & 0xFF) == cJSON_Object;
+        if (!Append(buffer, object ? "{" : "[", 1)) {
+            return 0;
+        }
+        for (const cJSON* child = item->child; child != NULL; child = child->next) {
+            if (object && (!PrintString(buffer, child->string) || !Append(buffer, ":", 1))) {
+                return 0;
+            }
+            if (!PrintValue(buffer, child)) {
+                return 0;
+            }
+            if (child->next != NULL && !Append(buffer, ",", 1)) {
+                return 0;
+            }
+        }
+        return Append(buffer, object ? "}" : "]", 1);
+    }
+    default:
+        return 0;
+    }
+}
+
+char* cJSON_PrintUnformatted(const cJSON* item) {
+    if (item == NULL) {
+        return NULL;
+    }
+    PrintBuffer buffer = {(char*)hooks.malloc_fn(256), 0, 256};
+    if (buffer.data == NULL) {
+        return NULL;
+    }
+    if (!PrintValue(&buffer, item)) {
+        hooks.free_fn(buffer.data);
+        return NULL;
+    }
+    buffer.data[buffer.length] = '\0';
+    return buffer.data;
+}
+
+// ---- 查询 ----
+
+int cJSON_GetArraySize(const cJSON* array) {
+    int size = 0;
+    if (array == NULL) {
+        return 0;
+    }
+    for (const cJSON* child = array->child; child != NULL; child = child->next) {
+        size++;
+    }
+    return size;
+}
+
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index) {
+    if (array == NULL || index < 0) {
+        return NULL;
+    }
+    cJSON* child = array->child;
+    while (child != NULL && index > 0) {
+        child = child->next;
+        index--;
+    }
+    return child;
+}
+
+static int CaseInsensitiveEqual(const char* a, const char* b) {
+    for (; tolower((unsigned char)*a) == tolower((unsigned char)*b); a++, b++) {
+        if (*a == '\0') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* string) {
+    if (object == NULL || string == NULL) {
+        return NULL;
+    }
+    for (cJSON* child = object->child; child != NULL; child = child->next) {
+        if (child->string != NULL && CaseInsensitiveEqual(child->string, string)) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+cJSON* cJSON_GetObjectItemCaseSensitive(const cJSON* object, const char* string) {
+    if (object == NULL || string == NULL) {
+        return NULL;
+    }
+    for (cJSON* child = object->child; child != NULL; child = child->next) {
+        if (child->string != NULL && strcmp(child->string, string) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+char* cJSON_GetStringValue(const cJSON* item) {
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+cJSON_bool cJSON_IsInvalid(const cJSON* item) { return item != NULL && (item->type & 0xFF) == cJSON_Invalid; }
+cJSON_bool cJSON_IsFalse(const cJSON* item) { return item != NULL && (item->type & 0xFF) == cJSON_False; }
+cJSON_bool cJSON_IsTrue(const cJSON* item) { return item != NULL && (item->type & 0xFF) == cJSON_True; }
+cJSON_bool cJSON_IsBool(const cJSON* item) { return item != NULL && (item->type & (cJSON_True | cJSON_False)) != 0; }
+cJSON_bool cJSON_IsNull(const cJSON* item) { return item != NULL && (item->type & 0xFF) == cJSON_NULL; }
+cJSON_bool cJSON_IsNumber(const cJSON* item) { return item != NULL && (item->type & 0xFF) == cJSON_Number; }
+cJSON_bool cJSON_IsString(const cJSON* item) { return item != NULL && (item->type & 0xFF) == cJSON_String; }
+cJSON_bool cJSON_IsArray(const cJSON* item) { return item != NULL && (item->type & 0xFF) == cJSON_Array; }
+cJSON_bool cJSON_IsObject(const cJSON* item) { return item != NULL && (item->type & 0xFF) == cJSON_Object; }
+
+// ---- 构造 ----
+
+static cJSON* CreateWithType(int type) {
+    cJSON* item = NewItem();
+    if (item != NULL) {
+        item->type = type;
+    }
+    return item;
+}
+
+cJSON* cJSON_CreateNull(void) { return CreateWithType(cJSON_NULL); }
+cJSON* cJSON_CreateTrue(void) { return CreateWithType(cJSON_True); }
+cJSON* cJSON_CreateFalse(void) { return CreateWithType(cJSON_False); }
+cJSON* cJSON_CreateBool(cJSON_bool boolean) { return CreateWithType(boolean ? cJSON_True : cJSON_False); }
+cJSON* cJSON_CreateArray(void) { return CreateWithType(cJSON_Array); }
+cJSON* cJSON_CreateObject(void) { return CreateWithType(cJSON_Object); }
+
+cJSON* cJSON_CreateNumber(double num) {
+    cJSON* item = CreateWithType(cJSON_Number);
+    if (item != NULL) {
+        item->valuedouble = num;
+        item->valueint = num >= 2147483647.0 ? 2147483647 : num <= -2147483648.0 ? -2147483647 - 1 : (int)num;
+    }
+    return item;
+}
+
+cJSON* cJSON_CreateString(const char* string) {
+    cJSON* item = CreateWithType(cJSON_String);
+    if (item != NULL) {
+        item->valuestring = Strdup(string);
+        if (item->valuestring == NULL) {
+            cJSON_Delete(item);
+            return NULL;
+        }
+    }
+    return item;
+}
+
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item) {
+    if (array == NULL || item == NULL || array == item) {
+        return 0;
+    }
+    cJSON* child = array->child;
+    if (child == NULL) {
+        array->child = item;
+        item->prev = item;
+        item->next = NULL;
+    } else {
+        // 与 cJSON 相同，头节点的 prev 指向尾节点
+        cJSON* tail = child->prev;
+        tail->next = item;
+        item->prev = tail;
+        child->prev = item;
+    }
+    return 1;
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item) {
+    if (object == NULL || string == NULL || item == NULL || object == item) {
+        return 0;
+    }
+    char* key = Strdup(string);
+    if (key == NULL) {
+        return 0;
+    }
+    if (!(item->type & cJSON_StringIsConst) && item->string != NULL) {
+        hooks.free_fn(item->string);
+    }
+    item->string = key;
+    item->type &= ~cJSON_StringIsConst;
+    return cJSON_AddItemToArray(object, item);
+}
+
+static cJSON* AddToObject(cJSON* object, const char* name, cJSON* item) {
+    if (cJSON_AddItemToObject(object, name, item)) {
+        return item;
+    }
+    cJSON_Delete(item);
+    return NULL;
+}
+
+cJSON* cJSON_AddNullToObject(cJSON* object, const char* name) { return AddToObject(object, name, cJSON_CreateNull()); }
+cJSON* cJSON_AddBoolToObject(cJSON* object, const char* name, cJSON_bool boolean) { return AddToObject(object, name, cJSON_CreateBool(boolean)); }
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number) { return AddToObject(object, name, cJSON_CreateNumber(number)); }
+cJSON* cJSON_AddStringToObject(cJSON* object, const char* name, const char* string) { return AddToObject(object, name, cJSON_CreateString(string)); }
+cJSON* cJSON_AddObjectToObject(cJSON* object, const char* name) { return AddToObject(object, name, cJSON_CreateObject()); }
+cJSON* cJSON_AddArrayToObject(cJSON* object, const char* name) { return AddToObject(object, name, cJSON_CreateArray()); }
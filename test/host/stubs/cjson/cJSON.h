@@ -0,0 +1,94 @@
+#ifndef HOST_STUB_CJSON_H
+#define HOST_STUB_CJSON_H
+
+// 没有 ESP-IDF 时的 cJSON 替身（cJSON.c），只实现主机测试用到的子集
+// 结构体布局、类型位和函数签名与 ESP-IDF 自带的 cJSON 1.7 一致，内存分配同样经过 cJSON_InitHooks
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define cJSON_Invalid (0)
+#define cJSON_False  (1 << 0)
+#define cJSON_True   (1 << 1)
+#define cJSON_NULL   (1 << 2)
+#define cJSON_Number (1 << 3)
+#define cJSON_String (1 << 4)
+#define cJSON_Array  (1 << 5)
+#define cJSON_Object (1 << 6)
+#define cJSON_Raw    (1 << 7)
+
+#define cJSON_IsReference 256
+#define cJSON_StringIsConst 512
+
+typedef int cJSON_bool;
+
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* prev;
+    struct cJSON* child;
+    int type;
+    char* valuestring;
+    int valueint;
+    double valuedouble;
+    char* string;
+} cJSON;
+
+typedef struct cJSON_Hooks {
+    void* (*malloc_fn)(size_t sz);
+    void (*free_fn)(void* ptr);
+} cJSON_Hooks;
+
+void cJSON_InitHooks(cJSON_Hooks* hooks);
+
+cJSON* cJSON_Parse(const char* value);
+cJSON* cJSON_ParseWithLength(const char* value, size_t buffer_length);
+char* cJSON_PrintUnformatted(const cJSON* item);
+void cJSON_Delete(cJSON* item);
+
+int cJSON_GetArraySize(const cJSON* array);
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index);
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* string);
+cJSON* cJSON_GetObjectItemCaseSensitive(const cJSON* object, const char* string);
+char* cJSON_GetStringValue(const cJSON* item);
+
+cJSON_bool cJSON_IsInvalid(const cJSON* item);
+cJSON_bool cJSON_IsFalse(const cJSON* item);
+cJSON_bool cJSON_IsTrue(const cJSON* item);
+cJSON_bool cJSON_IsBool(const cJSON* item);
+cJSON_bool cJSON_IsNull(const cJSON* item);
+cJSON_bool cJSON_IsNumber(const cJSON* item);
+cJSON_bool cJSON_IsString(const cJSON* item);
+cJSON_bool cJSON_IsArray(const cJSON* item);
+cJSON_bool cJSON_IsObject(const cJSON* item);
+
+cJSON* cJSON_CreateNull(void);
+cJSON* cJSON_CreateTrue(void);
+cJSON* cJSON_CreateFalse(void);
+cJSON* cJSON_CreateBool(cJSON_bool boolean);
+cJSON* cJSON_CreateNumber(double num);
+cJSON* cJSON_CreateString(const char* string);
+cJSON* cJSON_CreateArray(void);
+cJSON* cJSON_CreateObject(void);
+
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item);
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item);
+cJSON* cJSON_AddNullToObject(cJSON* object, const char* name);
+cJSON* cJSON_AddBoolToObject(cJSON* object, const char* name, cJSON_bool boolean);
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number);
+cJSON* cJSON_AddStringToObject(cJSON* object, const char* name, const char* string);
+cJSON* cJSON_AddObjectToObject(cJSON* object, const char* name);
+cJSON* cJSON_AddArrayToObject(cJSON* object, const char* name);
+
+void* cJSON_malloc(size_t size);
+void cJSON_free(void* object);
+
+#define cJSON_ArrayForEach(element, array) \
+    for (element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_STUB_CJSON_H
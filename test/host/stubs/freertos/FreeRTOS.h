@@ -0,0 +1,23 @@
+#ifndef HOST_STUB_FREERTOS_H
+#define HOST_STUB_FREERTOS_H
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// 主机上没有中断上下文
+inline BaseType_t xPortInIsrContext() {
+    return pdFALSE;
+}
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+#endif // HOST_STUB_FREERTOS_H
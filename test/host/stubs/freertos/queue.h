@@ -0,0 +1,63 @@
+#ifndef HOST_STUB_FREERTOS_QUEUE_H
+#define HOST_STUB_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// 定长元素的阻塞队列，按值拷贝，与 FreeRTOS 队列语义一致；不支持删除
+struct HostQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+};
+typedef HostQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    auto queue = new HostQueue;
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->items.size() >= queue->length) {
+        return pdFALSE;
+    }
+    auto bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    queue->cv.notify_one();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higher_priority_task_woken) {
+    return xQueueSend(queue, item, 0);
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    auto ready = [queue]() { return !queue->items.empty(); };
+    if (ticks_to_wait == portMAX_DELAY) {
+        queue->cv.wait(lock, ready);
+    } else if (!queue->cv.wait_for(lock, std::chrono::milliseconds(ticks_to_wait), ready)) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+#endif // HOST_STUB_FREERTOS_QUEUE_H
@@ -0,0 +1,40 @@
+#ifndef HOST_STUB_FREERTOS_TASK_H
+#define HOST_STUB_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#include <atomic>
+#include <thread>
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+// 每个主机线程一个任务句柄
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    static thread_local char task_tag;
+    return &task_tag;
+}
+
+// 置为 true 时 xTaskCreate 失败，用于测试创建任务失败的路径
+inline std::atomic<bool> host_task_create_fail {false};
+
+// 任务以分离的线程运行，任务函数返回即视为删除
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* parameters,
+    UBaseType_t priority, TaskHandle_t* created_task) {
+    if (host_task_create_fail.load()) {
+        return pdFAIL;
+    }
+    std::thread(function, parameters).detach();
+    if (created_task != nullptr) {
+        *created_task = nullptr;
+    }
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t task) {}
+
+inline UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    return 1;
+}
+
+#endif // HOST_STUB_FREERTOS_TASK_H
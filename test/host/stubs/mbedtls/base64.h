@@ -0,0 +1,31 @@
+#ifndef HOST_STUB_MBEDTLS_BASE64_H
+#define HOST_STUB_MBEDTLS_BASE64_H
+
+#include <cstddef>
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL -0x002A
+
+// 与 mbedtls 相同的语义：dlen 不足时返回错误并在 olen 写入所需长度，成功时在末尾写 '\0'
+inline int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t needed = (slen + 2) / 3 * 4 + 1;
+    if (dst == nullptr || dlen < needed) {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    size_t o = 0;
+    for (size_t i = 0; i < slen; i += 3) {
+        unsigned int v = src[i] << 16;
+        if (i + 1 < slen) v |= src[i + 1] << 8;
+        if (i + 2 < slen) v |= src[i + 2];
+        dst[o++] = table[(v >> 18) & 63];
+        dst[o++] = table[(v >> 12) & 63];
+        dst[o++] = i + 1 < slen ? table[(v >> 6) & 63] : '=';
+        dst[o++] = i + 2 < slen ? table[v & 63] : '=';
+    }
+    dst[o] = '\0';
+    *olen = o;
+    return 0;
+}
+
+#endif // HOST_STUB_MBEDTLS_BASE64_H
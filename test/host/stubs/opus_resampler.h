@@ -0,0 +1,34 @@
+#ifndef HOST_STUB_OPUS_RESAMPLER_H
+#define HOST_STUB_OPUS_RESAMPLER_H
+
+#include <cstdint>
+
+// 与 esp-opus-encoder 的 OpusResampler 接口一致的线性插值重采样，用于主机测试
+class OpusResampler {
+public:
+    void Configure(int input_sample_rate, int output_sample_rate) {
+        input_sample_rate_ = input_sample_rate;
+        output_sample_rate_ = output_sample_rate;
+    }
+
+    int GetOutputSamples(int input_samples) const {
+        return (int)((int64_t)input_samples * output_sample_rate_ / input_sample_rate_);
+    }
+
+    void Process(const int16_t* input, int input_samples, int16_t* output) {
+        int output_samples = GetOutputSamples(input_samples);
+        for (int i = 0; i < output_samples; i++) {
+            int64_t position = (int64_t)i * input_sample_rate_;
+            int index = (int)(position / output_sample_rate_);
+            int fraction = (int)(position % output_sample_rate_);
+            int next = index + 1 < input_samples ? index + 1 : index;
+            output[i] = (int16_t)(input[index] + (int64_t)(input[next] - input[index]) * fraction / output_sample_rate_);
+        }
+    }
+
+private:
+    int input_sample_rate_ = 16000;
+    int output_sample_rate_ = 16000;
+};
+
+#endif // HOST_STUB_OPUS_RESAMPLER_H
@@ -0,0 +1,196 @@
+#include "udp_audio_packet.h"
+#include "host_test.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// 主机上没有 mbedtls，用同样按 16 字节块推进、计数器大端递增的 CTR 替身，
+// 只衡量缓冲区复用本身；设备上 AES 的耗时两条路径相同
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static void KeystreamBlock(const uint8_t counter[16], uint8_t block[16]) {
+    uint32_t x = 0x9e3779b9;
+    for (int i = 0; i < 16; i++) {
+        x = (x ^ counter[i]) * 0x01000193;
+        block[i] = (uint8_t)(x >> 24);
+    }
+}
+
+static int FakeCryptCtr(size_t length, uint8_t* nonce_counter, const uint8_t* input, uint8_t* output) {
+    uint8_t block[16];
+    for (size_t i = 0; i < length; i++) {
+        if (i % 16 == 0) {
+            KeystreamBlock(nonce_counter, block);
+            for (int j = 15; j >= 0 && ++nonce_counter[j] == 0; j--) {
+            }
+        }
+        output[i] = input[i] ^ block[i % 16];
+    }
+    return 0;
+}
+
+static std::string MakeNonce() {
+    std::string nonce(UDP_AUDIO_PACKET_HEADER_SIZE, '\0');
+    nonce[0] = 0x01;
+    for (int i = 4; i < 8; i++) {
+        nonce[i] = (char)(0xa0 + i);  // ssrc
+    }
+    return nonce;
+}
+
+static std::vector<uint8_t> MakePayload(size_t size, int seed) {
+    std::vector<uint8_t> payload(size);
+    for (size_t i = 0; i < size; i++) {
+        payload[i] = (uint8_t)(i * 31 + seed);
+    }
+    return payload;
+}
+
+// 改动前 MqttProtocol::SendAudio 的写法：每包复制一次 nonce、新建一个密文 string
+static bool PackLegacy(std::string& out, const std::string& aes_nonce, const std::vector<uint8_t>& payload,
+    uint32_t timestamp, uint32_t sequence) {
+    std::string nonce(aes_nonce);
+    uint16_t payload_size = htons(payload.size());
+    uint32_t timestamp_be = htonl(timestamp);
+    uint32_t sequence_be = htonl(sequence);
+    memcpy(&nonce[2], &payload_size, sizeof(payload_size));
+    memcpy(&nonce[8], &timestamp_be, sizeof(timestamp_be));
+    memcpy(&nonce[12], &sequence_be, sizeof(sequence_be));
+
+    std::string encrypted;
+    encrypted.resize(aes_nonce.size() + payload.size());
+    memcpy(encrypted.data(), nonce.data(), nonce.size());
+    if (FakeCryptCtr(payload.size(), (uint8_t*)nonce.data(), payload.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+        return false;
+    }
+    out = std::move(encrypted);
+    return true;
+}
+
+static void TestHeaderLayout() {
+    std::string nonce = MakeNonce();
+    auto payload = MakePayload(123, 5);
+    std::string buffer;
+    CHECK(PackUdpAudioPacket(buffer, nonce, payload, 0x11223344, 0x55667788, FakeCryptCtr));
+    CHECK(buffer.size() == UDP_AUDIO_PACKET_HEADER_SIZE + payload.size());
+
+    auto* p = (const uint8_t*)buffer.data();
+    CHECK(p[0] == 0x01);
+    CHECK(p[1] == 0x00);
+    CHECK(p[2] == 0x00 && p[3] == 123);
+    for (int i = 4; i < 8; i++) {
+        CHECK(p[i] == 0xa0 + i);
+    }
+    CHECK(p[8] == 0x11 && p[9] == 0x22 && p[10] == 0x33 && p[11] == 0x44);
+    CHECK(p[12] == 0x55 && p[13] == 0x66 && p[14] == 0x77 && p[15] == 0x88);
+
+    // 接收端用包头做 nonce 解密得到原文
+    uint8_t counter[UDP_AUDIO_PACKET_HEADER_SIZE];
+    memcpy(counter, p, sizeof(counter));
+    std::vector<uint8_t> decrypted(payload.size());
+    CHECK(FakeCryptCtr(payload.size(), counter, p + UDP_AUDIO_PACKET_HEADER_SIZE, decrypted.data()) == 0);
+    CHECK(decrypted == payload);
+
+    // 模板的 aes_nonce_ 不被改写
+    CHECK(nonce == MakeNonce());
+}
+
+// 复用缓冲和每包新建 string 的输出逐字节一致，包括包长变短/变长时
+static void TestMatchesLegacy() {
+    std::string nonce = MakeNonce();
+    std::string buffer;
+    std::string legacy;
+    const size_t sizes[] = {0, 1, 15, 16, 17, 60, 240, 33, 512, 7};
+    uint32_t sequence = 0;
+    for (size_t size : sizes) {
+        auto payload = MakePayload(size, (int)size);
+        sequence++;
+        CHECK(PackUdpAudioPacket(buffer, nonce, payload, sequence * 60, sequence, FakeCryptCtr));
+        CHECK(PackLegacy(legacy, nonce, payload, sequence * 60, sequence));
+        CHECK(buffer == legacy);
+    }
+}
+
+static void TestBadNonce() {
+    std::string buffer;
+    auto payload = MakePayload(10, 0);
+    CHECK(!PackUdpAudioPacket(buffer, std::string(8, '\0'), payload, 0, 1, FakeCryptCtr));
+    CHECK(!PackUdpAudioPacket(buffer, MakeNonce(), payload, 0, 1,
+        [](size_t, uint8_t*, const uint8_t*, uint8_t*) { return -1; }));
+}
+
+// 稳态（包长不超过已有容量）下不分配内存；旧写法每包两次
+static void TestNoSteadyStateAllocation() {
+    std::string nonce = MakeNonce();
+    auto payload = MakePayload(120, 1);
+    std::string buffer;
+    CHECK(PackUdpAudioPacket(buffer, nonce, payload, 0, 1, FakeCryptCtr));
+
+    size_t before = g_allocations;
+    for (uint32_t i = 0; i < 100; i++) {
+        CHECK(PackUdpAudioPacket(buffer, nonce, payload, i * 60, i + 2, FakeCryptCtr));
+    }
+    CHECK(g_allocations == before);
+
+    std::string legacy;
+    before = g_allocations;
+    for (uint32_t i = 0; i < 100; i++) {
+        CHECK(PackLegacy(legacy, nonce, payload, i * 60, i + 2));
+    }
+    size_t legacy_allocations = g_allocations - before;
+    printf("allocations per packet: reused 0, legacy %.1f\n", legacy_allocations / 100.0);
+    CHECK(legacy_allocations >= 100);
+}
+
+// 60ms Opus 帧约 120 字节；只打印结果，不做断言
+static void Benchmark() {
+    const int kPackets = 200000;
+    std::string nonce = MakeNonce();
+    auto payload = MakePayload(120, 3);
+    size_t checksum = 0;
+
+    std::string buffer;
+    int64_t start = HostTimeUs();
+    for (int i = 0; i < kPackets; i++) {
+        PackUdpAudioPacket(buffer, nonce, payload, i * 60, i, FakeCryptCtr);
+        checksum += (uint8_t)buffer.back();
+    }
+    int64_t reused_us = HostTimeUs() - start;
+
+    std::string legacy;
+    start = HostTimeUs();
+    for (int i = 0; i < kPackets; i++) {
+        PackLegacy(legacy, nonce, payload, i * 60, i);
+        checksum += (uint8_t)legacy.back();
+    }
+    int64_t legacy_us = HostTimeUs() - start;
+
+    printf("pack %d packets: reused %.1f ns/packet, legacy %.1f ns/packet (checksum %zu)\n", kPackets,
+        reused_us * 1000.0 / kPackets, legacy_us * 1000.0 / kPackets, checksum);
+}
+
+int main() {
+    TestHeaderLayout();
+    TestMatchesLegacy();
+    TestBadNonce();
+    TestNoSteadyStateAllocation();
+    Benchmark();
+    printf("udp_audio_packet_test passed\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "udp_reorder_window.h"
+#include "host_test.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using Window = UdpReorderWindow<uint32_t, 8>;
+
+struct Arrival {
+    uint32_t sequence;
+    int64_t arrival_ms;
+};
+
+// 回放一段到达记录，每个包到达后检查一次超时，返回输出的序号
+static std::vector<uint32_t> Replay(Window& window, const std::vector<Arrival>& trace) {
+    std::vector<uint32_t> output;
+    auto collect = [&output](uint32_t&& sequence) { output.push_back(sequence); };
+    for (auto& arrival : trace) {
+        uint32_t item = arrival.sequence;
+        window.Push(arrival.sequence, std::move(item), arrival.arrival_ms, collect);
+        window.Expire(arrival.arrival_ms, collect);
+    }
+    return output;
+}
+
+static void TestInOrder() {
+    Window window(80);
+    auto output = Replay(window, {{100, 0}, {101, 20}, {102, 40}, {103, 60}});
+    CHECK((output == std::vector<uint32_t> {100, 101, 102, 103}));
+    CHECK(window.buffered() == 0);
+    auto& stats = window.statistics();
+    CHECK(stats.received == 4 && stats.lost == 0 && stats.reordered == 0 && stats.late == 0 && stats.expired == 0);
+}
+
+static void TestSwapped() {
+    Window window(80);
+    auto output = Replay(window, {{1, 0}, {3, 20}, {2, 25}, {5, 40}, {4, 41}, {6, 60}});
+    CHECK((output == std::vector<uint32_t> {1, 2, 3, 4, 5, 6}));
+    CHECK(window.statistics().reordered == 2);
+    CHECK(window.statistics().lost == 0);
+}
+
+static void TestDuplicateAndLate() {
+    Window window(80);
+    // 3 在缓存中时重复到达；1 在已输出后重复到达
+    auto output = Replay(window, {{1, 0}, {3, 20}, {3, 21}, {2, 30}, {1, 31}, {4, 40}});
+    CHECK((output == std::vector<uint32_t> {1, 2, 3, 4}));
+    CHECK(window.statistics().late == 2);
+
+    // 缺口被窗口推进跳过之后，迟到的包直接丢弃
+    Window pushed(1000);
+    output = Replay(pushed, {{10, 0}, {12, 1}, {13, 2}, {14, 3}, {15, 4}, {16, 5}, {17, 6}, {18, 7}, {19, 8}, {11, 9}});
+    CHECK((output == std::vector<uint32_t> {10, 12, 13, 14, 15, 16, 17, 18, 19}));
+    CHECK(pushed.statistics().lost == 1);
+    CHECK(pushed.statistics().late == 1);
+}
+
+// 缺口之后的包最多等待 max_hold_ms，之后跳过缺口输出
+static void TestHoldExpiry() {
+    Window window(80);
+    std::vector<uint32_t> output;
+    auto collect = [&output](uint32_t&& sequence) { output.push_back(sequence); };
+    uint32_t item = 1;
+    window.Push(1, std::move(item), 0, collect);
+    item = 3;
+    window.Push(3, std::move(item), 10, collect);
+    item = 4;
+    window.Push(4, std::move(item), 30, collect);
+    CHECK((output == std::vector<uint32_t> {1}));
+    CHECK(window.Expire(50, collect) == 40);
+    CHECK(window.Expire(89, collect) == 1);
+    CHECK(window.Expire(90, collect) == -1);
+    CHECK((output == std::vector<uint32_t> {1, 3, 4}));
+    CHECK(window.statistics().expired == 1);
+    CHECK(window.statistics().lost == 1);
+    CHECK(window.Expire(200, collect) == -1);
+
+    // 超时之后才到的缺口包算迟到
+    item = 2;
+    window.Push(2, std::move(item), 100, collect);
+    CHECK(window.statistics().late == 1);
+    CHECK(output.size() == 3);
+}
+
+// 序号跨越 2^32 回绕时仍按序输出
+static void TestSequenceWraparound() {
+    Window window(80);
+    auto output = Replay(window, {{0xFFFFFFFE, 0}, {0, 20}, {0xFFFFFFFF, 21}, {2, 40}, {1, 41}, {3, 60}});
+    CHECK((output == std::vector<uint32_t> {0xFFFFFFFE, 0xFFFFFFFF, 0, 1, 2, 3}));
+    CHECK(window.statistics().reordered == 2);
+    CHECK(window.statistics().lost == 0);
+}
+
+// 序号大跳变时输出缓存并对齐到新序号，新序号之前的窗口位置等待超时后跳过
+static void TestSequenceJump() {
+    Window window(80);
+    auto output = Replay(window, {{1, 0}, {3, 1}, {1000, 2}, {1001, 3}});
+    CHECK((output == std::vector<uint32_t> {1, 3}));
+    CHECK(window.buffered() == 2);
+    window.Expire(82, [&output](uint32_t&& sequence) { output.push_back(sequence); });
+    CHECK((output == std::vector<uint32_t> {1, 3, 1000, 1001}));
+    CHECK(window.statistics().lost == 1 + (1000 - 4));
+
+    // Discard 之后重新对齐，统计保留
+    window.Discard();
+    output = Replay(window, {{50, 10}, {51, 11}});
+    CHECK((output == std::vector<uint32_t> {50, 51}));
+    CHECK(window.statistics().received == 6);
+}
+
+// 随机抖动、重复和丢包的长记录：输出严格递增且不重复，窗口内补上的包都被输出
+static void TestRandomTrace() {
+    std::mt19937 rng(20240701);
+    Window window(80);
+    std::vector<Arrival> trace;
+    uint32_t start = 0xFFFFF000;
+    for (uint32_t i = 0; i < 20000; i++) {
+        if (rng() % 50 == 0) {
+            continue;  // 丢包
+        }
+        int64_t send_ms = (int64_t)i * 20;
+        int64_t arrival_ms = send_ms + rng() % 60;
+        trace.push_back({start + i, arrival_ms});
+        if (rng() % 100 == 0) {
+            trace.push_back({start + i, arrival_ms + 5});  // 重复
+        }
+    }
+    std::stable_sort(trace.begin(), trace.end(), [](const Arrival& a, const Arrival& b) {
+        return a.arrival_ms < b.arrival_ms;
+    });
+
+    auto output = Replay(window, trace);
+    std::vector<uint32_t> tail;
+    window.Flush([&tail](uint32_t&& sequence) { tail.push_back(sequence); });
+    output.insert(output.end(), tail.begin(), tail.end());
+
+    for (size_t i = 1; i < output.size(); i++) {
+        CHECK((int32_t)(output[i] - output[i - 1]) > 0);
+    }
+    auto& stats = window.statistics();
+    CHECK(stats.received == trace.size());
+    CHECK(output.size() + stats.late == trace.size());
+    CHECK(stats.reordered > 0 && stats.lost > 0);
+    printf("random trace: %zu packets, output %zu, lost %u, reordered %u, late %u, expired %u\n",
+        trace.size(), output.size(), stats.lost, stats.reordered, stats.late, stats.expired);
+}
+
+static void TestJitter() {
+    UdpJitterEstimator jitter;
+    for (int i = 0; i < 100; i++) {
+        jitter.Update(i * 20, i * 20 + 5);
+    }
+    CHECK(jitter.jitter_ms() == 0);
+    for (int i = 100; i < 2000; i++) {
+        jitter.Update(i * 20, i * 20 + (i % 2 ? 10 : 0));
+    }
+    CHECK(jitter.jitter_ms() > 9 && jitter.jitter_ms() < 11);
+    jitter.Reset();
+    CHECK(jitter.jitter_ms() == 0);
+}
+
+int main() {
+    TestInOrder();
+    TestSwapped();
+    TestDuplicateAndLate();
+    TestHoldExpiry();
+    TestSequenceWraparound();
+    TestSequenceJump();
+    TestRandomTrace();
+    TestJitter();
+    printf("udp_reorder_window_test passed\n");
+    return 0;
+}